@@ -20,6 +20,7 @@
 
 #include "Reach/Data/FJCA/FJCA.h"
 #include "Reach/Data/Connector.h"
+#include "Reach/Data/DeviceMonitor.h"
 
 
 namespace Reach {
@@ -47,6 +48,12 @@ public:
 		std::size_t timeout = Reach::Data::SessionImpl::LOGIN_TIMEOUT_DEFAULT);
 		/// Creates a FJCA SessionImpl object and initializes it with the given connectionString.
 
+	static Reach::Data::DeviceMonitor& monitor();
+		/// Returns the monitor watching for FJCA devices.
+		/// The monitor is named after Connector::KEY and runs from
+		/// registerConnector() to unregisterConnector(), which must be
+		/// called before the library is unloaded.
+
 	static void registerConnector();
 		/// Registers the Connector under the Keyword Connector::KEY at the Poco::Data::SessionFactory.
 
@@ -24,6 +24,7 @@
 #include "Poco/SharedPtr.h"
 #include "Poco/Mutex.h"
 #include "Poco/SharedLibrary.h"
+#include <atomic>
 
 namespace Reach {
 namespace Data {
@@ -61,6 +62,11 @@ public:
 	bool isConnected();
 		/// Returns true if connected, false otherwise.
 
+	bool isAlive();
+		/// Returns true if connected and the key opened has not been
+		/// removed since, as reported by the connector's DeviceMonitor.
+		/// A key plugged in after the removal needs the session reopened.
+
 	void setConnectionTimeout(std::size_t timeout);
 		/// Sets the session connection timeout value.
 		/// Timeout value is in seconds.
@@ -104,10 +110,27 @@ public:
 
 	bool verifySignByP7(const std::string& textual, const std::string& signature);
 
+	BatchResults signBatchP1(const std::vector<std::string>& messages);
+		/// Checks the session once, then signs the messages
+		/// back to back.
+
+	BatchResults signBatchP7(const std::vector<std::string>& textuals, int mode);
+		/// Throws a Poco::NotImplementedException, like signByP7().
+
+	std::string signFile(const std::string& path);
+		/// Signs the file with FJCA_SignFile(), which hashes it
+		/// in the library and signs the digest on the key.
+
+	bool verifyFile(const std::string& base64, const std::string& path, const std::string& signature);
+		/// Verifies the signature with FJCA_VerifyFileSign().
+
 protected:
 	bool FJCA_initKey();
 	void setConnectionTimeout(const std::string& prop, const Poco::Any& value);
 	Poco::Any getConnectionTimeout(const std::string& prop);
+	void onDeviceDisconnected(const void* pSender, const std::string& name);
+		/// Forgets the login, the key has lost its authentication.
+		/// The session is not alive until it is reopened.
 	Poco::SharedLibrary sl;
 private:
 	enum certType { sign = 1, crypto };
@@ -120,6 +143,7 @@ private:
 	int			_current_signed_algorithm;
 	std::string _connectionString;
 	std::string _containerString;//uid
+	std::atomic<bool> _attached;
 	Poco::Mutex _mutex;
 
 };
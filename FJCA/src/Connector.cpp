@@ -14,6 +14,7 @@
 
 #include "Reach/Data/FJCA/Connector.h"
 #include "Reach/Data/FJCA/SessionImpl.h"
+#include "Reach/Data/FJCA/FJCA_FUN_GT_DLL.h"
 #include "Reach/Data/SessionFactory.h"
 #if defined(POCO_UNBUNDLED)
 #include <SoFProvider.h>
@@ -47,14 +48,27 @@ Poco::AutoPtr<Reach::Data::SessionImpl> Connector::createSession(const std::stri
 }
 
 
+Reach::Data::DeviceMonitor& Connector::monitor()
+{
+	static Reach::Data::DeviceMonitor dm(KEY, []() { return FJCA_IsUsbKeyConnected(); });
+	return dm;
+}
+
+
 void Connector::registerConnector()
 {
 	Reach::Data::SessionFactory::instance().add(new Connector());
+
+	// probing talks to the provider, so in queued mode it is queued
+	// with the operations on the default device; in direct mode, no
+	// worker is created and the monitor thread probes like any caller
+	monitor().start([]() { return Reach::Data::SessionFactory::instance().queuedWorker(KEY); });
 }
 
 
 void Connector::unregisterConnector()
 {
+	monitor().stop();
 	Reach::Data::SessionFactory::instance().remove(KEY);
 }
 
@@ -22,11 +22,13 @@
 #include "Poco/String.h"
 #include "Poco/Mutex.h"
 #include "Poco/Thread.h"
+#include "Poco/Delegate.h"
 #include "Poco/StreamCopier.h"
 #include "Poco/Base64Decoder.h"
 #include "Poco/Buffer.h"
 #include "GMCrypto.h"
 #include <cassert>
+#include <cstring>
 #include <cstdlib>
 #include <sstream>
 #include <string>
@@ -48,7 +50,8 @@ SessionImpl::SessionImpl(const std::string& connectionString, std::size_t loginT
 	_connected(false),
 	_random_size(0),
 	_connectionString(connectionString),
-	_containerString("fjca_Container")
+	_containerString("fjca_Container"),
+	_attached(false)
 {
 	sl.load("FJCA_FUN_GT_API.dll");
 
@@ -56,6 +59,8 @@ SessionImpl::SessionImpl(const std::string& connectionString, std::size_t loginT
 	setConnectionTimeout(loginTimeout);
 
 	addProperty("connectionTimeout", &SessionImpl::setConnectionTimeout, &SessionImpl::getConnectionTimeout);
+
+	Connector::monitor().deviceDisconnected += Poco::delegate(this, &SessionImpl::onDeviceDisconnected);
 }
 
 
@@ -63,6 +68,7 @@ SessionImpl::~SessionImpl()
 {
 	try
 	{
+		Connector::monitor().deviceDisconnected -= Poco::delegate(this, &SessionImpl::onDeviceDisconnected);
 		close();
 		sl.unload();
 	}
@@ -87,19 +93,17 @@ void SessionImpl::open(const std::string& connect)
 
 	try
 	{
-		int rc = 0;
-		size_t tout = getLoginTimeout();
-		Poco::Stopwatch sw; sw.start();
-		while (true)
+		int rc = FJCA_IsUsbKeyConnected();
+		if (!rc)
+		{
+			// no key plugged in, wait for the monitor to report one
+			long tout = static_cast<long>(1000 * getLoginTimeout());
+			rc = Connector::monitor().waitForDevice(tout);
+		}
+		if (!rc)
 		{
-			rc = FJCA_IsUsbKeyConnected();
-			if (rc) break;
-			if (sw.elapsedSeconds() >= tout)
-			{
-				close();
-				throw FJCAException(rc);
-			}
-			else Poco::Thread::sleep(10);
+			close();
+			throw FJCAException(rc);
 		}
 	} 
 	catch (FJCAException& ex)
@@ -108,6 +112,8 @@ void SessionImpl::open(const std::string& connect)
 	}
 
 	_connected = true;
+	_attached = true;
+	setLoggedIn(false);
 }
 
 
@@ -116,6 +122,7 @@ void SessionImpl::close()
 	FJCA_CloseKey();
 
 	_connected = false;
+	setLoggedIn(false);
 }
 
 
@@ -125,6 +132,19 @@ bool SessionImpl::isConnected()
 }
 
 
+bool SessionImpl::isAlive()
+{
+	return _connected && _attached && Connector::monitor().isPresent();
+}
+
+
+void SessionImpl::onDeviceDisconnected(const void* pSender, const std::string& name)
+{
+	_attached = false;
+	setLoggedIn(false);
+}
+
+
 void SessionImpl::setConnectionTimeout(std::size_t timeout)
 {
 	int tout = static_cast<int>(1000 * timeout);
@@ -155,7 +175,9 @@ bool SessionImpl::FJCA_initKey()
 
 bool SessionImpl::login(const std::string& passwd)
 {
-	return FJCA_OpenKeyWithPin(passwd.c_str());
+	bool rc = FJCA_OpenKeyWithPin(passwd.c_str());
+	setLoggedIn(rc);
+	return rc;
 }
 
 bool SessionImpl::changePW(const std::string& oldCode, const std::string& newCode)
@@ -292,4 +314,53 @@ bool SessionImpl::verifySignByP7(const std::string& textual, const std::string&
 	return false;
 }
 
+SessionImpl::BatchResults SessionImpl::signBatchP1(const std::vector<std::string>& messages)
+{
+	if (!_connected) throw NotConnectedException(connectionString());
+
+	// one signature buffer for the whole batch
+	Poco::Buffer<char> signature(4096);
+
+	BatchResults results(messages.size());
+	for (std::size_t i = 0; i < messages.size(); ++i)
+	{
+		BatchResult& result = results[i];
+		try
+		{
+			CancellationToken::checkCurrent();
+			std::memset(signature.begin(), 0, signature.size());
+			if (FJCA_SignData(const_cast<char*>(messages[i].c_str()), signature.begin(), static_cast<int>(signature.size())))
+				result.value.assign(signature.begin());
+			else
+				result.setError(Poco::DataException(Utility::lastError(_containerString)));
+		}
+		catch (Poco::Exception& exc)
+		{
+			result.setError(exc);
+		}
+	}
+	return results;
+}
+
+SessionImpl::BatchResults SessionImpl::signBatchP7(const std::vector<std::string>& textuals, int mode)
+{
+	throw Poco::NotImplementedException("FJCA signBatchP7 is not supported!");
+}
+
+std::string SessionImpl::signFile(const std::string& path)
+{
+	char signature[4096] = { 0 };
+
+	if (!FJCA_SignFile(const_cast<char*>(path.c_str()), signature, 4096)) {
+		throw Poco::DataException(Utility::lastError(_containerString));
+	}
+
+	return signature;
+}
+
+bool SessionImpl::verifyFile(const std::string& base64, const std::string& path, const std::string& signature)
+{
+	return FJCA_VerifyFileSign(path.c_str(), signature.c_str(), base64.c_str());
+}
+
 } } } // namespace Reach::Data::FJCA
@@ -0,0 +1,105 @@
+//
+// CapabilityCache.h
+//
+// Library: Data/SOF
+// Package: SOF
+// Module:  CapabilityCache
+//
+// Definition of the CapabilityCache class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef SOF_CapabilityCache_INCLUDED
+#define SOF_CapabilityCache_INCLUDED
+
+
+#include "Reach/Data/SOF/SOF.h"
+#include "Poco/Mutex.h"
+#include <map>
+
+
+namespace Reach {
+namespace Data {
+namespace SOF {
+
+
+class SOF_API CapabilityCache
+	/// CapabilityCache remembers the encrypt method, the sign method and
+	/// the random size selected for a device, keyed by the device serial
+	/// number, so that sessions for a known key do not have to query
+	/// SOF_GetDeviceCapability() and SOF_GetDeviceInfo() again.
+	///
+	/// Entries are kept in memory. If a path has been set, they are
+	/// also stored in that file and loaded from it at startup.
+{
+public:
+	struct Capability
+	{
+		Capability();
+
+		long encryptMethod;
+		long signMethod;
+		int  randomSize;
+	};
+
+	CapabilityCache();
+		/// Creates an empty, memory only CapabilityCache.
+
+	~CapabilityCache();
+		/// Destroys the CapabilityCache.
+
+	static CapabilityCache& instance();
+		/// Returns the cache shared by all SOF sessions.
+
+	bool get(const std::string& serial, Capability& capability) const;
+		/// Looks up the capability of the device with the given serial
+		/// number. Returns false if the device is not known.
+
+	void put(const std::string& serial, const Capability& capability);
+		/// Stores the capability of the device with the given serial number
+		/// and, if a path has been set, writes the cache file.
+		/// Only capabilities with both methods selected should be stored;
+		/// entries without them are skipped when the file is loaded.
+
+	void remove(const std::string& serial);
+		/// Forgets the device with the given serial number.
+
+	void clear();
+		/// Forgets all devices.
+
+	void setPath(const std::string& path);
+		/// Sets the cache file and loads the entries stored in it.
+		/// An empty path disables the file. A missing or corrupt file
+		/// is treated as empty.
+
+	std::string getPath() const;
+		/// Returns the cache file, or an empty string.
+
+	std::size_t size() const;
+		/// Returns the number of devices in the cache.
+
+private:
+	typedef std::map<std::string, Capability> CapabilityMap;
+
+	CapabilityCache(const CapabilityCache&);
+	CapabilityCache& operator = (const CapabilityCache&);
+
+	void load();
+	void save();
+
+	CapabilityMap _capabilities;
+	std::string   _path;
+	mutable
+	Poco::FastMutex _mutex;
+};
+
+
+} } } // namespace Reach::Data::SOF
+
+
+#endif // SOF_CapabilityCache_INCLUDED
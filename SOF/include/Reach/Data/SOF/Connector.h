@@ -20,6 +20,8 @@
 
 #include "Reach/Data/SOF/SOF.h"
 #include "Reach/Data/Connector.h"
+#include "Reach/Data/DeviceMonitor.h"
+#include "Poco/Mutex.h"
 
 
 namespace Reach {
@@ -29,6 +31,13 @@ namespace SOF {
 
 class SOF_API Connector: public Reach::Data::Connector
 	/// Connector instantiates SOF SessionImpl objects.
+	///
+	/// SOF sessions can not be balanced across devices (see
+	/// Connector::supportsBalancing()): some provider calls, such as
+	/// SOF_SignData() with a container name or SOF_GetUserList(), do not
+	/// name a device, and the sign and encrypt methods are set for the
+	/// whole provider. Device sessions are still available to address
+	/// one particular key.
 {
 public:
 	static const std::string KEY;
@@ -47,11 +56,38 @@ public:
 		std::size_t timeout = Reach::Data::SessionImpl::LOGIN_TIMEOUT_DEFAULT);
 		/// Creates a SOF SessionImpl object and initializes it with the given connectionString.
 
+	std::vector<std::string> devices();
+		/// Returns the names of all attached devices, as reported by SOF_GetDeviceList().
+
+	Poco::AutoPtr<Reach::Data::SessionImpl> createDeviceSession(const std::string& connectionString,
+		std::size_t timeout,
+		const std::string& device);
+		/// Creates a SOF SessionImpl object bound to the given device.
+
+	static Reach::Data::DeviceMonitor& monitor();
+		/// Returns the monitor watching for SOF devices.
+		/// The monitor is named after Connector::KEY and runs from
+		/// registerConnector() to unregisterConnector(), which must be
+		/// called before the library is unloaded.
+
+	static bool isAttached(const std::string& device);
+		/// Returns true if the device was attached when the
+		/// monitor last probed.
+
 	static void registerConnector();
 		/// Registers the Connector under the Keyword Connector::KEY at the Poco::Data::SessionFactory.
 
 	static void unregisterConnector();
 		/// Unregisters the Connector under the Keyword Connector::KEY at the Poco::Data::SessionFactory.
+
+private:
+	static std::vector<std::string> deviceList();
+	static bool probe();
+		/// Lists the devices for isAttached() and
+		/// returns true if there is any.
+
+	static std::vector<std::string> _attached;
+	static Poco::FastMutex _mutex;
 };
 
 
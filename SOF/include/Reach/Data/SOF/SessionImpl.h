@@ -23,6 +23,7 @@
 #include "Reach/Data/AbstractSessionImpl.h"
 #include "Poco/SharedPtr.h"
 #include "Poco/Mutex.h"
+#include <atomic>
 
 namespace Reach {
 namespace Data {
@@ -34,8 +35,12 @@ class SOF_API SessionImpl: public Reach::Data::AbstractSessionImpl<SessionImpl>
 {
 public:
 	SessionImpl(const std::string& connectionString,
-		std::size_t loginTimeout = LOGIN_TIMEOUT_DEFAULT);
+		std::size_t loginTimeout = LOGIN_TIMEOUT_DEFAULT,
+		const std::string& device = "");
 		/// Creates the SessionImpl. Opens a connection to the database.
+		///
+		/// If device is empty, the default device is opened,
+		/// otherwise the device with the given name.
 
 	~SessionImpl();
 		/// Destroys the SessionImpl.
@@ -60,6 +65,13 @@ public:
 	bool isConnected();
 		/// Returns true if connected, false otherwise.
 
+	bool isAlive();
+		/// Returns true if connected and the key opened has not been
+		/// removed since. A session bound to a device checks that this
+		/// device was attached at the last probe of the connector's
+		/// DeviceMonitor, a session on the default device that any
+		/// key is attached.
+
 	void setConnectionTimeout(std::size_t timeout);
 		/// Sets the session connection timeout value.
 		/// Timeout value is in seconds.
@@ -73,6 +85,10 @@ public:
 
 	const std::string& contianerName() const;
 
+	const std::string& device() const;
+		/// Returns the name of the device the session is bound to,
+		/// or an empty string for the default device.
+
 	bool login(const std::string& passwd);
 
 	bool changePW(const std::string& oldCode, const std::string& newCode);
@@ -103,10 +119,31 @@ public:
 
 	bool verifySignByP7(const std::string& textual, const std::string& signature);
 
+	BatchResults signBatchP1(const std::vector<std::string>& messages);
+		/// Checks the session and selects the sign method once, then signs the messages
+		/// back to back.
+
+	BatchResults signBatchP7(const std::vector<std::string>& textuals, int mode);
+		/// Like signBatchP1(), for PKCS#7 signatures.
+
+	std::string signFile(const std::string& path);
+		/// Signs the file with SOF_SignFile(), which hashes it
+		/// in the provider and signs the digest on the key.
+
+	bool verifyFile(const std::string& base64, const std::string& path, const std::string& signature);
+		/// Verifies the signature with SOF_VerifySignedFile().
+
 protected:
 	void setConnectionTimeout(const std::string& prop, const Poco::Any& value);
 	Poco::Any getConnectionTimeout(const std::string& prop);
 	void selectMode();
+		/// Selects the encrypt and sign methods, using the
+		/// CapabilityCache for devices seen before.
+	void applyMode();
+	int openDevice();
+	void onDeviceDisconnected(const void* pSender, const std::string& name);
+		/// Forgets the login, the key has lost its authentication.
+		/// The session is not alive until it is reopened.
 
 private:
 	std::string _connector;
@@ -117,6 +154,8 @@ private:
 	int			_current_signed_algorithm;
 	std::string _connectionString;
 	std::string _containerString;//uid
+	std::string _device;
+	std::atomic<bool> _attached;
 	Poco::Mutex _mutex;
 	const int defaultError = 0x9999;
 };
@@ -126,6 +165,11 @@ inline const std::string& SessionImpl::contianerName() const
 	return _containerString;
 }
 
+inline const std::string& SessionImpl::device() const
+{
+	return _device;
+}
+
 inline const std::string& SessionImpl::connectorName() const
 {
 	return _connector;
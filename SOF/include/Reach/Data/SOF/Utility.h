@@ -57,13 +57,17 @@ public:
 
 	static std::string toLegelID(const std::string & text, const std::string & pattern);
 
-	static void selectEncryptMethod(const std::string & containerString);
+	static long selectEncryptMethod(const std::string & containerString);
+		/// Selects the preferred encrypt method supported by the device.
+		/// Returns the method, or 0 if none is supported.
 
 	static void spiltEntries(const std::string& entries, std::string& containerString, std::string& userString);
 
 	static int GetRandomSize();
 
-	static void selectSignMethod(const std::string & containerString);
+	static long selectSignMethod(const std::string & containerString);
+		/// Selects the sign method matching the container type.
+		/// Returns the method, or 0 if the type is unknown.
 
 private:
 	Utility();
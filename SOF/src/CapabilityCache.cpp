@@ -0,0 +1,181 @@
+//
+// CapabilityCache.cpp
+//
+// Library: Data/SOF
+// Package: SOF
+// Module:  CapabilityCache
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/SOF/CapabilityCache.h"
+#include "Poco/SingletonHolder.h"
+#include "Poco/FileStream.h"
+#include "Poco/File.h"
+#include "Poco/StringTokenizer.h"
+#include "Poco/NumberParser.h"
+#include "Poco/Exception.h"
+#include <string>
+
+
+using Poco::FastMutex;
+
+
+namespace Reach {
+namespace Data {
+namespace SOF {
+
+
+CapabilityCache::Capability::Capability():
+	encryptMethod(0),
+	signMethod(0),
+	randomSize(0)
+{
+}
+
+
+CapabilityCache::CapabilityCache()
+{
+}
+
+
+CapabilityCache::~CapabilityCache()
+{
+}
+
+
+namespace
+{
+	static Poco::SingletonHolder<CapabilityCache> sh;
+}
+
+
+CapabilityCache& CapabilityCache::instance()
+{
+	return *sh.get();
+}
+
+
+bool CapabilityCache::get(const std::string& serial, Capability& capability) const
+{
+	FastMutex::ScopedLock lock(_mutex);
+	CapabilityMap::const_iterator it = _capabilities.find(serial);
+	if (it == _capabilities.end()) return false;
+
+	capability = it->second;
+	return true;
+}
+
+
+void CapabilityCache::put(const std::string& serial, const Capability& capability)
+{
+	poco_assert (!serial.empty());
+
+	FastMutex::ScopedLock lock(_mutex);
+	_capabilities[serial] = capability;
+	save();
+}
+
+
+void CapabilityCache::remove(const std::string& serial)
+{
+	FastMutex::ScopedLock lock(_mutex);
+	if (_capabilities.erase(serial)) save();
+}
+
+
+void CapabilityCache::clear()
+{
+	FastMutex::ScopedLock lock(_mutex);
+	_capabilities.clear();
+	save();
+}
+
+
+void CapabilityCache::setPath(const std::string& path)
+{
+	FastMutex::ScopedLock lock(_mutex);
+	_path = path;
+	load();
+}
+
+
+std::string CapabilityCache::getPath() const
+{
+	FastMutex::ScopedLock lock(_mutex);
+	return _path;
+}
+
+
+std::size_t CapabilityCache::size() const
+{
+	FastMutex::ScopedLock lock(_mutex);
+	return _capabilities.size();
+}
+
+
+void CapabilityCache::load()
+{
+	// one device per line: serial=encryptMethod,signMethod,randomSize
+	if (_path.empty() || !Poco::File(_path).exists()) return;
+
+	try
+	{
+		Poco::FileInputStream istr(_path);
+		std::string line;
+		while (std::getline(istr, line))
+		{
+			std::string::size_type pos = line.find('=');
+			if (pos == std::string::npos || pos == 0) continue;
+
+			Poco::StringTokenizer tok(line.substr(pos + 1), ",", Poco::StringTokenizer::TOK_TRIM);
+			if (tok.count() != 3) continue;
+
+			Capability capability;
+			capability.encryptMethod = static_cast<long>(Poco::NumberParser::parse64(tok[0]));
+			capability.signMethod = static_cast<long>(Poco::NumberParser::parse64(tok[1]));
+			capability.randomSize = Poco::NumberParser::parse(tok[2]);
+			if (capability.encryptMethod == 0 || capability.signMethod == 0) continue;
+			_capabilities[line.substr(0, pos)] = capability;
+		}
+	}
+	catch (Poco::Exception&)
+	{
+		// a corrupt cache only costs the device queries
+	}
+}
+
+
+void CapabilityCache::save()
+{
+	if (_path.empty()) return;
+
+	try
+	{
+		// write a temporary file first, so that readers
+		// never see a partially written cache
+		std::string tmpPath(_path + ".tmp");
+		{
+			Poco::FileOutputStream ostr(tmpPath);
+			for (CapabilityMap::const_iterator it = _capabilities.begin(); it != _capabilities.end(); ++it)
+			{
+				ostr << it->first << '='
+				     << it->second.encryptMethod << ','
+				     << it->second.signMethod << ','
+				     << it->second.randomSize << '\n';
+			}
+		}
+		Poco::File(tmpPath).renameTo(_path);
+	}
+	catch (Poco::Exception&)
+	{
+		// the in-memory cache remains valid
+	}
+}
+
+
+} } } // namespace Reach::Data::SOF
@@ -15,6 +15,8 @@
 #include "Reach/Data/SOF/Connector.h"
 #include "Reach/Data/SOF/SessionImpl.h"
 #include "Reach/Data/SessionFactory.h"
+#include "Poco/StringTokenizer.h"
+#include <algorithm>
 #if defined(POCO_UNBUNDLED)
 #include <SoFProvider.h>
 #else
@@ -28,6 +30,8 @@ namespace SOF {
 
 
 const std::string Connector::KEY("SOF");
+std::vector<std::string> Connector::_attached;
+Poco::FastMutex Connector::_mutex;
 
 
 Connector::Connector()
@@ -47,14 +51,66 @@ Poco::AutoPtr<Reach::Data::SessionImpl> Connector::createSession(const std::stri
 }
 
 
+std::vector<std::string> Connector::devices()
+{
+	return deviceList();
+}
+
+
+std::vector<std::string> Connector::deviceList()
+{
+	// device names are separated by "||" or "&&&", like the user list
+	Poco::StringTokenizer tok(SOF_GetDeviceList(), "|&\r\n",
+		Poco::StringTokenizer::TOK_IGNORE_EMPTY | Poco::StringTokenizer::TOK_TRIM);
+	return std::vector<std::string>(tok.begin(), tok.end());
+}
+
+
+Poco::AutoPtr<Reach::Data::SessionImpl> Connector::createDeviceSession(const std::string& connectionString,
+	std::size_t timeout,
+	const std::string& device)
+{
+	return Poco::AutoPtr<Reach::Data::SessionImpl>(new SessionImpl(connectionString, timeout, device));
+}
+
+
+Reach::Data::DeviceMonitor& Connector::monitor()
+{
+	static Reach::Data::DeviceMonitor dm(KEY, &Connector::probe);
+	return dm;
+}
+
+
+bool Connector::probe()
+{
+	std::vector<std::string> attached = deviceList();
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	_attached.swap(attached);
+	return !_attached.empty();
+}
+
+
+bool Connector::isAttached(const std::string& device)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	return std::find(_attached.begin(), _attached.end(), device) != _attached.end();
+}
+
+
 void Connector::registerConnector()
 {
 	Reach::Data::SessionFactory::instance().add(new Connector());
+
+	// probing talks to the provider, so in queued mode it is queued
+	// with the operations on the default device; in direct mode, no
+	// worker is created and the monitor thread probes like any caller
+	monitor().start([]() { return Reach::Data::SessionFactory::instance().queuedWorker(KEY); });
 }
 
 
 void Connector::unregisterConnector()
 {
+	monitor().stop();
 	Reach::Data::SessionFactory::instance().remove(KEY);
 }
 
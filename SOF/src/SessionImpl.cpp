@@ -16,11 +16,13 @@
 #include "Reach/Data/SOF/SOFException.h"
 #include "Reach/Data/Session.h"
 #include "Reach/Data/SOF/Utility.h"
+#include "Reach/Data/SOF/CapabilityCache.h"
 #include "GMCrypto.h"
 #include "Poco/Stopwatch.h"
 #include "Poco/String.h"
 #include "Poco/Mutex.h"
 #include "Poco/Thread.h"
+#include "Poco/Delegate.h"
 #include "Reach/Data/DataException.h"
 #include "SoFProvider.h"
 #include "SOFErrorCode.h"
@@ -33,24 +35,34 @@
 #define SOF_OPEN_URI 0
 #endif
 
+#ifndef SOF_DEVICE_TYPE
+#define SOF_DEVICE_TYPE 0
+#endif
+
 
 namespace Reach {
 namespace Data {
 namespace SOF {
 
 
-SessionImpl::SessionImpl(const std::string& connectionString, std::size_t loginTimeout):
+SessionImpl::SessionImpl(const std::string& connectionString, std::size_t loginTimeout, const std::string& device):
 	Reach::Data::AbstractSessionImpl<SessionImpl>(connectionString, loginTimeout),
 	_connector(Connector::KEY),
 	_connected(false),
 	_random_size(0),
-	_connectionString(connectionString)
+	_current_encrypt_algorithm(0),
+	_current_signed_algorithm(0),
+	_connectionString(connectionString),
+	_device(device),
+	_attached(false)
 {
 	open();
 	selectMode();
 	setConnectionTimeout(loginTimeout);
 
 	addProperty("connectionTimeout", &SessionImpl::setConnectionTimeout, &SessionImpl::getConnectionTimeout);
+
+	Connector::monitor().deviceDisconnected += Poco::delegate(this, &SessionImpl::onDeviceDisconnected);
 }
 
 
@@ -58,6 +70,7 @@ SessionImpl::~SessionImpl()
 {
 	try
 	{
+		Connector::monitor().deviceDisconnected -= Poco::delegate(this, &SessionImpl::onDeviceDisconnected);
 		close();
 	}
 	catch (...)
@@ -81,19 +94,16 @@ void SessionImpl::open(const std::string& connect)
 
 	try
 	{
-		int rc = 0;
-		size_t tout = getLoginTimeout();
-		Poco::Stopwatch sw; sw.start();
-		while (true)
+		// without a key, wait for the monitor to report one; a key
+		// that is present may still be busy or starting up, so the
+		// device is retried, backing off, until the login timeout
+		int rc = SAR_OK;
+		long tout = static_cast<long>(1000 * getLoginTimeout());
+		Connector::monitor().retry([&]() { return (rc = openDevice()) == SAR_OK; }, tout);
+		if (rc != SAR_OK)
 		{
-			rc = SOF_OpenDevice();
-			if (rc == SAR_OK) break;
-			if (sw.elapsedSeconds() >= tout)
-			{
-				close();
-				throw SOFException(rc);
-			}
-			else Poco::Thread::sleep(10);
+			close();
+			throw SOFException(rc);
 		}
 	} 
 	catch (SOFException& ex)
@@ -102,14 +112,30 @@ void SessionImpl::open(const std::string& connect)
 	}
 
 	_connected = true;
+	_attached = true;
+	setLoggedIn(false);
+
+	// a reopened device gets the methods selected before,
+	// without querying its capabilities again
+	applyMode();
+}
+
+
+int SessionImpl::openDevice()
+{
+	return _device.empty() ? SOF_OpenDevice() : SOF_OpenDevice(_device, SOF_DEVICE_TYPE);
 }
 
 
 void SessionImpl::close()
 {
-	SOF_CloseDevice();
+	if (_device.empty())
+		SOF_CloseDevice();
+	else
+		SOF_CloseDevice(_device, SOF_DEVICE_TYPE);
 
 	_connected = false;
+	setLoggedIn(false);
 }
 
 
@@ -119,6 +145,20 @@ bool SessionImpl::isConnected()
 }
 
 
+bool SessionImpl::isAlive()
+{
+	if (!_connected || !_attached) return false;
+	return _device.empty() ? Connector::monitor().isPresent() : Connector::isAttached(_device);
+}
+
+
+void SessionImpl::onDeviceDisconnected(const void* pSender, const std::string& name)
+{
+	_attached = false;
+	setLoggedIn(false);
+}
+
+
 void SessionImpl::setConnectionTimeout(std::size_t timeout)
 {
 	int tout = static_cast<int>(1000 * timeout);
@@ -129,9 +169,37 @@ void SessionImpl::selectMode()
 {
 	std::string userString;
 	Utility::spiltEntries(getUserList(), _containerString, userString);
-	Utility::selectEncryptMethod(_containerString);
-	Utility::selectSignMethod(_containerString);
+
+	CapabilityCache::Capability capability;
+	std::string serial = SOF_GetDeviceInfo(_containerString, SGD_DEVICE_SERIAL_NUMBER);
+	if (!serial.empty() && CapabilityCache::instance().get(serial, capability))
+	{
+		_current_encrypt_algorithm = capability.encryptMethod;
+		_current_signed_algorithm = capability.signMethod;
+		_random_size = capability.randomSize;
+		applyMode();
+		return;
+	}
+
+	_current_encrypt_algorithm = Utility::selectEncryptMethod(_containerString);
+	_current_signed_algorithm = Utility::selectSignMethod(_containerString);
 	_random_size = Utility::GetRandomSize();
+
+	// a method missing now may only mean the device was busy,
+	// so only complete selections are remembered
+	if (!serial.empty() && _current_encrypt_algorithm && _current_signed_algorithm)
+	{
+		capability.encryptMethod = _current_encrypt_algorithm;
+		capability.signMethod = _current_signed_algorithm;
+		capability.randomSize = _random_size;
+		CapabilityCache::instance().put(serial, capability);
+	}
+}
+
+void SessionImpl::applyMode()
+{
+	if (_current_encrypt_algorithm) SOF_SetEncryptMethod(_current_encrypt_algorithm);
+	if (_current_signed_algorithm) SOF_SetSignMethod(_current_signed_algorithm);
 }
 
 void SessionImpl::setConnectionTimeout(const std::string& prop, const Poco::Any& value)
@@ -147,7 +215,9 @@ Poco::Any SessionImpl::getConnectionTimeout(const std::string& prop)
 
 bool SessionImpl::login(const std::string& passwd)
 {
-	return SOF_Login(_containerString, passwd);
+	bool rc = SOF_Login(_containerString, passwd);
+	setLoggedIn(rc);
+	return rc;
 }
 
 bool SessionImpl::changePW(const std::string& oldCode, const std::string& newCode)
@@ -280,4 +350,77 @@ bool SessionImpl::verifySignByP7(const std::string& textual, const std::string&
 	return SOF_VerifySignedMessage(signature, textual);
 }
 
+SessionImpl::BatchResults SessionImpl::signBatchP1(const std::vector<std::string>& messages)
+{
+	if (!_connected) throw NotConnectedException(connectionString());
+
+	// the sign method is selected once for the whole batch
+	if (_current_signed_algorithm) SOF_SetSignMethod(_current_signed_algorithm);
+
+	BatchResults results(messages.size());
+	for (std::size_t i = 0; i < messages.size(); ++i)
+	{
+		BatchResult& result = results[i];
+		try
+		{
+			CancellationToken::checkCurrent();
+			result.value = SOF_SignData(_containerString, messages[i]);
+			if (result.value.empty())
+			{
+				int rc = static_cast<int>(SOF_GetLastError());
+				result.setError(SOFException(Utility::lastError(_containerString), rc));
+			}
+		}
+		catch (Poco::Exception& exc)
+		{
+			result.setError(exc);
+		}
+	}
+	return results;
+}
+
+SessionImpl::BatchResults SessionImpl::signBatchP7(const std::vector<std::string>& textuals, int mode)
+{
+	if (!_connected) throw NotConnectedException(connectionString());
+
+	if (_current_signed_algorithm) SOF_SetSignMethod(_current_signed_algorithm);
+
+	BatchResults results(textuals.size());
+	for (std::size_t i = 0; i < textuals.size(); ++i)
+	{
+		BatchResult& result = results[i];
+		try
+		{
+			CancellationToken::checkCurrent();
+			result.value = SOF_SignMessage(static_cast<short>(mode), _containerString, textuals[i]);
+			if (result.value.empty())
+			{
+				int rc = static_cast<int>(SOF_GetLastError());
+				result.setError(SOFException(Utility::lastError(_containerString), rc));
+			}
+		}
+		catch (Poco::Exception& exc)
+		{
+			result.setError(exc);
+		}
+	}
+	return results;
+}
+
+std::string SessionImpl::signFile(const std::string& path)
+{
+	std::string signature = SOF_SignFile(_containerString, path);
+	if (signature.empty())
+	{
+		int rc = static_cast<int>(SOF_GetLastError());
+		throw SOFException(Utility::lastError(_containerString), rc);
+	}
+	return signature;
+}
+
+bool SessionImpl::verifyFile(const std::string& base64, const std::string& path, const std::string& signature)
+{
+	return SOF_VerifySignedFile(base64, path, signature);
+}
+
 } } } // namespace Reach::Data::SOF
@@ -365,7 +365,7 @@ std::string Utility::toLegelID(const std::string& text, const std::string& patte
 
 
 
-void Utility::selectEncryptMethod(const std::string& containerString)
+long Utility::selectEncryptMethod(const std::string& containerString)
 {
 	std::vector<std::string> methods;
 	methods = SOF_GetDeviceCapability(containerString, 0);
@@ -378,22 +378,26 @@ void Utility::selectEncryptMethod(const std::string& containerString)
 	TupleType priority3("SGD_SM4_ECB", SGD_SM4_ECB, 16);
 	TupleType priority4("SGD_SM4_CBC", SGD_SM4_CBC, 32);
 
+	long method = 0;
 	if (std::find(methods.begin(), methods.end(), priority1.get<0>()) != methods.end()) {
-		SOF_SetEncryptMethod(priority1.get<1>());
+		method = priority1.get<1>();
 		_random_size = priority1.get<2>();
 	}
 	else if (std::find(methods.begin(), methods.end(), priority2.get<0>()) != methods.end()) {
-		SOF_SetEncryptMethod(priority2.get<1>());
+		method = priority2.get<1>();
 		_random_size = priority2.get<2>();
 	}
 	else if (std::find(methods.begin(), methods.end(), priority3.get<0>()) != methods.end()) {
-		SOF_SetEncryptMethod(priority3.get<1>());
+		method = priority3.get<1>();
 		_random_size = priority3.get<2>();
 	}
 	else if (std::find(methods.begin(), methods.end(), priority4.get<0>()) != methods.end()) {
-		SOF_SetEncryptMethod(priority4.get<1>());
+		method = priority4.get<1>();
 		_random_size = priority4.get<2>();
 	}
+
+	if (method) SOF_SetEncryptMethod(method);
+	return method;
 }
 
 void Utility::spiltEntries(const std::string& entries, std::string& containerString, std::string& userString)
@@ -419,7 +423,7 @@ int Utility::GetRandomSize()
 	return _random_size;
 }
 
-void Utility::selectSignMethod(const std::string& containerString)
+long Utility::selectSignMethod(const std::string& containerString)
 {
 	/// index from zero		1 - RSA Container Type
 	/// (0 =>1)				2 - SM Container Type
@@ -435,12 +439,16 @@ void Utility::selectSignMethod(const std::string& containerString)
 
 	std::string type = SOF_GetDeviceInfo(containerString, SGD_DEVICE_SUPPORT_ALG);
 
+	long method = 0;
 	if (dummy.get<0>() == type) {
-		SOF_SetSignMethod(dummy.get<2>());
+		method = dummy.get<2>();
 	}
 	else if (dummy2.get<0>() == type) {
-		SOF_SetSignMethod(dummy2.get<2>());
+		method = dummy2.get<2>();
 	}
+
+	if (method) SOF_SetSignMethod(method);
+	return method;
 }
 
 // NOTE: Utility::dbHandle() has been moved to SessionImpl.cpp,
@@ -55,7 +55,8 @@ public:
 			_storage(std::string("deque")),
 			_bulk(false),
 			_emptyStringIsNull(false),
-			_forceEmptyString(false)
+			_forceEmptyString(false),
+			_digest(false)
 		/// Creates the AbstractSessionImpl.
 		/// 
 		/// Adds "storage" property and sets the default internal storage container 
@@ -70,9 +71,9 @@ public:
 		/// for the back end DB.
 		/// 
 		/// Adds "bulk" feature and sets it to false.
-		/// Bulk feature determines whether the session is capable of bulk operations.
-		/// Connectors that are capable of it must set this feature prior to attempting 
-		/// bulk operations.
+		/// Bulk feature determines whether statements of the session accept
+		/// batches of argument sets (see Statement::addBatch()), which are
+		/// executed with one exclusive use of the device and one login check.
 		///
 		/// Adds "emptyStringIsNull" feature and sets it to false. This feature should be
 		/// set to true in order to modify the behavior of the databases that distinguish
@@ -88,6 +89,10 @@ public:
 		/// While these features can not both be true at the same time, they can both be false,
 		/// resulting in default underlying database behavior.
 		///
+		/// Adds the read-only "digest" feature, which is false unless the
+		/// connector overrides SessionImpl::signDigest() and reports it with
+		/// setDigestSupport().
+		///
 	{
 		addProperty("storage", 
 			&AbstractSessionImpl<C>::setStorage, 
@@ -108,6 +113,10 @@ public:
 		addFeature("forceEmptyString", 
 			&AbstractSessionImpl<C>::setForceEmptyString,
 			&AbstractSessionImpl<C>::getForceEmptyString);
+
+		addFeature("digest", 
+			0,
+			&AbstractSessionImpl<C>::getDigest);
 	}
 
 	~AbstractSessionImpl()
@@ -206,13 +215,13 @@ public:
 	}
 
 	void setBulk(const std::string& name, bool bulk)
-		/// Sets the execution type.
+		/// Enables or disables batch execution of statements.
 	{
 		_bulk = bulk;
 	}
 		
 	bool getBulk(const std::string& name="")
-		/// Returns the execution type
+		/// Returns true if batch execution of statements is enabled.
 	{
 		return _bulk;
 	}
@@ -258,7 +267,21 @@ public:
 		return _forceEmptyString;
 	}
 
+	bool getDigest(const std::string& name="")
+		/// Returns true if the session can sign digests computed
+		/// on the host. See SessionImpl::signDigest().
+	{
+		return _digest;
+	}
+
 protected:
+	void setDigestSupport(bool supported)
+		/// Sets the "digest" feature. Connectors overriding
+		/// SessionImpl::signDigest() call it from their constructor.
+	{
+		_digest = supported;
+	}
+
 	void addFeature(const std::string& name, FeatureSetter setter, FeatureGetter getter)
 		/// Adds a feature to the map of supported features.
 		///
@@ -305,6 +328,7 @@ private:
 	bool        _bulk;
 	bool        _emptyStringIsNull;
 	bool        _forceEmptyString;
+	bool        _digest;
 	Poco::Any   _handle;
 };
 
@@ -0,0 +1,709 @@
+//
+// Awaitable.h
+//
+// Library: Data
+// Package: Execution
+// Module:  Awaitable
+//
+// Definition of the Task and ResultAwaiter class templates
+// and the AwaitableSession class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_Awaitable_INCLUDED
+#define RData_Awaitable_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+
+
+//
+// C++20 coroutine support. Everything in this header is only
+// available if the compiler implements coroutines and
+// RDATA_NO_COROUTINES has not been defined.
+//
+#if !defined(RDATA_NO_COROUTINES) && defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+	#define RDATA_HAVE_COROUTINES
+#endif
+
+
+#if defined(RDATA_HAVE_COROUTINES)
+
+
+#include "Reach/Data/Session.h"
+#include "Reach/Data/Statement.h"
+#include "Reach/Data/StatementExecutor.h"
+#include "Reach/Data/CancellationToken.h"
+#include "Reach/Data/DeviceWorker.h"
+#include "Poco/ActiveResult.h"
+#include "Poco/Exception.h"
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#include <memory>
+
+
+namespace Reach {
+namespace Data {
+
+
+class TaskPromiseBase
+	/// The part of the promise of a Task that does not
+	/// depend on its result type.
+	///
+	/// A Task carries the CancellationToken that is current when
+	/// the Task is created, or that of the Task awaiting it. The
+	/// awaiters in this header check the token before they start
+	/// an operation and make it current while they do, so device
+	/// jobs issued by the Task are dropped once it has been cancelled
+	/// or its deadline has passed.
+{
+public:
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		template <class P>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+		{
+			std::coroutine_handle<> continuation = handle.promise()._continuation;
+			return continuation ? continuation : std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept
+		{
+		}
+	};
+
+	TaskPromiseBase():
+		_pToken(CancellationToken::current(), true)
+	{
+	}
+
+	std::suspend_always initial_suspend() const noexcept
+	{
+		return std::suspend_always();
+	}
+
+	FinalAwaiter final_suspend() const noexcept
+	{
+		return FinalAwaiter();
+	}
+
+	void unhandled_exception()
+	{
+		_exception = std::current_exception();
+	}
+
+	void setContinuation(std::coroutine_handle<> continuation)
+	{
+		_continuation = continuation;
+	}
+
+	void setCancellation(CancellationToken::Ptr pToken)
+	{
+		_pToken = pToken;
+	}
+
+	CancellationToken::Ptr cancellation() const
+	{
+		return _pToken;
+	}
+
+protected:
+	void rethrow() const
+	{
+		if (_exception) std::rethrow_exception(_exception);
+	}
+
+private:
+	std::coroutine_handle<> _continuation;
+	std::exception_ptr      _exception;
+	CancellationToken::Ptr  _pToken;
+};
+
+
+template <class P>
+CancellationToken::Ptr cancellationOf(std::coroutine_handle<P> handle)
+	/// Returns the token of the awaiting coroutine if it is a Task,
+	/// otherwise the current token of the calling thread.
+{
+	if constexpr (std::is_base_of<TaskPromiseBase, P>::value)
+		return handle.promise().cancellation();
+	else
+		return CancellationToken::Ptr(CancellationToken::current(), true);
+}
+
+
+template <class T>
+class TaskPromise: public TaskPromiseBase
+	/// The promise of a Task returning a value of type T.
+{
+public:
+	template <class V>
+	void return_value(V&& value)
+	{
+		_value.emplace(std::forward<V>(value));
+	}
+
+	T result()
+	{
+		rethrow();
+		return std::move(*_value);
+	}
+
+private:
+	std::optional<T> _value;
+};
+
+
+template <>
+class TaskPromise<void>: public TaskPromiseBase
+	/// The promise of a Task without a result.
+{
+public:
+	void return_void()
+	{
+	}
+
+	void result()
+	{
+		rethrow();
+	}
+};
+
+
+template <class T = void>
+class Task
+	/// A Task is a lazily started coroutine returning a value of type T.
+	///
+	/// The coroutine starts when the Task is awaited, and the awaiting
+	/// coroutine resumes on the thread that completes the Task. A Task
+	/// costs one coroutine frame, so a service can keep thousands of
+	/// device requests in flight without a thread or stack for each:
+	///
+	///     Task<std::string> sign(AwaitableSession session, std::string text)
+	///     {
+	///         if (!co_await session.login(pin)) throw LoginFailedException();
+	///         co_return co_await session.signByP7(text, 1);
+	///     }
+	///
+	/// Use spawn() to start a Task from code that is not a coroutine.
+{
+public:
+	class promise_type: public TaskPromise<T>
+	{
+	public:
+		Task get_return_object()
+		{
+			return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+	};
+
+	typedef std::coroutine_handle<promise_type> Handle;
+
+	class Awaiter
+	{
+	public:
+		explicit Awaiter(Handle handle):
+			_handle(handle)
+		{
+		}
+
+		bool await_ready() const
+		{
+			return !_handle || _handle.done();
+		}
+
+		template <class P>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<P> awaiting)
+		{
+			promise_type& promise = _handle.promise();
+			promise.setContinuation(awaiting);
+			if (!promise.cancellation()) promise.setCancellation(cancellationOf(awaiting));
+			return _handle;
+		}
+
+		T await_resume()
+		{
+			if (!_handle) throw Poco::NullPointerException("Task");
+			return _handle.promise().result();
+		}
+
+	private:
+		Handle _handle;
+	};
+
+	Task():
+		_handle(nullptr)
+	{
+	}
+
+	Task(Task&& other) noexcept:
+		_handle(std::exchange(other._handle, nullptr))
+	{
+	}
+
+	~Task()
+	{
+		if (_handle) _handle.destroy();
+	}
+
+	Task& operator = (Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (_handle) _handle.destroy();
+			_handle = std::exchange(other._handle, nullptr);
+		}
+		return *this;
+	}
+
+	Task& setCancellation(CancellationToken::Ptr pToken)
+		/// Sets the token of the Task, e.g. one with a deadline.
+		/// Must be called before the Task is started.
+	{
+		if (_handle) _handle.promise().setCancellation(pToken);
+		return *this;
+	}
+
+	Awaiter operator co_await() const noexcept
+	{
+		return Awaiter(_handle);
+	}
+
+private:
+	explicit Task(Handle handle):
+		_handle(handle)
+	{
+	}
+
+	Task(const Task&);
+	Task& operator = (const Task&);
+
+	Handle _handle;
+};
+
+
+class DetachedTask
+	/// The coroutine type of the driver started by spawn().
+	/// It runs eagerly and frees its frame when done.
+{
+public:
+	struct promise_type
+	{
+		DetachedTask get_return_object() const
+		{
+			return DetachedTask();
+		}
+
+		std::suspend_never initial_suspend() const noexcept
+		{
+			return std::suspend_never();
+		}
+
+		std::suspend_never final_suspend() const noexcept
+		{
+			return std::suspend_never();
+		}
+
+		void return_void() const
+		{
+		}
+
+		void unhandled_exception() const
+		{
+			std::terminate();
+		}
+	};
+};
+
+
+template <class T>
+DetachedTask runTask(Task<T> task, Poco::ActiveResult<T> result)
+	/// Awaits the task and delivers its outcome to the result.
+{
+	try
+	{
+		if constexpr (std::is_void<T>::value)
+			co_await task;
+		else
+			result.data(new T(co_await task));
+	}
+	catch (Poco::Exception& exc)
+	{
+		result.error(exc);
+	}
+	catch (std::exception& exc)
+	{
+		result.error(exc.what());
+	}
+	catch (...)
+	{
+		result.error("unknown exception");
+	}
+	result.notify();
+}
+
+
+template <class T>
+Poco::ActiveResult<T> spawn(Task<T> task)
+	/// Starts the task on the calling thread and returns its result,
+	/// which becomes available when the task has completed. This
+	/// connects coroutines to code that is not a coroutine:
+	///
+	///     Poco::ActiveResult<std::string> result = spawn(sign(session, text));
+	///     result.wait();
+{
+	Poco::ActiveResult<T> result(new Poco::ActiveResultHolder<T>());
+	runTask(std::move(task), result);
+	return result;
+}
+
+
+class ResumeJob: public DeviceJob
+	/// A DeviceJob resuming a suspended coroutine on
+	/// a StatementExecutor. A cancelled job resumes the
+	/// coroutine as well, on the cancelling thread, so
+	/// a stopped executor does not leak coroutine frames.
+{
+public:
+	explicit ResumeJob(std::coroutine_handle<> handle):
+		_handle(handle)
+	{
+	}
+
+	void run()
+	{
+		_handle.resume();
+	}
+
+	void cancel(const std::string&)
+	{
+		_handle.resume();
+	}
+
+private:
+	std::coroutine_handle<> _handle;
+};
+
+
+template <class R>
+class ResultAwaiter
+	/// Awaits the result of an asynchronous operation
+	/// that reports its result to a callback, such as
+	/// Session::signByP1Async() or Statement::then().
+	///
+	/// If an executor is given, the awaiting coroutine resumes on
+	/// it; otherwise it resumes on the thread that completed the
+	/// operation, e.g. the DeviceWorker of a queued session, and
+	/// should then not block.
+	///
+	/// If the token of the awaiting coroutine (see TaskPromiseBase)
+	/// has been cancelled or its deadline has passed, the operation is
+	/// not started and co_await throws an OperationCancelledException
+	/// or a DeadlineExceededException.
+{
+public:
+	typedef Poco::ActiveResult<R>               Result;
+	typedef std::function<void(const Result&)> Callback;
+	typedef std::function<void(const Callback&)> Start;
+
+	ResultAwaiter(const Start& start, StatementExecutor::Ptr pExecutor = 0):
+		_start(start),
+		_pExecutor(pExecutor),
+		_done(false)
+	{
+	}
+
+	ResultAwaiter(ResultAwaiter&& other):
+		_start(std::move(other._start)),
+		_pExecutor(other._pExecutor),
+		_done(false)
+	{
+	}
+
+	bool await_ready() const
+	{
+		return false;
+	}
+
+	template <class P>
+	bool await_suspend(std::coroutine_handle<P> handle)
+	{
+		CancellationToken::Ptr pToken = cancellationOf(handle);
+		if (pToken) pToken->check();
+
+		CancellationToken::Scope scope(pToken);
+		_start([this, handle, pToken](const Result& result)
+		{
+			_pResult.reset(new Result(result));
+			if (_done.exchange(true) && !post(handle, pToken)) handle.resume();
+		});
+		// Whichever of the callback and this method comes second
+		// resumes the coroutine.
+		if (!_done.exchange(true)) return true;
+		return post(handle, pToken);
+	}
+
+	R await_resume()
+	{
+		if (_pResult->failed()) _pResult->exception()->rethrow();
+		if constexpr (std::is_void<R>::value)
+			return;
+		else
+			return _pResult->data();
+	}
+
+private:
+	ResultAwaiter(const ResultAwaiter&);
+	ResultAwaiter& operator = (const ResultAwaiter&);
+
+	bool post(std::coroutine_handle<> handle, CancellationToken::Ptr pToken)
+		/// Queues the resumption of the coroutine on the executor, unless
+		/// there is none or the calling thread belongs to it. Returns false
+		/// if the caller must resume the coroutine itself. The awaiter may
+		/// be gone when this returns true.
+	{
+		if (!_pExecutor || _pExecutor->isExecutorThread()) return false;
+
+		StatementExecutor::Ptr pExecutor = _pExecutor;
+		ResumeJob* pJob = new ResumeJob(handle);
+		pJob->setCancellation(pToken);
+		pExecutor->enqueue(pJob);
+		return true;
+	}
+
+	Start                   _start;
+	StatementExecutor::Ptr  _pExecutor;
+	std::unique_ptr<Result> _pResult;
+	std::atomic<bool>       _done;
+};
+
+
+inline ResultAwaiter<std::size_t> awaitExecution(Statement& statement, StatementExecutor::Ptr pExecutor = 0, bool reset = true)
+	/// Executes the statement asynchronously and returns an awaiter for
+	/// the number of rows it extracted or affected. Deadlines of the
+	/// statement itself are set with Statement::setDeadline().
+{
+	Statement* pStatement = &statement;
+	return ResultAwaiter<std::size_t>([pStatement, reset](const Statement::Continuation& continuation)
+	{
+		pStatement->executeAsync(reset);
+		pStatement->then(continuation);
+	}, pExecutor);
+}
+
+
+class AwaitableSession
+	/// AwaitableSession wraps a Session so that its device
+	/// operations can be awaited in a coroutine:
+	///
+	///     AwaitableSession session(Session("RS", "cs"), executor);
+	///     std::string signature = co_await session.signByP1(message);
+	///
+	/// Each method starts the corresponding xxxAsync() operation of
+	/// the Session when awaited (see ResultAwaiter), so a queued or
+	/// balanced session completes it without blocking a thread.
+{
+public:
+	explicit AwaitableSession(const Session& session, StatementExecutor::Ptr pExecutor = 0):
+		_session(session),
+		_pExecutor(pExecutor)
+	{
+	}
+
+	const Session& session() const
+	{
+		return _session;
+	}
+
+	StatementExecutor::Ptr executor() const
+	{
+		return _pExecutor;
+	}
+
+	// Awaitable counterparts of the device operations of Session.
+	ResultAwaiter<bool> login(const std::string& passwd) const;
+	ResultAwaiter<bool> changePW(const std::string& oldCode, const std::string& newCode) const;
+	ResultAwaiter<std::string> getUserList() const;
+	ResultAwaiter<std::string> getCertBase64String(short ctype) const;
+	ResultAwaiter<int> getPinRetryCount() const;
+	ResultAwaiter<std::string> getCertInfo(const std::string& base64, int type) const;
+	ResultAwaiter<std::string> getSerialNumber() const;
+	ResultAwaiter<std::string> getKeyID() const;
+	ResultAwaiter<std::string> encryptData(const std::string& paintText, const std::string& base64) const;
+	ResultAwaiter<std::string> decryptData(const std::string& encryptBuffer) const;
+	ResultAwaiter<std::string> signByP1(const std::string& message) const;
+	ResultAwaiter<bool> verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature) const;
+	ResultAwaiter<std::string> signByP7(const std::string& textual, int mode) const;
+	ResultAwaiter<bool> verifySignByP7(const std::string& textual, const std::string& signature) const;
+
+private:
+	Session                _session;
+	StatementExecutor::Ptr _pExecutor;
+};
+
+
+//
+// inlines
+//
+inline ResultAwaiter<bool> AwaitableSession::login(const std::string& passwd) const
+{
+	Session session(_session);
+	return ResultAwaiter<bool>([=](const Session::BoolCallback& callback) mutable
+	{
+		session.loginAsync(passwd, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<bool> AwaitableSession::changePW(const std::string& oldCode, const std::string& newCode) const
+{
+	Session session(_session);
+	return ResultAwaiter<bool>([=](const Session::BoolCallback& callback) mutable
+	{
+		session.changePWAsync(oldCode, newCode, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::getUserList() const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.getUserListAsync(callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::getCertBase64String(short ctype) const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.getCertBase64StringAsync(ctype, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<int> AwaitableSession::getPinRetryCount() const
+{
+	Session session(_session);
+	return ResultAwaiter<int>([=](const Session::IntCallback& callback) mutable
+	{
+		session.getPinRetryCountAsync(callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::getCertInfo(const std::string& base64, int type) const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.getCertInfoAsync(base64, type, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::getSerialNumber() const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.getSerialNumberAsync(callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::getKeyID() const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.getKeyIDAsync(callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::encryptData(const std::string& paintText, const std::string& base64) const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.encryptDataAsync(paintText, base64, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::decryptData(const std::string& encryptBuffer) const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.decryptDataAsync(encryptBuffer, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::signByP1(const std::string& message) const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.signByP1Async(message, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<bool> AwaitableSession::verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature) const
+{
+	Session session(_session);
+	return ResultAwaiter<bool>([=](const Session::BoolCallback& callback) mutable
+	{
+		session.verifySignByP1Async(base64, msg, signature, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<std::string> AwaitableSession::signByP7(const std::string& textual, int mode) const
+{
+	Session session(_session);
+	return ResultAwaiter<std::string>([=](const Session::StringCallback& callback) mutable
+	{
+		session.signByP7Async(textual, mode, callback);
+	}, _pExecutor);
+}
+
+
+inline ResultAwaiter<bool> AwaitableSession::verifySignByP7(const std::string& textual, const std::string& signature) const
+{
+	Session session(_session);
+	return ResultAwaiter<bool>([=](const Session::BoolCallback& callback) mutable
+	{
+		session.verifySignByP7Async(textual, signature, callback);
+	}, _pExecutor);
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RDATA_HAVE_COROUTINES
+
+
+#endif // RData_Awaitable_INCLUDED
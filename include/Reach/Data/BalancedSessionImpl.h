@@ -0,0 +1,216 @@
+//
+// BalancedSessionImpl.h
+//
+// Library: Data
+// Package: Execution
+// Module:  BalancedSessionImpl
+//
+// Definition of the BalancedSessionImpl class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_BalancedSessionImpl_INCLUDED
+#define RData_BalancedSessionImpl_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/SessionImpl.h"
+#include "Poco/AutoPtr.h"
+#include "Poco/SharedPtr.h"
+#include <vector>
+#include <atomic>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API BalancedSessionImpl: public SessionImpl
+	/// BalancedSessionImpl spreads the operations of one logical
+	/// session over the sessions of several identical devices.
+	/// The devices must hold the same signing certificate, so that
+	/// every signature verifies against the one getCertBase64String()
+	/// hands out, whichever device created it.
+	///
+	/// signByP1() and signByP7(), as well as the operations that only
+	/// need a public certificate (encryptData(), getCertInfo() and the
+	/// verify functions), are dispatched to the member with the fewest
+	/// outstanding requests; their asynchronous counterparts count as
+	/// outstanding until they complete. decryptData() and decryptFile()
+	/// need the private key belonging to the certificate returned by
+	/// getCertBase64String(), so they always go to the first member. A batch
+	/// operation such as signBatchP1() goes to a single member as a whole,
+	/// keeping its login state and sign method. For throughput to
+	/// scale with the number of devices, every member must execute on
+	/// its own thread, so the SessionFactory builds the members as
+	/// QueuedSessionImpl objects (see SessionFactory::EXEC_BALANCED).
+	///
+	/// open(), close(), login(), changePW() and the timeout, feature and
+	/// property setters are applied to all members. The session counts
+	/// as logged in only while all members are. A transaction holds
+	/// all members. Operations returning
+	/// device specific data (getUserList(), getCertBase64String(),
+	/// getPinRetryCount(), getSerialNumber() and getKeyID()) are answered
+	/// by the first member.
+	///
+	/// Balancing needs a connector supporting it (see
+	/// Connector::supportsBalancing()). The SOF and FJCA connectors
+	/// do not, so this is not available for production keys yet.
+{
+public:
+	typedef std::vector<Poco::AutoPtr<SessionImpl> > Members;
+
+	explicit BalancedSessionImpl(const Members& members);
+		/// Creates the BalancedSessionImpl.
+		/// Throws a Poco::InvalidArgumentException if members is empty
+		/// or if the members report different signing certificates.
+
+	~BalancedSessionImpl();
+		/// Destroys the BalancedSessionImpl.
+
+	// SessionImpl
+	void open(const std::string& connect = "");
+	void close();
+	bool isConnected();
+	bool isAlive();
+	void setConnectionTimeout(std::size_t timeout);
+	std::size_t getConnectionTimeout();
+	const std::string& connectorName() const;
+	const std::string& contianerName() const;
+	bool login(const std::string& passwd);
+	bool isLoggedIn();
+	void invalidateLogin();
+	void setAuthLifetime(std::size_t seconds);
+	void begin();
+	void commit();
+	void rollback();
+	bool changePW(const std::string& oldCode, const std::string& newCode);
+	std::string getUserList();
+	std::string getCertBase64String(short ctype);
+	int getPinRetryCount();
+	std::string getCertInfo(const std::string& base64, int type);
+	std::string getSerialNumber();
+	std::string getKeyID();
+	std::string encryptData(const std::string& paintText, const std::string& base64);
+	std::string decryptData(const std::string& encryptBuffer);
+	std::string signByP1(const std::string& message);
+	bool verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature);
+	std::string signByP7(const std::string& textual, int mode);
+	bool verifySignByP7(const std::string& textual, const std::string& signature);
+	BatchResults signBatchP1(const std::vector<std::string>& messages);
+	BatchResults signBatchP7(const std::vector<std::string>& textuals, int mode);
+	std::string signDigest(const std::string& digest);
+	std::string signFile(const std::string& path);
+	bool verifyFile(const std::string& base64, const std::string& path, const std::string& signature);
+	void setFeature(const std::string& name, bool state);
+	bool getFeature(const std::string& name);
+	void setProperty(const std::string& name, const Poco::Any& value);
+	Poco::Any getProperty(const std::string& name);
+	StringResult getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback = StringCallback());
+	StringResult encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback = StringCallback());
+	StringResult decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback = StringCallback());
+	StringResult signByP1Async(const std::string& message, const StringCallback& callback = StringCallback());
+	BoolResult verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback = BoolCallback());
+	StringResult signByP7Async(const std::string& textual, int mode, const StringCallback& callback = StringCallback());
+	BoolResult verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback = BoolCallback());
+
+	std::size_t members() const;
+		/// Returns the number of member sessions.
+
+	SessionImpl* member(std::size_t index) const;
+		/// Returns the member session at the given index.
+
+	int outstanding(std::size_t index) const;
+		/// Returns the number of requests currently
+		/// executing on the member at the given index.
+
+private:
+	struct Member
+	{
+		Member(Poco::AutoPtr<SessionImpl> pImpl);
+
+		Poco::AutoPtr<SessionImpl> pImpl;
+		std::atomic<int>           outstanding;
+	};
+
+	class Lease
+		/// Holds a member for the duration of one request.
+	{
+	public:
+		Lease(Member& member);
+		~Lease();
+		SessionImpl* operator -> () const;
+
+	private:
+		Lease(const Lease&);
+		Lease& operator = (const Lease&);
+
+		Member& _member;
+	};
+
+	typedef Poco::SharedPtr<Member> MemberPtr;
+	typedef std::vector<MemberPtr>  MemberVec;
+
+	BalancedSessionImpl();
+	BalancedSessionImpl(const BalancedSessionImpl&);
+	BalancedSessionImpl& operator = (const BalancedSessionImpl&);
+
+	MemberPtr select();
+		/// Returns the member with the fewest outstanding requests.
+		/// Ties are broken round robin.
+
+	template <class R>
+	Poco::ActiveResult<R> dispatch(const std::function<Poco::ActiveResult<R>(SessionImpl*, const typename DeviceResultJob<R>::Callback&)>& start,
+		const typename DeviceResultJob<R>::Callback& callback);
+		/// Starts an asynchronous operation on the selected member,
+		/// which counts it as outstanding until it completes.
+
+	template <class R>
+	Poco::ActiveResult<R> dispatch(MemberPtr pMember,
+		const std::function<Poco::ActiveResult<R>(SessionImpl*, const typename DeviceResultJob<R>::Callback&)>& start,
+		const typename DeviceResultJob<R>::Callback& callback);
+		/// Starts an asynchronous operation on the given member.
+
+	SessionImpl* primary() const;
+
+	MemberVec                _members;
+	std::atomic<std::size_t> _next;
+};
+
+
+//
+// inlines
+//
+inline std::size_t BalancedSessionImpl::members() const
+{
+	return _members.size();
+}
+
+
+inline SessionImpl* BalancedSessionImpl::member(std::size_t index) const
+{
+	return _members.at(index)->pImpl;
+}
+
+
+inline int BalancedSessionImpl::outstanding(std::size_t index) const
+{
+	return _members.at(index)->outstanding.load();
+}
+
+
+inline SessionImpl* BalancedSessionImpl::primary() const
+{
+	return _members.front()->pImpl;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_BalancedSessionImpl_INCLUDED
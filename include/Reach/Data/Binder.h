@@ -0,0 +1,194 @@
+//
+// Binder.h
+//
+// Library: Data
+// Package: DataCore
+// Module:  Binder
+//
+// Definition of the Binder class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_Binder_INCLUDED
+#define RData_Binder_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Poco/Types.h"
+#include "Poco/Any.h"
+#include <vector>
+#include <string>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API Binder
+	/// Binder holds the values bound to the placeholders of a statement
+	/// with use(). Values are bound by reference and read on every
+	/// execution, so a statement is re-executed with new values simply
+	/// by changing the bound variables.
+	///
+	/// Bindings are typed and kept in inline storage; only statements
+	/// with more than INLINE_SIZE bindings allocate. For the common
+	/// conversions (%s, %d, %i and %u for strings and integers, %b and
+	/// %c for bool and char) values are formatted straight into the
+	/// arguments of the operations, without boxing them into Poco::Any.
+	/// Other conversions, flags, width and precision fall back to
+	/// Poco::format() (see any()).
+{
+public:
+	enum Type
+	{
+		BD_BOOL,
+		BD_CHAR,
+		BD_INT8,
+		BD_UINT8,
+		BD_INT16,
+		BD_UINT16,
+		BD_INT32,
+		BD_UINT32,
+		BD_INT64,
+		BD_UINT64,
+#ifndef POCO_LONG_IS_64_BIT
+		BD_LONG,
+		BD_ULONG,
+#endif
+		BD_FLOAT,
+		BD_DOUBLE,
+		BD_CSTRING,
+		BD_STRING
+	};
+
+	enum
+	{
+		INLINE_SIZE = 8
+	};
+
+	Binder();
+		/// Creates the Binder.
+
+	~Binder();
+		/// Destroys the Binder.
+
+	void bind(std::size_t pos, const bool& val);
+		/// Binds a boolean.
+
+	void bind(std::size_t pos, const char& val);
+		/// Binds a single character.
+
+	void bind(std::size_t pos, const Poco::Int8& val);
+		/// Binds an Int8.
+
+	void bind(std::size_t pos, const Poco::UInt8& val);
+		/// Binds an UInt8.
+
+	void bind(std::size_t pos, const Poco::Int16& val);
+		/// Binds an Int16.
+
+	void bind(std::size_t pos, const Poco::UInt16& val);
+		/// Binds an UInt16.
+
+	void bind(std::size_t pos, const Poco::Int32& val);
+		/// Binds an Int32.
+
+	void bind(std::size_t pos, const Poco::UInt32& val);
+		/// Binds an UInt32.
+
+	void bind(std::size_t pos, const Poco::Int64& val);
+		/// Binds an Int64.
+
+	void bind(std::size_t pos, const Poco::UInt64& val);
+		/// Binds an UInt64.
+
+#ifndef POCO_LONG_IS_64_BIT
+	void bind(std::size_t pos, const long& val);
+		/// Binds a long.
+
+	void bind(std::size_t pos, const unsigned long& val);
+		/// Binds an unsigned long.
+#endif
+
+	void bind(std::size_t pos, const float& val);
+		/// Binds a float.
+
+	void bind(std::size_t pos, const double& val);
+		/// Binds a double.
+
+	void bind(std::size_t pos, const char* const& pVal);
+		/// Binds a const char ptr.
+
+	void bind(std::size_t pos, const std::string& val);
+		/// Binds a string.
+
+	std::size_t size() const;
+		/// Returns the number of bindings.
+
+	bool empty() const;
+		/// Returns true if nothing is bound.
+
+	Type type(std::size_t pos) const;
+		/// Returns the type of the binding at pos.
+
+	bool append(std::size_t pos, char conversion, std::string& str) const;
+		/// Appends the value bound at pos to str, formatted for the
+		/// given conversion character, and returns true. Returns false,
+		/// leaving str unchanged, if the conversion is not supported
+		/// for the type of the value.
+
+	Poco::Any any(std::size_t pos) const;
+		/// Returns a copy of the value bound at pos.
+
+	void reset();
+		/// Removes all bindings.
+
+private:
+	struct Binding
+	{
+		Type        type;
+		const void* pValue;
+	};
+
+	Binder(const Binder&);
+	Binder& operator = (const Binder&);
+
+	void add(std::size_t pos, Type type, const void* pValue);
+	const Binding& at(std::size_t pos) const;
+
+	Binding              _inline[INLINE_SIZE];
+	std::vector<Binding> _overflow;
+	std::size_t          _size;
+};
+
+
+//
+// inlines
+//
+inline std::size_t Binder::size() const
+{
+	return _size;
+}
+
+
+inline bool Binder::empty() const
+{
+	return _size == 0;
+}
+
+
+inline Binder::Type Binder::type(std::size_t pos) const
+{
+	return at(pos).type;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_Binder_INCLUDED
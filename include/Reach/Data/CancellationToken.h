@@ -0,0 +1,166 @@
+//
+// CancellationToken.h
+//
+// Library: Data
+// Package: Execution
+// Module:  CancellationToken
+//
+// Definition of the CancellationToken class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_CancellationToken_INCLUDED
+#define RData_CancellationToken_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Poco/RefCountedObject.h"
+#include "Poco/AutoPtr.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Timespan.h"
+#include "Poco/Mutex.h"
+#include <atomic>
+#include <string>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API CancellationToken: public Poco::RefCountedObject
+	/// A CancellationToken tells device work that its result is no
+	/// longer wanted, either because the token has been cancelled or
+	/// because its absolute deadline has passed.
+	///
+	/// Cancellation is cooperative: a job that has reached the device
+	/// runs to completion, but jobs still queued for a DeviceWorker or
+	/// a StatementExecutor are dropped when their turn comes, and a
+	/// statement stops before its next operation.
+	///
+	/// The token of the current thread (see Scope) is passed on to the
+	/// jobs the thread submits to a DeviceWorker, and a job makes its
+	/// token current while it runs, so a token set for a statement also
+	/// applies to the device operations the statement executes.
+	///
+	/// A token created with a parent is cancelled with its parent, and
+	/// its deadline is the earlier of the two.
+{
+public:
+	typedef Poco::AutoPtr<CancellationToken> Ptr;
+
+	class Data_API Scope
+		/// Makes a token the current token of the calling
+		/// thread for the lifetime of the Scope:
+		///
+		///     CancellationToken::Ptr pToken = new CancellationToken;
+		///     pToken->setTimeout(Poco::Timespan(2, 0));
+		///     CancellationToken::Scope scope(pToken);
+		///     session.signByP7(text, 1);   // dropped if still queued after 2 seconds
+	{
+	public:
+		explicit Scope(CancellationToken* pToken);
+			/// Makes the token current.
+
+		~Scope();
+			/// Restores the previous token.
+
+	private:
+		Scope();
+		Scope(const Scope&);
+		Scope& operator = (const Scope&);
+
+		CancellationToken* _pPrevious;
+	};
+
+	CancellationToken();
+		/// Creates a CancellationToken without a deadline.
+
+	explicit CancellationToken(Ptr pParent);
+		/// Creates a CancellationToken linked to the given parent,
+		/// which may be null.
+
+	void cancel(const std::string& reason = "");
+		/// Cancels the token. Further calls have no effect.
+
+	void setDeadline(const Poco::Timestamp& deadline);
+		/// Sets the absolute deadline.
+
+	void setTimeout(const Poco::Timespan& timeout);
+		/// Sets the deadline to the given time span from now.
+
+	bool hasDeadline() const;
+		/// Returns true if the token or one of its parents has a deadline.
+
+	Poco::Timestamp deadline() const;
+		/// Returns the earliest deadline of the token and its parents.
+		/// Only valid if hasDeadline() returns true.
+
+	bool isCancelled() const;
+		/// Returns true if the token or one of its parents has been
+		/// cancelled or its deadline has passed.
+
+	void check() const;
+		/// Throws an OperationCancelledException if the token has been
+		/// cancelled, or a DeadlineExceededException if its deadline
+		/// has passed.
+
+	static CancellationToken* current();
+		/// Returns the current token of the calling thread, or null.
+
+	static void checkCurrent();
+		/// Calls check() on the current token, if any.
+
+protected:
+	~CancellationToken();
+
+private:
+	enum
+	{
+		NO_DEADLINE = 0
+	};
+
+	CancellationToken(const CancellationToken&);
+	CancellationToken& operator = (const CancellationToken&);
+
+	Poco::Timestamp::TimeVal earliestDeadline() const;
+
+	Ptr                                   _pParent;
+	std::atomic<bool>                     _cancelled;
+	std::atomic<Poco::Timestamp::TimeVal> _deadline;
+	std::string                           _reason;
+	mutable Poco::FastMutex               _mutex;
+};
+
+
+//
+// inlines
+//
+inline void CancellationToken::setTimeout(const Poco::Timespan& timeout)
+{
+	Poco::Timestamp deadline;
+	deadline += timeout;
+	setDeadline(deadline);
+}
+
+
+inline bool CancellationToken::hasDeadline() const
+{
+	return earliestDeadline() != NO_DEADLINE;
+}
+
+
+inline Poco::Timestamp CancellationToken::deadline() const
+{
+	return Poco::Timestamp(earliestDeadline());
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_CancellationToken_INCLUDED
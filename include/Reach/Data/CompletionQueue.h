@@ -0,0 +1,204 @@
+//
+// CompletionQueue.h
+//
+// Library: Data
+// Package: Execution
+// Module:  CompletionQueue
+//
+// Definition of the CompletionQueue class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_CompletionQueue_INCLUDED
+#define RData_CompletionQueue_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Poco/RefCountedObject.h"
+#include "Poco/AutoPtr.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/ActiveResult.h"
+#include "Poco/Exception.h"
+#include "Poco/Mutex.h"
+#include "Poco/Condition.h"
+#include "Poco/Types.h"
+#include "Poco/Any.h"
+#include <functional>
+#include <vector>
+#include <typeinfo>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API CompletionQueue: public Poco::RefCountedObject
+	/// A CompletionQueue collects the outcomes of asynchronous
+	/// device operations for an application that runs its own
+	/// event loop, e.g. an epoll or select based reactor.
+	///
+	/// The operations run on the workers of their sessions, and the
+	/// callback obtained from callback() records each outcome, together
+	/// with a tag chosen by the application, in the queue:
+	///
+	///     session.signByP1Async(message, pQueue->callback<std::string>(requestId));
+	///
+	/// The queue signals a descriptor (see descriptor()) which the
+	/// application registers for reading in its event loop. When it
+	/// becomes readable, the reactor thread collects the completions
+	/// in batches with drain(), without blocking:
+	///
+	///     CompletionQueue::Completions completions;
+	///     while (pQueue->drain(completions, 64))
+	///     {
+	///         for (const auto& c: completions) reply(c.tag(), c.value<std::string>());
+	///     }
+	///
+	/// The descriptor is signalled once when the queue becomes non-empty,
+	/// not once per completion, and stays readable until the queue has
+	/// been drained, so completions arriving in bursts cost the reactor
+	/// one wake-up.
+	///
+	/// On Linux the descriptor is an eventfd, on other POSIX platforms
+	/// the read end of a pipe. On Windows there is no descriptor, and the
+	/// application waits with wait() instead.
+{
+public:
+	typedef Poco::AutoPtr<CompletionQueue> Ptr;
+
+	class Data_API Completion
+		/// The outcome of an operation: either its
+		/// value or the exception it failed with.
+	{
+	public:
+		Completion(Poco::UInt64 tag, const Poco::Any& value);
+			/// Creates a successful Completion.
+
+		Completion(Poco::UInt64 tag, const Poco::Exception& exc);
+			/// Creates a failed Completion.
+
+		Poco::UInt64 tag() const;
+			/// Returns the tag given to callback().
+
+		bool failed() const;
+			/// Returns true if the operation failed.
+
+		const Poco::Exception* exception() const;
+			/// Returns the exception the operation failed with, or null.
+
+		template <class T>
+		const T& value() const
+			/// Returns the value of the operation. Rethrows the exception
+			/// if the operation failed, and throws a Poco::BadCastException
+			/// if T is not the result type of the operation.
+		{
+			if (!_pException.isNull()) _pException->rethrow();
+			if (_value.type() != typeid(T)) throw Poco::BadCastException("Completion value");
+			return Poco::RefAnyCast<T>(_value);
+		}
+
+	private:
+		Poco::UInt64                     _tag;
+		Poco::Any                        _value;
+		Poco::SharedPtr<Poco::Exception> _pException;
+	};
+
+	typedef std::vector<Completion> Completions;
+
+	CompletionQueue();
+		/// Creates the CompletionQueue and its descriptor.
+		/// Throws a Poco::SystemException if the descriptor
+		/// cannot be created.
+
+	template <class R>
+	std::function<void(const Poco::ActiveResult<R>&)> callback(Poco::UInt64 tag)
+		/// Returns a callback for the xxxAsync() operations of Session
+		/// that records the outcome of the operation under the given tag.
+	{
+		Ptr pQueue(this, true);
+		return [pQueue, tag](const Poco::ActiveResult<R>& result)
+		{
+			if (result.failed())
+				pQueue->post(Completion(tag, *result.exception()));
+			else
+				pQueue->post(Completion(tag, Poco::Any(result.data())));
+		};
+	}
+
+	void post(const Completion& completion);
+		/// Adds the completion to the queue and signals the
+		/// descriptor, unless it has been signalled already.
+
+	std::size_t drain(Completions& completions, std::size_t max = 0);
+		/// Replaces the contents of completions with up to max completions
+		/// (all of them if max is zero), in the order they were posted,
+		/// and returns their number. Does not block. The descriptor is
+		/// reset when the queue has been emptied.
+
+	bool wait(long milliseconds);
+		/// Waits until the queue is not empty or the given time has
+		/// passed, and returns true if the queue is not empty.
+
+	int descriptor() const;
+		/// Returns the descriptor to register for reading,
+		/// or -1 on platforms without one.
+
+	std::size_t size() const;
+		/// Returns the number of completions waiting to be drained.
+
+protected:
+	~CompletionQueue();
+		/// Closes the descriptor and destroys the CompletionQueue.
+
+private:
+	CompletionQueue(const CompletionQueue&);
+	CompletionQueue& operator = (const CompletionQueue&);
+
+	void signal();
+	void reset();
+
+	Completions             _completions;
+	bool                    _signalled;
+	int                     _readFd;
+	int                     _writeFd;
+	mutable Poco::FastMutex _mutex;
+	Poco::Condition         _ready;
+};
+
+
+//
+// inlines
+//
+inline Poco::UInt64 CompletionQueue::Completion::tag() const
+{
+	return _tag;
+}
+
+
+inline bool CompletionQueue::Completion::failed() const
+{
+	return !_pException.isNull();
+}
+
+
+inline const Poco::Exception* CompletionQueue::Completion::exception() const
+{
+	return _pException.get();
+}
+
+
+inline int CompletionQueue::descriptor() const
+{
+	return _readFd;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_CompletionQueue_INCLUDED
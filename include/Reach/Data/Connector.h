@@ -21,6 +21,7 @@
 #include "Reach/Data/Data.h"
 #include "Reach/Data/SessionImpl.h"
 #include "Poco/AutoPtr.h"
+#include <vector>
 
 
 namespace Reach {
@@ -47,6 +48,28 @@ public:
 	virtual Poco::AutoPtr<SessionImpl> createSession(const std::string& connectionString,
 		std::size_t timeout = SessionImpl::LOGIN_TIMEOUT_DEFAULT) = 0;
 		/// Create a SessionImpl object and initialize it with the given connectionString.
+
+	virtual std::vector<std::string> devices();
+		/// Returns the names of all devices currently attached.
+		///
+		/// The default implementation returns an empty vector,
+		/// meaning the connector can not address individual devices.
+
+	virtual Poco::AutoPtr<SessionImpl> createDeviceSession(const std::string& connectionString,
+		std::size_t timeout,
+		const std::string& device);
+		/// Create a SessionImpl object bound to the given device.
+		///
+		/// The default implementation calls createSession() if device is empty
+		/// and throws a Poco::NotImplementedException otherwise.
+
+	virtual bool supportsBalancing() const;
+		/// Returns true if the sessions of the connector can be spread
+		/// across its devices (see SessionFactory::EXEC_BALANCED), i.e. every
+		/// operation of a device session only touches its own device and no
+		/// state shared with the sessions of other devices.
+		///
+		/// The default implementation returns false.
 };
 
 
@@ -43,6 +43,9 @@ POCO_DECLARE_EXCEPTION(Data_API, NoDataException, DataException)
 POCO_DECLARE_EXCEPTION(Data_API, LengthExceededException, DataException)
 POCO_DECLARE_EXCEPTION(Data_API, ConnectionFailedException, DataException)
 POCO_DECLARE_EXCEPTION(Data_API, NotConnectedException, DataException)
+POCO_DECLARE_EXCEPTION(Data_API, LoginFailedException, DataException)
+POCO_DECLARE_EXCEPTION(Data_API, OperationCancelledException, DataException)
+POCO_DECLARE_EXCEPTION(Data_API, DeadlineExceededException, DataException)
 
 
 } } // namespace Poco::Reach
@@ -0,0 +1,169 @@
+//
+// DeviceMonitor.h
+//
+// Library: Data
+// Package: Execution
+// Module:  DeviceMonitor
+//
+// Definition of the DeviceMonitor class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_DeviceMonitor_INCLUDED
+#define RData_DeviceMonitor_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/DeviceWorker.h"
+#include "Poco/BasicEvent.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+#include "Poco/Event.h"
+#include "Poco/Mutex.h"
+#include "Poco/Condition.h"
+#include <functional>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API DeviceMonitor: public Poco::Runnable
+	/// A DeviceMonitor watches a device from a background thread
+	/// and reports when it is plugged in or removed.
+	///
+	/// Presence is determined by a probe function supplied by the
+	/// connector. While the state is stable, the interval between two
+	/// probes doubles up to the maximum interval; after a change, or
+	/// while a thread waits for the device, the minimum interval is used.
+	///
+	/// The events are fired from the monitor thread with the monitor's
+	/// name as argument. By convention, connectors name their monitor
+	/// after their connector key, start it in registerConnector() and
+	/// stop it in unregisterConnector(). The monitor thread must not be
+	/// running when the library is unloaded.
+{
+public:
+	typedef std::function<bool()> Probe;
+	typedef std::function<DeviceWorker::Ptr()> WorkerLocator;
+
+	Poco::BasicEvent<const std::string> deviceConnected;
+		/// Fired when the probe starts reporting the device as present.
+
+	Poco::BasicEvent<const std::string> deviceDisconnected;
+		/// Fired when the probe stops reporting the device as present.
+
+	DeviceMonitor(const std::string& name,
+		const Probe& probe,
+		long minInterval = 10,
+		long maxInterval = 1000);
+		/// Creates the DeviceMonitor. The monitor thread
+		/// is not running until start() is called.
+		/// Intervals are given in milliseconds.
+
+	~DeviceMonitor();
+		/// Stops the monitor and destroys it.
+
+	void start(DeviceWorker::Ptr pWorker = DeviceWorker::Ptr());
+		/// Probes the device once and starts the monitor thread.
+		/// Does nothing if the monitor is already running.
+		///
+		/// If a worker is given, the probes run as jobs on it, so they
+		/// do not interfere with the device operations queued there.
+
+	void start(const WorkerLocator& locator);
+		/// Like start(DeviceWorker::Ptr), but asks the locator for the
+		/// worker before every probe. The locator returns null while the
+		/// device operations do not run on a worker, e.g. in direct mode
+		/// (see SessionFactory::queuedWorker()); the probes then run on
+		/// the monitor thread, like the device operations of any other thread.
+
+	bool isPresent() const;
+		/// Returns true if the device was present at the last probe.
+
+	bool waitForDevice(long milliseconds);
+		/// Waits up to the given number of milliseconds for the device
+		/// to be present. Returns true if the device is present.
+		///
+		/// When called from the monitor thread (i.e. from an event
+		/// handler) or while the monitor is not running, the device is
+		/// probed directly. When called from the worker the probes run
+		/// on, the monitor can not probe, so the device is polled
+		/// directly until it is present or the time is up.
+
+	bool retry(const Probe& attempt, long milliseconds);
+		/// Calls attempt until it returns true or the given number of
+		/// milliseconds is up, e.g. to open a device that is present but
+		/// still busy. Between two attempts, waits for the device to be
+		/// present (see waitForDevice()) and then backs off like the
+		/// monitor: starting with the minimum interval, the pause doubles
+		/// up to the maximum interval. Returns true if an attempt succeeded.
+
+	void wakeUp();
+		/// Makes the monitor probe the device immediately.
+
+	void stop();
+		/// Stops the monitor thread. Waiting threads return
+		/// with the last known state. The monitor can be
+		/// started again.
+
+	const std::string& name() const;
+		/// Returns the name of the monitor.
+
+	long interval() const;
+		/// Returns the current probe interval in milliseconds.
+
+protected:
+	void run();
+
+private:
+	DeviceMonitor();
+	DeviceMonitor(const DeviceMonitor&);
+	DeviceMonitor& operator = (const DeviceMonitor&);
+
+	bool probe();
+		/// Calls the probe function, on the worker if one has been
+		/// given to start(). Exceptions count as absent.
+
+	DeviceWorker::Ptr worker() const;
+		/// Returns the worker the probes run on, or null.
+
+	bool poll(long milliseconds);
+		/// Probes the device every minimum interval until it is
+		/// present or the time is up.
+
+	std::string     _name;
+	Probe           _probe;
+	long            _minInterval;
+	long            _maxInterval;
+	long            _interval;
+	bool            _present;
+	bool            _stopped;
+	int             _waiters;
+	WorkerLocator   _locator;
+	Poco::Event     _wakeUp;
+	Poco::Thread    _thread;
+	mutable
+	Poco::FastMutex _mutex;
+	Poco::Condition _changed;
+};
+
+
+//
+// inlines
+//
+inline const std::string& DeviceMonitor::name() const
+{
+	return _name;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_DeviceMonitor_INCLUDED
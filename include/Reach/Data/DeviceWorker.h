@@ -0,0 +1,693 @@
+//
+// DeviceWorker.h
+//
+// Library: Data
+// Package: Execution
+// Module:  DeviceWorker
+//
+// Definition of the DeviceWorker class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_DeviceWorker_INCLUDED
+#define RData_DeviceWorker_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/CancellationToken.h"
+#include "Poco/RefCountedObject.h"
+#include "Poco/AutoPtr.h"
+#include "Poco/ActiveResult.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+#include "Poco/Event.h"
+#include "Poco/Exception.h"
+#include "Poco/ErrorHandler.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Timespan.h"
+#include "Poco/Types.h"
+#include <functional>
+#include <vector>
+#include <atomic>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API DeviceJob
+	/// A unit of work executed by a DeviceWorker.
+	///
+	/// Jobs are linked intrusively into the worker's submission
+	/// queue, so queueing a job does not allocate.
+	///
+	/// A job may carry a CancellationToken; once the token has been
+	/// cancelled or its deadline has passed, the job is dropped
+	/// instead of being run (see execute()).
+	///
+	/// Every job belongs to a priority class, which the DeviceWorker
+	/// uses to order its queue (see DeviceScheduler). A job gets the
+	/// priority of the thread creating it (see PriorityScope).
+{
+public:
+	enum Priority
+	{
+		PRIO_INTERACTIVE = 0, /// Requests a user is waiting for, e.g. a login.
+		PRIO_NORMAL,          /// The default.
+		PRIO_BULK,            /// Background work, e.g. archive signatures.
+		PRIO_CLASSES
+	};
+
+	class Data_API PriorityScope
+		/// Sets the priority of the jobs created by the calling
+		/// thread for the lifetime of the PriorityScope:
+		///
+		///     DeviceJob::PriorityScope scope(DeviceJob::PRIO_BULK);
+		///     for (...) session.signByP1Async(document);
+	{
+	public:
+		explicit PriorityScope(Priority priority);
+			/// Makes the priority current.
+
+		~PriorityScope();
+			/// Restores the previous priority.
+
+	private:
+		PriorityScope();
+		PriorityScope(const PriorityScope&);
+		PriorityScope& operator = (const PriorityScope&);
+
+		Priority _previous;
+	};
+
+	DeviceJob();
+		/// Creates the DeviceJob with the current priority
+		/// of the calling thread.
+
+	virtual ~DeviceJob();
+		/// Destroys the DeviceJob.
+
+	void execute();
+		/// Runs the job with its token as the current token of the
+		/// thread (see CancellationToken::Scope), or, if the token has
+		/// been cancelled, completes the job with reject() without running it.
+
+	virtual void run() = 0;
+		/// Executes the job. Implementations must not throw;
+		/// failures are reported through the job's result.
+
+	virtual void cancel(const std::string& reason) = 0;
+		/// Completes the job without running it.
+
+	virtual void reject(const Poco::Exception& exc);
+		/// Completes the job with the given exception without
+		/// running it. The default implementation calls cancel()
+		/// with the message of the exception.
+
+	void setCancellation(CancellationToken::Ptr pToken);
+		/// Sets the token of the job.
+
+	CancellationToken::Ptr cancellation() const;
+		/// Returns the token of the job, which may be null.
+
+	void setPriority(Priority priority);
+		/// Sets the priority of the job.
+
+	Priority priority() const;
+		/// Returns the priority of the job.
+
+	static Priority currentPriority();
+		/// Returns the priority of the calling thread, which is
+		/// PRIO_NORMAL unless set with a PriorityScope. While a job
+		/// runs, its priority is the priority of the thread, so jobs
+		/// it submits in turn inherit it.
+
+protected:
+	template <class C, class R>
+	static void invoke(const C& callback, const R& result)
+		/// Calls the callback, reporting exceptions to Poco::ErrorHandler.
+	{
+		try
+		{
+			callback(result);
+		}
+		catch (Poco::Exception& exc)
+		{
+			Poco::ErrorHandler::handle(exc);
+		}
+		catch (std::exception& exc)
+		{
+			Poco::ErrorHandler::handle(exc);
+		}
+		catch (...)
+		{
+			Poco::ErrorHandler::handle();
+		}
+	}
+
+private:
+	DeviceJob(const DeviceJob&);
+	DeviceJob& operator = (const DeviceJob&);
+
+	std::atomic<DeviceJob*> _next;
+	CancellationToken::Ptr  _pToken;
+	Priority                _priority;
+
+	friend class DeviceQueue;
+};
+
+
+template <class R>
+class DeviceResultJob: public DeviceJob
+	/// A DeviceJob computing a value of type R, delivered
+	/// through a Poco::ActiveResult.
+	///
+	/// The optional callback is called with the result as soon as it
+	/// is available, on the thread that completed the job, so callers
+	/// need not block in wait(). Exceptions thrown by the callback go
+	/// to Poco::ErrorHandler.
+{
+public:
+	typedef Poco::ActiveResult<R>               Result;
+	typedef std::function<R()>                  Function;
+	typedef std::function<void(const Result&)> Callback;
+
+	DeviceResultJob(const Function& function, const Callback& callback = Callback()):
+		_function(function),
+		_callback(callback),
+		_result(new Poco::ActiveResultHolder<R>())
+	{
+	}
+
+	const Result& result() const
+	{
+		return _result;
+	}
+
+	void run()
+	{
+		try
+		{
+			_result.data(new R(_function()));
+		}
+		catch (Poco::Exception& exc)
+		{
+			_result.error(exc);
+		}
+		catch (std::exception& exc)
+		{
+			_result.error(exc.what());
+		}
+		catch (...)
+		{
+			_result.error("unknown exception");
+		}
+		complete();
+	}
+
+	void cancel(const std::string& reason)
+	{
+		_result.error(Poco::IllegalStateException(reason));
+		complete();
+	}
+
+	void reject(const Poco::Exception& exc)
+	{
+		_result.error(exc);
+		complete();
+	}
+
+private:
+	void complete()
+	{
+		_result.notify();
+		if (_callback) DeviceJob::invoke(_callback, _result);
+	}
+
+	Function _function;
+	Callback _callback;
+	Result   _result;
+};
+
+
+template <>
+class DeviceResultJob<void>: public DeviceJob
+	/// A DeviceJob without a return value.
+{
+public:
+	typedef Poco::ActiveResult<void>               Result;
+	typedef std::function<void()>                  Function;
+	typedef std::function<void(const Result&)> Callback;
+
+	DeviceResultJob(const Function& function, const Callback& callback = Callback()):
+		_function(function),
+		_callback(callback),
+		_result(new Poco::ActiveResultHolder<void>())
+	{
+	}
+
+	const Result& result() const
+	{
+		return _result;
+	}
+
+	void run()
+	{
+		try
+		{
+			_function();
+		}
+		catch (Poco::Exception& exc)
+		{
+			_result.error(exc);
+		}
+		catch (std::exception& exc)
+		{
+			_result.error(exc.what());
+		}
+		catch (...)
+		{
+			_result.error("unknown exception");
+		}
+		complete();
+	}
+
+	void cancel(const std::string& reason)
+	{
+		_result.error(Poco::IllegalStateException(reason));
+		complete();
+	}
+
+	void reject(const Poco::Exception& exc)
+	{
+		_result.error(exc);
+		complete();
+	}
+
+private:
+	void complete()
+	{
+		_result.notify();
+		if (_callback) DeviceJob::invoke(_callback, _result);
+	}
+
+	Function _function;
+	Callback _callback;
+	Result   _result;
+};
+
+
+class Data_API DeviceHold: public Poco::RefCountedObject
+	/// A DeviceHold parks the thread of a DeviceWorker until it is
+	/// ended, giving the thread that requested it exclusive use
+	/// of the device. See DeviceWorker::hold().
+{
+public:
+	typedef Poco::AutoPtr<DeviceHold> Ptr;
+
+	DeviceHold();
+		/// Creates the DeviceHold.
+
+	void end();
+		/// Lets the worker continue with the jobs queued after
+		/// the hold. Further calls have no effect.
+
+protected:
+	~DeviceHold();
+
+private:
+	DeviceHold(const DeviceHold&);
+	DeviceHold& operator = (const DeviceHold&);
+
+	void enter();
+	void cancel(const std::string& reason);
+	void wait();
+
+	Poco::Event _entered;
+	Poco::Event _released;
+	std::string _reason;
+	bool        _cancelled;
+
+	friend class DeviceWorker;
+	friend class DeviceHoldJob;
+};
+
+
+class Data_API DeviceQueue
+	/// An intrusive, lock-free, multiple-producer single-consumer
+	/// queue of DeviceJob objects.
+	///
+	/// Any number of threads may push(); only the owning worker
+	/// thread may pop().
+{
+public:
+	DeviceQueue();
+		/// Creates an empty DeviceQueue.
+
+	~DeviceQueue();
+		/// Destroys the DeviceQueue. The queue must be empty.
+
+	void push(DeviceJob* pJob);
+		/// Appends the job to the queue. Wait-free.
+
+	DeviceJob* pop();
+		/// Removes and returns the oldest job, or null if the
+		/// queue is empty or a concurrent push has not been
+		/// completely linked yet.
+
+private:
+	class Stub: public DeviceJob
+	{
+	public:
+		void run() { }
+		void cancel(const std::string&) { }
+	};
+
+	DeviceQueue(const DeviceQueue&);
+	DeviceQueue& operator = (const DeviceQueue&);
+
+	std::atomic<DeviceJob*> _head;
+	DeviceJob*              _tail;
+	Stub                    _stub;
+};
+
+
+class Data_API DeviceScheduler
+	/// DeviceScheduler orders the jobs waiting for a DeviceWorker,
+	/// so that interactive requests are not stuck behind bulk work.
+	///
+	/// Jobs of a higher priority class run first. Within a class,
+	/// jobs run earliest deadline first, where the deadline of a job
+	/// is the earlier of the deadline of its token and the time it was
+	/// queued plus the latency target of its class. Jobs without a
+	/// token deadline thus run in the order they were queued, and a
+	/// job with a tight deadline overtakes them.
+	///
+	/// To keep lower classes from starving while higher classes keep
+	/// the device busy, a class that has waited while the starvation
+	/// limit of jobs of higher classes ran is served next.
+	///
+	/// Only the worker thread may push() and pop(); the settings
+	/// may be changed from any thread.
+{
+public:
+	DeviceScheduler();
+		/// Creates an empty DeviceScheduler.
+
+	~DeviceScheduler();
+		/// Destroys the DeviceScheduler. It must be empty.
+
+	void push(DeviceJob* pJob);
+		/// Adds the job.
+
+	DeviceJob* pop();
+		/// Removes and returns the job to run next,
+		/// or null if there is none.
+
+	bool empty() const;
+		/// Returns true if there are no jobs.
+
+	void setStarvationLimit(int limit);
+		/// Sets the number of jobs of higher classes after which
+		/// a waiting lower class is served. Zero or less disables
+		/// starvation protection. The default is 8.
+
+	int getStarvationLimit() const;
+		/// Returns the starvation limit.
+
+	void setLatencyTarget(DeviceJob::Priority priority, const Poco::Timespan& target);
+		/// Sets the latency target of the priority class. The defaults
+		/// are 50 milliseconds for interactive, 1 second for normal and
+		/// 60 seconds for bulk jobs.
+
+	Poco::Timespan getLatencyTarget(DeviceJob::Priority priority) const;
+		/// Returns the latency target of the priority class.
+
+private:
+	struct Entry
+	{
+		Poco::Timestamp::TimeVal due;
+		Poco::UInt64             sequence;
+		DeviceJob*               pJob;
+
+		bool operator < (const Entry& other) const
+			/// Orders entries for a max-heap: the entry
+			/// due first compares greatest.
+		{
+			return due > other.due || (due == other.due && sequence > other.sequence);
+		}
+	};
+
+	typedef std::vector<Entry> Heap;
+
+	DeviceScheduler(const DeviceScheduler&);
+	DeviceScheduler& operator = (const DeviceScheduler&);
+
+	Heap                                  _heaps[DeviceJob::PRIO_CLASSES];
+	int                                   _waited[DeviceJob::PRIO_CLASSES];
+	Poco::UInt64                          _sequence;
+	std::atomic<int>                      _starvationLimit;
+	std::atomic<Poco::Timestamp::TimeVal> _targets[DeviceJob::PRIO_CLASSES];
+};
+
+
+class Data_API DeviceWorker: public Poco::Runnable, public Poco::RefCountedObject
+	/// A DeviceWorker owns one thread that executes all jobs
+	/// submitted for one device.
+	///
+	/// Submitting threads never block on each other: jobs are
+	/// linked into a lock-free queue and the worker is only woken
+	/// up when it is actually sleeping. Every job returns a
+	/// Poco::ActiveResult the caller can wait on, so callers
+	/// can overlap their own work with device I/O.
+	///
+	/// The worker runs the queued jobs by priority class and deadline
+	/// (see DeviceScheduler). Jobs of the same class and deadline, e.g.
+	/// the jobs submitted by one thread, run in submission order.
+{
+public:
+	typedef Poco::AutoPtr<DeviceWorker> Ptr;
+
+	explicit DeviceWorker(const std::string& name);
+		/// Creates the DeviceWorker and starts its thread.
+
+	~DeviceWorker();
+		/// Stops the worker and destroys it. Jobs still queued
+		/// are cancelled. If a job releases the last reference,
+		/// the worker is destroyed on its own thread, which then
+		/// ends after that job.
+
+	template <class R>
+	Poco::ActiveResult<R> submit(const std::function<R()>& function,
+		const typename DeviceResultJob<R>::Callback& callback = typename DeviceResultJob<R>::Callback())
+		/// Queues the function for execution on the worker thread
+		/// and returns its result. The callback, if any, is called
+		/// with the result on the worker thread.
+	{
+		DeviceResultJob<R>* pJob = new DeviceResultJob<R>(function, callback);
+		Poco::ActiveResult<R> result = pJob->result();
+		enqueue(pJob);
+		return result;
+	}
+
+	void enqueue(DeviceJob* pJob);
+		/// Queues the job for execution. Takes ownership of the job.
+		/// If the worker has been stopped, the job is cancelled.
+		/// A job without a token gets the current token of the
+		/// calling thread (see CancellationToken::current()), so
+		/// work for a caller that gave up is dropped before it
+		/// reaches the device.
+
+	bool isWorkerThread() const;
+		/// Returns true if called from the worker thread.
+
+	const std::string& name() const;
+		/// Returns the name of the worker.
+
+	int pending() const;
+		/// Returns the number of jobs queued but not yet started.
+
+	int pending(DeviceJob::Priority priority) const;
+		/// Returns the number of jobs of the given priority
+		/// class queued but not yet started.
+
+	void setStarvationLimit(int limit);
+		/// Sets the starvation limit of the scheduler.
+		/// See DeviceScheduler::setStarvationLimit().
+
+	void setLatencyTarget(DeviceJob::Priority priority, const Poco::Timespan& target);
+		/// Sets the latency target of a priority class.
+		/// See DeviceScheduler::setLatencyTarget().
+
+	void stop();
+		/// Stops the worker after the currently running job.
+		/// Jobs still queued are cancelled.
+
+	DeviceHold::Ptr hold();
+		/// Queues a hold with the priority of the calling thread and waits
+		/// until the worker starts it, then parks the worker thread until
+		/// the returned hold is ended. Meanwhile the calling thread has
+		/// exclusive use of the device, while all other jobs wait in the queue.
+		///
+		/// The hold is scheduled like any other job (see DeviceScheduler),
+		/// so it does not wait for everything queued before it: the jobs
+		/// of a lower class or due later stay queued until the hold is
+		/// ended, while jobs of a higher class or due earlier may run
+		/// before it even if they were queued after it. Only the job
+		/// running at the time and the jobs the calling thread queued
+		/// before with the same priority and CancellationToken are
+		/// guaranteed to be done.
+		/// Must not be called from the worker thread.
+		/// Throws an IllegalStateException if the worker has been stopped.
+
+	template <class R>
+	static R await(Poco::ActiveResult<R> result)
+		/// Waits for the result and returns its value,
+		/// rethrowing the exception the job failed with.
+	{
+		result.wait();
+		if (result.exception()) result.exception()->rethrow();
+		return result.data();
+	}
+
+	static void await(Poco::ActiveResult<void> result);
+		/// Waits for the result, rethrowing the exception
+		/// the job failed with.
+
+protected:
+	void run();
+
+private:
+	DeviceWorker();
+	DeviceWorker(const DeviceWorker&);
+	DeviceWorker& operator = (const DeviceWorker&);
+
+	enum
+	{
+		MAX_TRANSFER = 256
+	};
+
+	DeviceJob* next();
+	void drain();
+
+	std::string       _name;
+	DeviceQueue       _queue;
+	DeviceScheduler   _scheduler;
+	std::atomic<int>  _pending;
+	std::atomic<int>  _classPending[DeviceJob::PRIO_CLASSES];
+	std::atomic<bool> _sleeping;
+	std::atomic<bool> _stopped;
+	Poco::Event       _wakeUp;
+	Poco::Thread      _thread;
+};
+
+
+//
+// inlines
+//
+inline const std::string& DeviceWorker::name() const
+{
+	return _name;
+}
+
+
+inline int DeviceWorker::pending() const
+{
+	return _pending.load();
+}
+
+
+inline void DeviceJob::setCancellation(CancellationToken::Ptr pToken)
+{
+	_pToken = pToken;
+}
+
+
+inline CancellationToken::Ptr DeviceJob::cancellation() const
+{
+	return _pToken;
+}
+
+
+inline void DeviceJob::setPriority(Priority priority)
+{
+	_priority = priority;
+}
+
+
+inline DeviceJob::Priority DeviceJob::priority() const
+{
+	return _priority;
+}
+
+
+inline void DeviceScheduler::setStarvationLimit(int limit)
+{
+	_starvationLimit.store(limit);
+}
+
+
+inline int DeviceScheduler::getStarvationLimit() const
+{
+	return _starvationLimit.load();
+}
+
+
+inline void DeviceScheduler::setLatencyTarget(DeviceJob::Priority priority, const Poco::Timespan& target)
+{
+	poco_assert (priority >= 0 && priority < DeviceJob::PRIO_CLASSES);
+
+	_targets[priority].store(target.totalMicroseconds());
+}
+
+
+inline Poco::Timespan DeviceScheduler::getLatencyTarget(DeviceJob::Priority priority) const
+{
+	poco_assert (priority >= 0 && priority < DeviceJob::PRIO_CLASSES);
+
+	return Poco::Timespan(_targets[priority].load());
+}
+
+
+inline int DeviceWorker::pending(DeviceJob::Priority priority) const
+{
+	poco_assert (priority >= 0 && priority < DeviceJob::PRIO_CLASSES);
+
+	return _classPending[priority].load();
+}
+
+
+inline void DeviceWorker::setStarvationLimit(int limit)
+{
+	_scheduler.setStarvationLimit(limit);
+}
+
+
+inline void DeviceWorker::setLatencyTarget(DeviceJob::Priority priority, const Poco::Timespan& target)
+{
+	_scheduler.setLatencyTarget(priority, target);
+}
+
+
+inline bool DeviceWorker::isWorkerThread() const
+{
+	return Poco::Thread::current() == &_thread;
+}
+
+
+inline void DeviceWorker::await(Poco::ActiveResult<void> result)
+{
+	result.wait();
+	if (result.exception()) result.exception()->rethrow();
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_DeviceWorker_INCLUDED
@@ -0,0 +1,133 @@
+//
+// Extractor.h
+//
+// Library: Data
+// Package: DataCore
+// Module:  Extractor
+//
+// Definition of the Extractor class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_Extractor_INCLUDED
+#define RData_Extractor_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Poco/Types.h"
+#include <vector>
+#include <string>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API Extractor
+	/// Extractor delivers the result rows of a statement into the
+	/// variables supplied with into(), by position: the variable at
+	/// position n receives row n. A std::vector<std::string> receives
+	/// all rows from its position on.
+	///
+	/// Rows are assigned to the variables, so a variable reused across
+	/// executions keeps its capacity and, once large enough, does not
+	/// allocate again. Like Binder, variables are held in inline
+	/// storage and by reference.
+{
+public:
+	typedef std::vector<std::string> Rows;
+
+	enum Type
+	{
+		EX_STRING,
+		EX_BOOL,
+		EX_INT32,
+		EX_INT64,
+		EX_ROWS
+	};
+
+	enum
+	{
+		INLINE_SIZE = 8
+	};
+
+	Extractor();
+		/// Creates the Extractor.
+
+	~Extractor();
+		/// Destroys the Extractor.
+
+	void into(std::size_t pos, std::string& val);
+		/// Receives the row at pos.
+
+	void into(std::size_t pos, bool& val);
+		/// Receives the row at pos, which must be a boolean
+		/// result such as the one of a login or verify command.
+
+	void into(std::size_t pos, Poco::Int32& val);
+		/// Receives the row at pos, which must be an integer.
+
+	void into(std::size_t pos, Poco::Int64& val);
+		/// Receives the row at pos, which must be an integer.
+
+	void into(std::size_t pos, Rows& val);
+		/// Receives all rows from pos on.
+
+	std::size_t size() const;
+		/// Returns the number of variables.
+
+	bool empty() const;
+		/// Returns true if there are no variables.
+
+	std::size_t extract(const Rows& rows) const;
+		/// Delivers the rows to the variables and returns the number
+		/// of rows delivered. Throws a Poco::RangeException if there are
+		/// fewer rows than variables, and a Poco::SyntaxException if a
+		/// row cannot be converted to the type of its variable.
+
+	void reset();
+		/// Removes all variables.
+
+private:
+	struct Extraction
+	{
+		Type  type;
+		void* pValue;
+	};
+
+	Extractor(const Extractor&);
+	Extractor& operator = (const Extractor&);
+
+	void add(std::size_t pos, Type type, void* pValue);
+	const Extraction& at(std::size_t pos) const;
+
+	Extraction              _inline[INLINE_SIZE];
+	std::vector<Extraction> _overflow;
+	std::size_t             _size;
+};
+
+
+//
+// inlines
+//
+inline std::size_t Extractor::size() const
+{
+	return _size;
+}
+
+
+inline bool Extractor::empty() const
+{
+	return _size == 0;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_Extractor_INCLUDED
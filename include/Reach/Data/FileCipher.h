@@ -0,0 +1,160 @@
+//
+// FileCipher.h
+//
+// Library: Data
+// Package: Crypto
+// Module:  FileCipher
+//
+// Definition of the FileCipher class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_FileCipher_INCLUDED
+#define RData_FileCipher_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/StatementExecutor.h"
+#include "Poco/Types.h"
+#include <string>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API FileCipher
+	/// A FileCipher encrypts files on the host with SM4 in CTR mode,
+	/// spreading the work over the threads of a StatementExecutor.
+	///
+	/// The file is split into chunks of equal size, and each chunk is
+	/// encrypted and authenticated on its own, so chunks are processed
+	/// in parallel while the next ones are read, and any part of an
+	/// encrypted file can be decrypted without the rest.
+	///
+	/// An encrypted file consists of a header followed by one frame
+	/// per chunk. All numbers are big-endian.
+	///
+	///     header:  "RDSM4CTR"           8 bytes
+	///              version (1)          1 byte
+	///              reserved             3 bytes
+	///              chunk size           4 bytes
+	///              plain size           8 bytes
+	///              nonce                8 bytes
+	///              key info length      4 bytes
+	///              key info             key info length bytes
+	///     frame:   ciphertext           chunk size bytes, less for the last frame
+	///              MAC                  32 bytes
+	///
+	/// The counter block of the first block of frame i is the nonce
+	/// followed by i * chunk size / 16. The MAC of a frame is the
+	/// HMAC-SM3 of the nonce, the frame index, the plain size and the
+	/// ciphertext, so frames cannot be reordered, truncated or moved to
+	/// another file unnoticed.
+	///
+	/// The key info is stored as given and is meant for the wrapped key,
+	/// see SessionImpl::encryptFile(), which protects the file key with
+	/// the encryption certificate of a device.
+	///
+	/// Requires OpenSSL 1.1.1 or newer for SM4 and SM3.
+{
+public:
+	enum
+	{
+		KEY_SIZE           = 32,
+			/// SM4 key (16 bytes) followed by the MAC key (16 bytes).
+		MAC_SIZE           = 32,
+		DEFAULT_CHUNK_SIZE = 1024*1024
+	};
+
+	explicit FileCipher(const std::string& key, StatementExecutor::Ptr pExecutor = 0);
+		/// Creates the FileCipher with the given key of KEY_SIZE bytes.
+		/// Files are processed on the given executor, or on the default
+		/// executor if none is given. Throws a Poco::InvalidArgumentException
+		/// if the key has the wrong size.
+
+	~FileCipher();
+		/// Destroys the FileCipher and clears the key.
+
+	void setChunkSize(std::size_t chunkSize);
+		/// Sets the chunk size of files encrypted from now on.
+		/// It must be a non-zero multiple of 16 of at most 64 MB.
+
+	std::size_t getChunkSize() const;
+		/// Returns the chunk size of encrypted files.
+
+	void encryptFile(const std::string& inPath, const std::string& outPath, const std::string& keyInfo = "");
+		/// Encrypts the file at inPath into outPath, storing
+		/// the key info in the header.
+
+	void decryptFile(const std::string& inPath, const std::string& outPath);
+		/// Decrypts the file at inPath into outPath. Throws a
+		/// Poco::DataFormatException if the file is not an encrypted
+		/// file or if a frame fails authentication.
+
+	std::string decryptRange(const std::string& path, Poco::UInt64 offset, std::size_t length);
+		/// Decrypts length bytes of plain text, starting at the given
+		/// offset, of the encrypted file, reading only the frames that
+		/// contain them. The result is shorter if the file ends earlier.
+
+	static std::string keyInfo(const std::string& path);
+		/// Returns the key info stored in the header of the encrypted file.
+
+	static Poco::UInt64 plainSize(const std::string& path);
+		/// Returns the size of the plain text of the encrypted file.
+
+	static std::string generateKey();
+		/// Returns a new random key of KEY_SIZE bytes.
+
+private:
+	struct Header
+	{
+		Header();
+
+		Poco::UInt32 chunkSize;
+		Poco::UInt64 plainSize;
+		std::string  nonce;
+		std::string  keyInfo;
+		Poco::UInt64 dataOffset;
+	};
+
+	class Frame;
+
+	enum
+	{
+		WINDOW_PER_THREAD = 2,
+		MAX_CHUNK_SIZE    = 64*1024*1024
+	};
+
+	FileCipher();
+	FileCipher(const FileCipher&);
+	FileCipher& operator = (const FileCipher&);
+
+	void process(std::istream& istr, std::ostream& ostr, const Header& header, bool encrypt);
+	void processFrame(Frame& frame, const Header& header, bool encrypt) const;
+	static Header readHeader(std::istream& istr);
+
+	std::string            _key;
+	std::size_t            _chunkSize;
+	StatementExecutor::Ptr _pExecutor;
+};
+
+
+//
+// inlines
+//
+inline std::size_t FileCipher::getChunkSize() const
+{
+	return _chunkSize;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_FileCipher_INCLUDED
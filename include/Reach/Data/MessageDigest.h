@@ -0,0 +1,123 @@
+//
+// MessageDigest.h
+//
+// Library: Data
+// Package: Crypto
+// Module:  MessageDigest
+//
+// Definition of the MessageDigest class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_MessageDigest_INCLUDED
+#define RData_MessageDigest_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/SignatureVerifier.h"
+#include <string>
+
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API MessageDigest
+	/// A MessageDigest computes on the host the digest that a P1
+	/// signature of the given algorithm signs, so that only the digest
+	/// has to be sent to the device (see Session::signDigest()):
+	///
+	///     MessageDigest digest(SignatureVerifier::ALG_SM3_SM2, session.getCertBase64String(1));
+	///     digest.update(document);
+	///     std::string signature = session.signDigest(digest.digest());
+	///
+	/// For SM2 the digest is SM3(Z || M), where Z is computed from the
+	/// signer ID and the public key of the signer's certificate as
+	/// specified in GM/T 0009, so the signature can be verified like one
+	/// created by Session::signByP1(). For RSA it is the plain SHA-1 or
+	/// SHA-256 hash of the message.
+	///
+	/// The message can be passed in pieces with update(), or read
+	/// from a file with updateFile(), so large documents need not
+	/// be held in memory at once.
+{
+public:
+	explicit MessageDigest(SignatureVerifier::Algorithm algorithm);
+		/// Creates a MessageDigest for an RSA algorithm.
+
+	MessageDigest(SignatureVerifier::Algorithm algorithm, const std::string& certificate,
+		const std::string& userID = SignatureVerifier::DEFAULT_USER_ID);
+		/// Creates a MessageDigest for the given algorithm. For SM2 the
+		/// Base64 encoded certificate of the signer and the signer ID
+		/// are needed to compute Z. Throws a Poco::DataFormatException
+		/// if the certificate cannot be decoded, and a
+		/// NotSupportedException if its key does not fit the algorithm.
+
+	~MessageDigest();
+		/// Destroys the MessageDigest.
+
+	void update(const void* data, std::size_t length);
+		/// Adds the given part of the message.
+
+	void update(const std::string& data);
+		/// Adds the given part of the message.
+
+	void updateFile(const std::string& path);
+		/// Adds the contents of the given file. The file is read in
+		/// large chunks on a separate thread, one chunk ahead of the
+		/// hashing, and is never held in memory as a whole. Throws a
+		/// Poco::FileException if the file cannot be read.
+
+	std::string digest();
+		/// Returns the digest of the message passed so far and
+		/// resets the MessageDigest for the next message.
+
+	void reset();
+		/// Discards the message passed so far.
+
+	SignatureVerifier::Algorithm algorithm() const;
+		/// Returns the signature algorithm.
+
+	std::size_t digestLength() const;
+		/// Returns the length of the digest in bytes.
+
+private:
+	MessageDigest();
+	MessageDigest(const MessageDigest&);
+	MessageDigest& operator = (const MessageDigest&);
+
+	void init();
+
+	SignatureVerifier::Algorithm _algorithm;
+	std::string                  _z;
+	EVP_MD_CTX*                  _pContext;
+};
+
+
+//
+// inlines
+//
+inline void MessageDigest::update(const std::string& data)
+{
+	update(data.data(), data.size());
+}
+
+
+inline SignatureVerifier::Algorithm MessageDigest::algorithm() const
+{
+	return _algorithm;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_MessageDigest_INCLUDED
@@ -0,0 +1,180 @@
+//
+// OperationPlan.h
+//
+// Library: Data
+// Package: DataCore
+// Module:  OperationPlan
+//
+// Definition of the OperationPlan class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_OperationPlan_INCLUDED
+#define RData_OperationPlan_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/SessionImpl.h"
+#include <vector>
+#include <string>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API OperationPlan
+	/// OperationPlan is the compiled form of the command text of a
+	/// Statement: a sequence of operations executed against a SessionImpl.
+	///
+	/// Commands are separated by semicolons or line breaks. A command
+	/// is a keyword followed by its arguments, separated by white space.
+	/// Arguments containing white space, quotes or semicolons must be
+	/// enclosed in single quotes, with a quote inside a quoted argument
+	/// written as two quotes (see quote()). Keywords are case insensitive.
+	///
+	///     Command                          Operation               Result
+	///     login <pin>                      ensureLoggedIn()        "1" or "0"
+	///     sign <message>                   signByP1()              signature
+	///     signp7 <text> [<mode>]           signByP7()              signature
+	///     verify <cert> <message> <sig>    verifySignByP1()        "1" or "0"
+	///     verifyp7 <text> <sig>            verifySignByP7()        "1" or "0"
+	///     encrypt <text> <cert>            encryptData()           cipher text
+	///     decrypt <data>                   decryptData()           plain text
+	///     certinfo <cert> <type>           getCertInfo()           info
+	///     cert <type>                      getCertBase64String()   certificate
+	///     serial                           getSerialNumber()       serial number
+	///     keyid                            getKeyID()              key id
+	///     userlist                         getUserList()           user list
+	///     retries                          getPinRetryCount()      retry count
+	///
+	/// Every operation produces one result row.
+{
+public:
+	enum Command
+	{
+		CMD_LOGIN,
+		CMD_SIGN,
+		CMD_SIGN_P7,
+		CMD_VERIFY,
+		CMD_VERIFY_P7,
+		CMD_ENCRYPT,
+		CMD_DECRYPT,
+		CMD_CERT_INFO,
+		CMD_CERT,
+		CMD_SERIAL,
+		CMD_KEY_ID,
+		CMD_USER_LIST,
+		CMD_RETRIES
+	};
+
+	struct Operation
+	{
+		Command                  command;
+		std::vector<std::string> args;
+	};
+
+	typedef std::vector<Operation>   Operations;
+	typedef std::vector<std::string> Results;
+
+	struct Batch
+		/// State shared by the executions of one batch, see execute().
+	{
+		Batch();
+
+		std::string pin;      /// the PIN verified within the batch
+		bool        loggedIn;
+	};
+
+	OperationPlan();
+		/// Creates an empty OperationPlan.
+
+	explicit OperationPlan(const std::string& text);
+		/// Creates the OperationPlan by parsing the given command text.
+		/// Throws a Poco::SyntaxException if the text is malformed.
+
+	~OperationPlan();
+		/// Destroys the OperationPlan.
+
+	void add(std::vector<std::string>& tokens);
+		/// Appends the operation given by a keyword and its arguments,
+		/// as they appear in command text, and clears tokens.
+		/// Does nothing if tokens is empty. Throws a Poco::SyntaxException
+		/// if the command is unknown or its arguments are malformed.
+
+	void clear();
+		/// Removes all operations.
+
+	std::size_t execute(SessionImpl& session, Results& results) const;
+		/// Runs the operations in order and appends one result per
+		/// operation. Returns the number of operations executed.
+		/// Exceptions thrown by the session are propagated; the results
+		/// of the operations completed before remain in results.
+		/// Before each operation, the current CancellationToken of the
+		/// thread, if any, is checked.
+
+	std::size_t execute(SessionImpl& session, Results& results, Batch& batch) const;
+		/// Runs the operations as one of the argument sets of a batch.
+		/// A login with the PIN already verified within the batch
+		/// yields "1" without consulting the session again.
+
+	const Operations& operations() const;
+		/// Returns the operations.
+
+	std::size_t size() const;
+		/// Returns the number of operations.
+
+	bool empty() const;
+		/// Returns true if the plan has no operations.
+
+	static std::string quote(const std::string& argument);
+		/// Returns the argument enclosed in single quotes,
+		/// for use in command text.
+
+private:
+	static bool lookup(const std::string& keyword, std::size_t args, Command& command);
+	static void check(const Operation& op);
+	static std::string run(SessionImpl& session, const Operation& op, Batch* pBatch);
+
+	Operations _operations;
+
+	friend class StatementTemplate;
+};
+
+
+//
+// inlines
+//
+inline const OperationPlan::Operations& OperationPlan::operations() const
+{
+	return _operations;
+}
+
+
+inline std::size_t OperationPlan::size() const
+{
+	return _operations.size();
+}
+
+
+inline bool OperationPlan::empty() const
+{
+	return _operations.empty();
+}
+
+
+inline void OperationPlan::clear()
+{
+	_operations.clear();
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_OperationPlan_INCLUDED
@@ -0,0 +1,131 @@
+//
+// PooledSessionImpl.h
+//
+// Library: Data
+// Package: SessionPooling
+// Module:  PooledSessionImpl
+//
+// Definition of the PooledSessionImpl class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_PooledSessionImpl_INCLUDED
+#define RData_PooledSessionImpl_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/SessionImpl.h"
+#include "Reach/Data/PooledSessionHolder.h"
+#include "Poco/AutoPtr.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+class SessionPool;
+
+
+class Data_API PooledSessionImpl: public SessionImpl
+	/// PooledSessionImpl is a decorator created by
+	/// SessionPool that adds session pool
+	/// management to SessionImpl objects.
+{
+public:
+	PooledSessionImpl(PooledSessionHolder* pHolder);
+		/// Creates the PooledSessionImpl.
+
+	~PooledSessionImpl();
+		/// Destroys the PooledSessionImpl.
+
+	// SessionImpl
+	void open(const std::string& connect = "");
+	void close();
+	bool isConnected();
+	bool isAlive();
+	void setConnectionTimeout(std::size_t timeout);
+	std::size_t getConnectionTimeout();
+	const std::string& connectorName() const;
+	const std::string& contianerName() const;
+	bool login(const std::string& passwd);
+	bool isLoggedIn();
+	void invalidateLogin();
+	void setAuthLifetime(std::size_t seconds);
+	void begin();
+	void commit();
+	void rollback();
+	bool canTransact();
+	bool isTransaction();
+	SessionImpl* lockDevice();
+	bool changePW(const std::string& oldCode, const std::string& newCode);
+	std::string getUserList();
+	std::string getCertBase64String(short ctype);
+	int getPinRetryCount();
+	std::string getCertInfo(const std::string& base64, int type);
+	std::string getSerialNumber();
+	std::string getKeyID();
+	std::string encryptData(const std::string& paintText, const std::string& base64);
+	std::string decryptData(const std::string& encryptBuffer);
+	std::string signByP1(const std::string& message);
+	bool verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature);
+	std::string signByP7(const std::string& textual, int mode);
+	bool verifySignByP7(const std::string& textual, const std::string& signature);
+	BatchResults signBatchP1(const std::vector<std::string>& messages);
+	BatchResults signBatchP7(const std::vector<std::string>& textuals, int mode);
+	std::string signDigest(const std::string& digest);
+	std::string signFile(const std::string& path);
+	bool verifyFile(const std::string& base64, const std::string& path, const std::string& signature);
+	void setFeature(const std::string& name, bool state);
+	bool getFeature(const std::string& name);
+	void setProperty(const std::string& name, const Poco::Any& value);
+	Poco::Any getProperty(const std::string& name);
+	BoolResult loginAsync(const std::string& passwd, const BoolCallback& callback = BoolCallback());
+	BoolResult changePWAsync(const std::string& oldCode, const std::string& newCode, const BoolCallback& callback = BoolCallback());
+	StringResult getUserListAsync(const StringCallback& callback = StringCallback());
+	StringResult getCertBase64StringAsync(short ctype, const StringCallback& callback = StringCallback());
+	IntResult getPinRetryCountAsync(const IntCallback& callback = IntCallback());
+	StringResult getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback = StringCallback());
+	StringResult getSerialNumberAsync(const StringCallback& callback = StringCallback());
+	StringResult getKeyIDAsync(const StringCallback& callback = StringCallback());
+	StringResult encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback = StringCallback());
+	StringResult decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback = StringCallback());
+	StringResult signByP1Async(const std::string& message, const StringCallback& callback = StringCallback());
+	BoolResult verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback = BoolCallback());
+	StringResult signByP7Async(const std::string& textual, int mode, const StringCallback& callback = StringCallback());
+	BoolResult verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback = BoolCallback());
+
+	SessionImpl* impl() const;
+		/// Returns a pointer to the underlying SessionImpl.
+
+protected:
+	SessionImpl* access() const;
+		/// Updates the last access timestamp,
+		/// verifies validity of the session
+		/// and returns the session if it is valid.
+		///
+		/// Throws an SessionUnavailableException if the
+		/// session is no longer valid.
+
+private:
+	mutable Poco::AutoPtr<PooledSessionHolder> _pHolder;
+};
+
+
+//
+// inlines
+//
+inline SessionImpl* PooledSessionImpl::impl() const
+{
+	return access();
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_PooledSessionImpl_INCLUDED
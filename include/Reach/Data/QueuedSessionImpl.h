@@ -0,0 +1,188 @@
+//
+// QueuedSessionImpl.h
+//
+// Library: Data
+// Package: Execution
+// Module:  QueuedSessionImpl
+//
+// Definition of the QueuedSessionImpl class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_QueuedSessionImpl_INCLUDED
+#define RData_QueuedSessionImpl_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/SessionImpl.h"
+#include "Reach/Data/DeviceWorker.h"
+#include "Poco/AutoPtr.h"
+#include "Poco/ActiveResult.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API QueuedSessionImpl: public SessionImpl
+	/// QueuedSessionImpl is a decorator that executes every
+	/// device operation of the wrapped SessionImpl as a job on
+	/// the DeviceWorker owning the device.
+	///
+	/// The synchronous SessionImpl interface submits the job and
+	/// waits for it; the *Async() member functions return the
+	/// job's result immediately and call their callback on the
+	/// worker thread, so no thread waits for the device. Operations that only read session
+	/// state (names, timeouts, features and properties) are
+	/// forwarded directly.
+	///
+	/// A batch operation such as signBatchP1() runs as a single job,
+	/// so the batch costs one round trip through the queue.
+	///
+	/// begin() holds the worker (see DeviceWorker::hold()); until
+	/// commit() or rollback(), the operations of the calling thread,
+	/// including the *Async() ones and their callbacks, run inline,
+	/// without a round trip through the queue, while all other work
+	/// for the device waits in the queue. lockDevice() therefore
+	/// takes no lock.
+	///
+	/// Jobs carry the current CancellationToken of the submitting
+	/// thread and are dropped if it is cancelled before their turn.
+	///
+	/// QueuedSessionImpl objects are created by the SessionFactory
+	/// for connectors registered with SessionFactory::EXEC_QUEUED.
+{
+public:
+	QueuedSessionImpl(Poco::AutoPtr<SessionImpl> pImpl, DeviceWorker::Ptr pWorker);
+		/// Creates the QueuedSessionImpl.
+
+	~QueuedSessionImpl();
+		/// Destroys the QueuedSessionImpl.
+
+	// SessionImpl
+	void open(const std::string& connect = "");
+	void close();
+	bool isConnected();
+	bool isAlive();
+	void setConnectionTimeout(std::size_t timeout);
+	std::size_t getConnectionTimeout();
+	const std::string& connectorName() const;
+	const std::string& contianerName() const;
+	bool login(const std::string& passwd);
+	bool isLoggedIn();
+	void invalidateLogin();
+	void setAuthLifetime(std::size_t seconds);
+	void begin();
+	void commit();
+	void rollback();
+	SessionImpl* lockDevice();
+	bool changePW(const std::string& oldCode, const std::string& newCode);
+	std::string getUserList();
+	std::string getCertBase64String(short ctype);
+	int getPinRetryCount();
+	std::string getCertInfo(const std::string& base64, int type);
+	std::string getSerialNumber();
+	std::string getKeyID();
+	std::string encryptData(const std::string& paintText, const std::string& base64);
+	std::string decryptData(const std::string& encryptBuffer);
+	std::string signByP1(const std::string& message);
+	bool verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature);
+	std::string signByP7(const std::string& textual, int mode);
+	bool verifySignByP7(const std::string& textual, const std::string& signature);
+	BatchResults signBatchP1(const std::vector<std::string>& messages);
+	BatchResults signBatchP7(const std::vector<std::string>& textuals, int mode);
+	std::string signDigest(const std::string& digest);
+	std::string signFile(const std::string& path);
+	bool verifyFile(const std::string& base64, const std::string& path, const std::string& signature);
+	void setFeature(const std::string& name, bool state);
+	bool getFeature(const std::string& name);
+	void setProperty(const std::string& name, const Poco::Any& value);
+	Poco::Any getProperty(const std::string& name);
+
+	// asynchronous counterparts
+	VoidResult openAsync(const std::string& connect = "");
+	VoidResult closeAsync();
+	BoolResult loginAsync(const std::string& passwd, const BoolCallback& callback = BoolCallback());
+	BoolResult changePWAsync(const std::string& oldCode, const std::string& newCode, const BoolCallback& callback = BoolCallback());
+	StringResult getUserListAsync(const StringCallback& callback = StringCallback());
+	StringResult getCertBase64StringAsync(short ctype, const StringCallback& callback = StringCallback());
+	IntResult getPinRetryCountAsync(const IntCallback& callback = IntCallback());
+	StringResult getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback = StringCallback());
+	StringResult getSerialNumberAsync(const StringCallback& callback = StringCallback());
+	StringResult getKeyIDAsync(const StringCallback& callback = StringCallback());
+	StringResult encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback = StringCallback());
+	StringResult decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback = StringCallback());
+	StringResult signByP1Async(const std::string& message, const StringCallback& callback = StringCallback());
+	BoolResult verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback = BoolCallback());
+	StringResult signByP7Async(const std::string& textual, int mode, const StringCallback& callback = StringCallback());
+	BoolResult verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback = BoolCallback());
+
+	SessionImpl* impl() const;
+		/// Returns a pointer to the underlying SessionImpl.
+
+	DeviceWorker& worker() const;
+		/// Returns the worker executing the device operations.
+
+private:
+	template <class R>
+	R execute(const std::function<R()>& function)
+		/// Runs the function on the worker thread and waits for it.
+		/// Runs it inline when already called from the worker thread
+		/// or from the thread holding the worker in a transaction.
+		/// Fails right away if the current CancellationToken has
+		/// been cancelled; otherwise the job carries the token.
+	{
+		CancellationToken::checkCurrent();
+		if (_pWorker->isWorkerThread() || isTransactionOwner()) return function();
+		return DeviceWorker::await(_pWorker->submit(function));
+	}
+
+	template <class R>
+	Poco::ActiveResult<R> executeAsync(const std::function<R()>& function,
+		const typename DeviceResultJob<R>::Callback& callback = typename DeviceResultJob<R>::Callback())
+		/// Queues the function for the worker thread. Runs it right away
+		/// when called from the thread holding the worker in a
+		/// transaction, which would otherwise wait for itself.
+	{
+		if (isTransactionOwner())
+		{
+			DeviceResultJob<R> job(function, callback);
+			job.setCancellation(CancellationToken::Ptr(CancellationToken::current(), true));
+			job.execute();
+			return job.result();
+		}
+		return _pWorker->submit<R>(function, callback);
+	}
+
+	void release();
+
+	Poco::AutoPtr<SessionImpl> _pImpl;
+	DeviceWorker::Ptr          _pWorker;
+	DeviceHold::Ptr            _pHold;
+};
+
+
+//
+// inlines
+//
+inline SessionImpl* QueuedSessionImpl::impl() const
+{
+	return _pImpl;
+}
+
+
+inline DeviceWorker& QueuedSessionImpl::worker() const
+{
+	return *_pWorker;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_QueuedSessionImpl_INCLUDED
@@ -20,6 +20,7 @@
 
 #include "Reach/Data/Data.h"
 #include "Reach/Data/SessionImpl.h"
+#include "Reach/Data/StatementCreator.h"
 #include "Poco/AutoPtr.h"
 #include "Poco/Any.h"
 #include <algorithm>
@@ -146,6 +147,15 @@ class Data_API Session
 	/// For complete list of supported data types with their respective specifications, see the documentation for format in Foundation.
 {
 public:
+	typedef SessionImpl::StringResult   StringResult;
+	typedef SessionImpl::BoolResult     BoolResult;
+	typedef SessionImpl::IntResult      IntResult;
+	typedef SessionImpl::StringCallback StringCallback;
+	typedef SessionImpl::BoolCallback   BoolCallback;
+	typedef SessionImpl::IntCallback    IntCallback;
+	typedef SessionImpl::BatchResult    BatchResult;
+	typedef SessionImpl::BatchResults   BatchResults;
+
 	static const std::size_t LOGIN_TIMEOUT_DEFAULT = SessionImpl::LOGIN_TIMEOUT_DEFAULT;
 
 	Session(Poco::AutoPtr<SessionImpl> ptrImpl);
@@ -174,6 +184,17 @@ public:
 	void swap(Session& other);
 		/// Swaps the session with another one.
 
+	template <typename T>
+	Statement operator << (const T& t)
+		/// Creates a Statement with the given command text.
+		/// See OperationPlan for the command syntax.
+	{
+		return _statementCreator << t;
+	}
+
+	Poco::SharedPtr<StatementImpl> createStatementImpl();
+		/// Creates a StatementImpl.
+
 	void open(const std::string& connect = "");
 		/// Opens the session using the supplied string.
 		/// Can also be used with default empty string to 
@@ -188,6 +209,9 @@ public:
 	bool isConnected();
 		/// Returns true iff session is connected, false otherwise.
 
+	bool isAlive();
+		/// Returns true if the session is connected and its device is attached.
+
 	void reconnect();
 		/// Closes the session and opens it.
 
@@ -219,6 +243,38 @@ public:
 
 	bool login(const std::string& passwd);
 
+	bool ensureLoggedIn(const std::string& passwd);
+		/// Logs in unless the session is still authenticated.
+		/// See SessionImpl::ensureLoggedIn().
+
+	bool isLoggedIn();
+		/// Returns true if the session is still authenticated.
+
+	void invalidateLogin();
+		/// Forgets a successful login.
+
+	void setAuthLifetime(std::size_t seconds);
+		/// Sets the time a successful login is trusted.
+
+	std::size_t getAuthLifetime() const;
+		/// Returns the authentication lifetime in seconds.
+
+	void begin();
+		/// Starts a transaction, giving the calling thread exclusive
+		/// use of the device. See SessionImpl::begin() and Transaction.
+
+	void commit();
+		/// Ends the transaction.
+
+	void rollback();
+		/// Ends the transaction and forgets the login.
+
+	bool canTransact();
+		/// Returns true if the session supports transactions.
+
+	bool isTransaction();
+		/// Returns true if a transaction is in progress.
+
 	bool changePW(const std::string& oldCode, const std::string& newCode);
 
 	std::string getUserList();
@@ -245,6 +301,91 @@ public:
 
 	bool verifySignByP7(const std::string& textual, const std::string& signature);
 
+	BatchResults signBatchP1(const std::vector<std::string>& messages);
+		/// Signs the messages in one batch. See SessionImpl::signBatchP1().
+
+	BatchResults signBatchP7(const std::vector<std::string>& textuals, int mode);
+		/// Signs the texts in one batch. See SessionImpl::signBatchP7().
+
+	std::string signDigest(const std::string& digest);
+		/// Signs a digest computed on the host. See SessionImpl::signDigest().
+
+	std::string signFile(const std::string& path);
+		/// Signs the contents of the file. See SessionImpl::signFile().
+
+	bool verifyFile(const std::string& base64, const std::string& path, const std::string& signature);
+		/// Verifies a signature of the contents of the file. See SessionImpl::verifyFile().
+
+	void encryptFile(const std::string& inPath, const std::string& outPath);
+		/// Encrypts the file with a key protected by the device. See SessionImpl::encryptFile().
+
+	void decryptFile(const std::string& inPath, const std::string& outPath);
+		/// Decrypts a file created by encryptFile(). See SessionImpl::decryptFile().
+
+	// Asynchronous counterparts of the device operations. Each returns
+	// a future-like result right away; the callback, if any, is called
+	// with the result as soon as it is available, so a server can issue
+	// device operations without a thread waiting for each of them.
+	// See SessionImpl for details.
+
+	BoolResult loginAsync(const std::string& passwd, const BoolCallback& callback = BoolCallback());
+
+	BoolResult changePWAsync(const std::string& oldCode, const std::string& newCode, const BoolCallback& callback = BoolCallback());
+
+	StringResult getUserListAsync(const StringCallback& callback = StringCallback());
+
+	StringResult getCertBase64StringAsync(short ctype, const StringCallback& callback = StringCallback());
+
+	IntResult getPinRetryCountAsync(const IntCallback& callback = IntCallback());
+
+	StringResult getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback = StringCallback());
+
+	StringResult getSerialNumberAsync(const StringCallback& callback = StringCallback());
+
+	StringResult getKeyIDAsync(const StringCallback& callback = StringCallback());
+
+	StringResult encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback = StringCallback());
+
+	StringResult decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback = StringCallback());
+
+	StringResult signByP1Async(const std::string& message, const StringCallback& callback = StringCallback());
+
+	BoolResult verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback = BoolCallback());
+
+	StringResult signByP7Async(const std::string& textual, int mode, const StringCallback& callback = StringCallback());
+
+	BoolResult verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback = BoolCallback());
+
+	void setFeature(const std::string& name, bool state);
+		/// Set the state of a feature.
+		///
+		/// Features are a generic extension mechanism for session implementations.
+		/// and are defined by the underlying SessionImpl instance.
+		///
+		/// Throws a NotSupportedException if the requested feature is
+		/// not supported by the underlying implementation.
+
+	bool getFeature(const std::string& name) const;
+		/// Look up the state of a feature.
+		///
+		/// Throws a NotSupportedException if the requested feature is
+		/// not supported by the underlying implementation.
+
+	void setProperty(const std::string& name, const Poco::Any& value);
+		/// Set the value of a property.
+		///
+		/// Properties are a generic extension mechanism for session implementations.
+		/// and are defined by the underlying SessionImpl instance.
+		///
+		/// Throws a NotSupportedException if the requested property is
+		/// not supported by the underlying implementation.
+
+	Poco::Any getProperty(const std::string& name) const;
+		/// Look up the value of a property.
+		///
+		/// Throws a NotSupportedException if the requested property is
+		/// not supported by the underlying implementation.
+
 	SessionImpl* impl();
 		/// Returns a pointer to the underlying SessionImpl.
 
@@ -252,16 +393,19 @@ private:
 	Session();
 
 	Poco::AutoPtr<SessionImpl> _pImpl;
+	StatementCreator           _statementCreator;
 };
 
 inline void Session::open(const std::string& connect)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	_pImpl->open(connect);
 }
 
 
 inline void Session::close()
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	_pImpl->close();
 }
 
@@ -272,8 +416,15 @@ inline bool Session::isConnected()
 }
 
 
+inline bool Session::isAlive()
+{
+	return _pImpl->isAlive();
+}
+
+
 inline void Session::reconnect()
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	_pImpl->reconnect();
 }
 
@@ -324,76 +475,303 @@ inline std::string Session::uri() const
 	return _pImpl->uri();
 }
 
+inline Poco::SharedPtr<StatementImpl> Session::createStatementImpl()
+{
+	return _pImpl->createStatementImpl();
+}
+
 inline bool Session::login(const std::string& passwd)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->login(passwd);
 }
 
+inline bool Session::ensureLoggedIn(const std::string& passwd)
+{
+	SessionImpl::DeviceGuard guard(*_pImpl);
+	return _pImpl->ensureLoggedIn(passwd);
+}
+
+inline bool Session::isLoggedIn()
+{
+	return _pImpl->isLoggedIn();
+}
+
+inline void Session::invalidateLogin()
+{
+	_pImpl->invalidateLogin();
+}
+
+inline void Session::setAuthLifetime(std::size_t seconds)
+{
+	_pImpl->setAuthLifetime(seconds);
+}
+
+inline std::size_t Session::getAuthLifetime() const
+{
+	return _pImpl->getAuthLifetime();
+}
+
+inline void Session::begin()
+{
+	_pImpl->begin();
+}
+
+inline void Session::commit()
+{
+	_pImpl->commit();
+}
+
+inline void Session::rollback()
+{
+	_pImpl->rollback();
+}
+
+inline bool Session::canTransact()
+{
+	return _pImpl->canTransact();
+}
+
+inline bool Session::isTransaction()
+{
+	return _pImpl->isTransaction();
+}
+
 inline bool Session::changePW(const std::string& oldCode, const std::string& newCode)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->changePW(oldCode, newCode);
 }
 
 inline std::string Session::getUserList()
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->getUserList();
 }
 
 inline std::string Session::getCertBase64String(short ctype)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->getCertBase64String(ctype);
 }
 
 inline int Session::getPinRetryCount()
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->getPinRetryCount();
 }
 
 inline std::string Session::getCertInfo(const std::string& base64, int type)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->getCertInfo(base64, type);
 }
 
 inline std::string Session::getSerialNumber()
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->getSerialNumber();
 }
 
 inline std::string Session::getKeyID()
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->getKeyID();
 }
 
 inline std::string Session::encryptData(const std::string& paintText, const std::string& base64)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->encryptData(paintText, base64);
 }
 
 inline std::string Session::decryptData(const std::string& encryptBuffer)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->decryptData(encryptBuffer);
 }
 
 inline std::string Session::signByP1(const std::string& message)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->signByP1(message);
 }
 
 inline bool Session::verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->verifySignByP1(base64, msg, signature);
 }
 
 inline std::string Session::signByP7(const std::string& textual, int mode)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->signByP7(textual, mode);
 }
 
 inline bool Session::verifySignByP7(const std::string& textual, const std::string& signature)
 {
+	SessionImpl::DeviceGuard guard(*_pImpl);
 	return _pImpl->verifySignByP7(textual, signature);
 }
 
+
+inline Session::BatchResults Session::signBatchP1(const std::vector<std::string>& messages)
+{
+	SessionImpl::DeviceGuard guard(*_pImpl);
+	return _pImpl->signBatchP1(messages);
+}
+
+
+inline Session::BatchResults Session::signBatchP7(const std::vector<std::string>& textuals, int mode)
+{
+	SessionImpl::DeviceGuard guard(*_pImpl);
+	return _pImpl->signBatchP7(textuals, mode);
+}
+
+
+inline std::string Session::signDigest(const std::string& digest)
+{
+	SessionImpl::DeviceGuard guard(*_pImpl);
+	return _pImpl->signDigest(digest);
+}
+
+
+inline std::string Session::signFile(const std::string& path)
+{
+	SessionImpl::DeviceGuard guard(*_pImpl);
+	return _pImpl->signFile(path);
+}
+
+
+inline bool Session::verifyFile(const std::string& base64, const std::string& path, const std::string& signature)
+{
+	SessionImpl::DeviceGuard guard(*_pImpl);
+	return _pImpl->verifyFile(base64, path, signature);
+}
+
+
+inline void Session::encryptFile(const std::string& inPath, const std::string& outPath)
+{
+	SessionImpl::DeviceGuard guard(*_pImpl);
+	_pImpl->encryptFile(inPath, outPath);
+}
+
+
+inline void Session::decryptFile(const std::string& inPath, const std::string& outPath)
+{
+	SessionImpl::DeviceGuard guard(*_pImpl);
+	_pImpl->decryptFile(inPath, outPath);
+}
+
+
+inline Session::BoolResult Session::loginAsync(const std::string& passwd, const BoolCallback& callback)
+{
+	return _pImpl->loginAsync(passwd, callback);
+}
+
+
+inline Session::BoolResult Session::changePWAsync(const std::string& oldCode, const std::string& newCode, const BoolCallback& callback)
+{
+	return _pImpl->changePWAsync(oldCode, newCode, callback);
+}
+
+
+inline Session::StringResult Session::getUserListAsync(const StringCallback& callback)
+{
+	return _pImpl->getUserListAsync(callback);
+}
+
+
+inline Session::StringResult Session::getCertBase64StringAsync(short ctype, const StringCallback& callback)
+{
+	return _pImpl->getCertBase64StringAsync(ctype, callback);
+}
+
+
+inline Session::IntResult Session::getPinRetryCountAsync(const IntCallback& callback)
+{
+	return _pImpl->getPinRetryCountAsync(callback);
+}
+
+
+inline Session::StringResult Session::getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback)
+{
+	return _pImpl->getCertInfoAsync(base64, type, callback);
+}
+
+
+inline Session::StringResult Session::getSerialNumberAsync(const StringCallback& callback)
+{
+	return _pImpl->getSerialNumberAsync(callback);
+}
+
+
+inline Session::StringResult Session::getKeyIDAsync(const StringCallback& callback)
+{
+	return _pImpl->getKeyIDAsync(callback);
+}
+
+
+inline Session::StringResult Session::encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback)
+{
+	return _pImpl->encryptDataAsync(paintText, base64, callback);
+}
+
+
+inline Session::StringResult Session::decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback)
+{
+	return _pImpl->decryptDataAsync(encryptBuffer, callback);
+}
+
+
+inline Session::StringResult Session::signByP1Async(const std::string& message, const StringCallback& callback)
+{
+	return _pImpl->signByP1Async(message, callback);
+}
+
+
+inline Session::BoolResult Session::verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback)
+{
+	return _pImpl->verifySignByP1Async(base64, msg, signature, callback);
+}
+
+
+inline Session::StringResult Session::signByP7Async(const std::string& textual, int mode, const StringCallback& callback)
+{
+	return _pImpl->signByP7Async(textual, mode, callback);
+}
+
+
+inline Session::BoolResult Session::verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback)
+{
+	return _pImpl->verifySignByP7Async(textual, signature, callback);
+}
+
+
+inline void Session::setFeature(const std::string& name, bool state)
+{
+	_pImpl->setFeature(name, state);
+}
+
+
+inline bool Session::getFeature(const std::string& name) const
+{
+	return const_cast<SessionImpl*>(_pImpl.get())->getFeature(name);
+}
+
+
+inline void Session::setProperty(const std::string& name, const Poco::Any& value)
+{
+	_pImpl->setProperty(name, value);
+}
+
+
+inline Poco::Any Session::getProperty(const std::string& name) const
+{
+	return const_cast<SessionImpl*>(_pImpl.get())->getProperty(name);
+}
+
 inline SessionImpl* Session::impl()
 {
 	return _pImpl;
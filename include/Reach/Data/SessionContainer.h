@@ -3,15 +3,34 @@
 #include "Reach/Data/Data.h"
 #include "Reach/Data/Session.h"
 #include "Reach/Data/SessionHolder.h"
-#include "Poco/String.h"
+#include "Reach/Data/DeviceMonitor.h"
 #include "Poco/Mutex.h"
 #include "Poco/AutoPtr.h"
-#include <map>
+#include "Poco/ActiveMethod.h"
+#include "Poco/ActiveResult.h"
+#include "Poco/Timer.h"
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <atomic>
 
 namespace Reach {
 namespace Data {
 
 	class Data_API SessionContainer
+	/// SessionContainer keeps named sessions, one per "connector:///connectionString" name.
+	/// Names are case-insensitive and normalized the way Session::uri() builds
+	/// them, so "key:/connectionString" finds "key:///connectionString".
+	///
+	/// The sessions are indexed in an immutable hash map that is replaced as a whole
+	/// whenever a session is added or removed. The current index is published through
+	/// an atomic pointer; lookups register as readers, load it and hash the name
+	/// case-insensitively in place, so they neither allocate nor wait for each other
+	/// or for the mutex serializing the writers. Readers count themselves in one of
+	/// two epochs, on a counter striped by thread so that concurrent lookups do not
+	/// contend on a single cache line. The writer replacing an index flips the epoch
+	/// twice, waiting each time for the readers of the previous one to finish, and
+	/// then deletes the replaced index at once.
 	{
 	public:
 		static const std::size_t LOGIN_TIMEOUT_DEFAULT = Session::LOGIN_TIMEOUT_DEFAULT;
@@ -45,7 +64,8 @@ namespace Data {
 
 		Session get(const std::string& name);
 		/// Returns the requested Session.
-		/// Throws NotFoundException if session is not found.
+		/// Throws NotFoundException if session is not found
+		/// and SessionUnavailableException if it is marked dead.
 
 		void remove(const std::string& name);
 		/// Removes a Session.
@@ -59,34 +79,128 @@ namespace Data {
 		void shutdown();
 		/// Shuts down all the sessions.
 
+		void watch(DeviceMonitor& monitor);
+		/// Subscribes to the monitor's events. When the device is removed,
+		/// all sessions of the connector the monitor is named after are
+		/// marked dead; when it is plugged in again, they are revived.
+		/// The monitor must outlive the container or be unwatched.
+
+		void unwatch(DeviceMonitor& monitor);
+		/// Unsubscribes from the monitor's events.
+
+		void startLivenessCheck(long interval, bool reopen = false);
+		/// Starts checking all sessions every interval milliseconds, see
+		/// checkLiveness(). Restarts the check if it is already running.
+
+		void stopLivenessCheck();
+		/// Stops the periodic liveness check.
+
+		void checkLiveness(bool reopen = false);
+		/// Probes every session with SessionHolder::checkAlive(), which is
+		/// cheap, so that get() fails at once for sessions whose device is gone.
+		/// If reopen is true, dead sessions are reopened; reopening a session
+		/// whose device is absent blocks for up to its login timeout. Otherwise,
+		/// or if reopening fails, dead sessions are removed from the container.
+
+		Poco::ActiveResult<int> warmUp(const std::vector<std::string>& uris,
+			std::size_t timeout = LOGIN_TIMEOUT_DEFAULT);
+		/// Creates the sessions for the given URIs (in key:///connectionString
+		/// format) concurrently in the background and adds them to the container.
+		/// Sessions already in the container are left alone.
+		///
+		/// The result holds the number of sessions ready once all of them have
+		/// been processed. If any session could not be created, the result fails
+		/// with a SessionUnavailableException listing the failures; the sessions
+		/// that could be created are added nevertheless.
+		/// The container must outlive the warm-up.
+
 	private:
 		typedef Poco::AutoPtr<SessionHolder> SessionHolderPtr;
-		typedef std::map<std::string, SessionHolderPtr, Poco::CILess> SessionMap;
+
+		struct KeyHash
+		{
+			std::size_t operator () (const std::string& name) const;
+		};
+
+		struct KeyEqual
+		{
+			bool operator () (const std::string& name1, const std::string& name2) const;
+		};
+
+		typedef std::unordered_map<std::string, SessionHolderPtr, KeyHash, KeyEqual> SessionIndex;
+
+		enum
+		{
+			READER_STRIPES = 16
+		};
+
+		struct ReaderCount
+			/// A reader counter padded to a cache line of its own.
+		{
+			std::atomic<int> count;
+			char padding[64 - sizeof(std::atomic<int>)];
+		};
+
+		class Snapshot
+			/// Registers a reader of the container and holds the
+			/// current index until it is destroyed.
+		{
+		public:
+			explicit Snapshot(const SessionContainer& container);
+			~Snapshot();
+			const SessionIndex* operator -> () const;
+
+		private:
+			Snapshot(const Snapshot&);
+			Snapshot& operator = (const Snapshot&);
+
+			std::atomic<int>*   _pReaders;
+			const SessionIndex* _pIndex;
+		};
+
+		typedef std::vector<SessionHolderPtr> SessionHolderVec;
+		typedef std::vector<DeviceMonitor*> MonitorVec;
+		typedef std::pair<std::string, std::size_t> WarmUpOne;
+		typedef std::pair<std::vector<std::string>, std::size_t> WarmUpAll;
 
 		SessionContainer(const SessionContainer&);
 		SessionContainer& operator = (const SessionContainer&);
 
-		SessionMap _sessions;
+		void onDeviceConnected(const void* pSender, const std::string& connector);
+		void onDeviceDisconnected(const void* pSender, const std::string& connector);
+		SessionHolderVec holders(const std::string& connector) const;
+		SessionHolderPtr find(const std::string& name) const;
+		void publish(SessionIndex* pIndex);
+		void waitForReaders(int epoch) const;
+		static std::string normalize(const std::string& name);
+		static int readerStripe();
+		void onLivenessTimer(Poco::Timer& timer);
+		bool warmUpOneImpl(const WarmUpOne& arg);
+		int warmUpAllImpl(const WarmUpAll& arg);
+
+		std::atomic<SessionIndex*> _pIndex;
+		mutable ReaderCount _readers[2][READER_STRIPES];
+		std::atomic<int> _epoch;
+		MonitorVec _monitors;
 		Poco::FastMutex _mutex;
+		Poco::Timer _livenessTimer;
+		bool _reopen;
+		Poco::ActiveMethod<bool, WarmUpOne, SessionContainer> _warmUpOne;
+		Poco::ActiveMethod<int, WarmUpAll, SessionContainer> _warmUpAll;
 	};
 
-	inline bool SessionContainer::has(const std::string& name) const
-	{
-		return _sessions.find(name) != _sessions.end();
-	}
-
-	inline void SessionContainer::remove(const std::string& name)
+	inline const SessionContainer::SessionIndex* SessionContainer::Snapshot::operator -> () const
 	{
-		_sessions.erase(name);
+		return _pIndex;
 	}
 
-	inline void SessionContainer::clear()
+	inline bool SessionContainer::has(const std::string& name) const
 	{
-		_sessions.clear();
+		return !find(name).isNull();
 	}
 
 	inline int SessionContainer::count() const
 	{
-		return static_cast<int>(_sessions.size());
+		return static_cast<int>(Snapshot(*this)->size());
 	}
-} } /// namespace Reach::Data
+} } /// namespace Reach::Data
\ No newline at end of file
@@ -21,6 +21,8 @@
 #include "Reach/Data/Data.h"
 #include "Reach/Data/Connector.h"
 #include "Reach/Data/Session.h"
+#include "Reach/Data/DeviceWorker.h"
+#include "Reach/Data/StatementExecutor.h"
 #include "Poco/Mutex.h"
 #include "Poco/SharedPtr.h"
 #include "Poco/String.h"
@@ -50,7 +52,23 @@ class Data_API SessionFactory
 	///      Session ses("SQLite", "dummy.db");
 {
 public:
-	
+	enum ExecutionMode
+	{
+		EXEC_DIRECT,
+			/// Device operations run on the calling thread (default).
+		EXEC_QUEUED,
+			/// Device operations run on one DeviceWorker per device,
+			/// see QueuedSessionImpl.
+		EXEC_BALANCED
+			/// A session is opened on every device reported by
+			/// Connector::devices(), each with its own DeviceWorker,
+			/// and requests are spread across them, see BalancedSessionImpl.
+			/// Only available for connectors supporting it, see
+			/// Connector::supportsBalancing(); the SOF and FJCA
+			/// connectors do not. All devices must hold the same
+			/// signing certificate.
+	};
+
 	static SessionFactory& instance();
 		/// returns the static instance of the singleton.
 
@@ -63,17 +81,57 @@ public:
 		/// Lowers the reference count for the Connector registered under that key. If the count reaches zero,
 		/// the object is removed.
 
+	void setExecutionMode(const std::string& key, ExecutionMode mode);
+		/// Sets the execution mode for sessions subsequently created
+		/// for the Connector registered under that key.
+		/// Throws a Poco::NotFoundException if no Connector is registered for the key,
+		/// and a Poco::NotImplementedException if the mode is EXEC_BALANCED and
+		/// the Connector does not support balancing.
+
+	ExecutionMode getExecutionMode(const std::string& key) const;
+		/// Returns the execution mode of the Connector registered under that key.
+		/// Throws a Poco::NotFoundException if no Connector is registered for the key.
+
+	void setExecutor(const std::string& key, StatementExecutor::Ptr pExecutor);
+		/// Sets the executor running the asynchronous statements of sessions
+		/// subsequently created for the Connector registered under that key.
+		/// If null (default), StatementExecutor::defaultExecutor() is used.
+		/// Throws a Poco::NotFoundException if no Connector is registered for the key.
+
+	StatementExecutor::Ptr getExecutor(const std::string& key) const;
+		/// Returns the executor set for the Connector registered under that key,
+		/// or null if none has been set.
+		/// Throws a Poco::NotFoundException if no Connector is registered for the key.
+
 	Session create(const std::string& key,
 		const std::string& connectionString,
 		std::size_t timeout = Session::LOGIN_TIMEOUT_DEFAULT);
 		/// Creates a Session for the given key with the connectionString. Throws an Poco:Data::UnknownDataBaseException
 		/// if no Connector is registered for that key.
+		///
+		/// In EXEC_QUEUED mode, all sessions of a connector share the DeviceWorker
+		/// of its default device, whatever their connection string, and the session
+		/// is created on the worker thread. In EXEC_BALANCED mode, the same applies
+		/// to every device, and a Poco::NotFoundException is thrown if the connector
+		/// reports no devices. The default device is the first one reported by
+		/// Connector::devices(), so it has one worker in both modes.
 
 	Session create(const std::string& uri,
 		std::size_t timeout = Session::LOGIN_TIMEOUT_DEFAULT);
 		/// Creates a Session for the given URI (must be in key:///connectionString format). 
 		/// Throws a Poco:Data::UnknownDataBaseException if no Connector is registered for the key.
 
+	DeviceWorker::Ptr worker(const std::string& key, const std::string& device = "");
+		/// Returns the DeviceWorker the queued sessions of the Connector registered
+		/// under that key use for the given device, creating it if necessary.
+		/// An empty device name stands for the default device.
+
+	DeviceWorker::Ptr queuedWorker(const std::string& key, const std::string& device = "");
+		/// Returns the worker of the given device like worker() if the sessions
+		/// of the Connector registered under that key run on workers, i.e. its
+		/// execution mode is not EXEC_DIRECT. Returns null otherwise, or if no
+		/// Connector is registered for the key, without creating a worker.
+
 private:
 	SessionFactory();
 	~SessionFactory();
@@ -84,11 +142,30 @@ private:
 	{
 		int cnt;
 		Poco::SharedPtr<Connector> ptrSI;
+		ExecutionMode mode;
+		StatementExecutor::Ptr pExecutor;
 		SessionInfo(Connector* pSI);
 	};
 	
 	typedef std::map<std::string, SessionInfo, Poco::CILess> Connectors;
+	typedef std::map<std::string, DeviceWorker::Ptr, Poco::CILess> Workers;
+
+	DeviceWorker::Ptr getWorker(const std::string& key, const std::string& device);
+		/// Returns the worker of the device, an empty name
+		/// standing for the default device of the connector.
+	Poco::AutoPtr<SessionImpl> createImpl(Poco::SharedPtr<Connector> ptrSI,
+		ExecutionMode mode,
+		const std::string& connectionString,
+		std::size_t timeout);
+	Poco::AutoPtr<SessionImpl> createQueued(Poco::SharedPtr<Connector> ptrSI,
+		DeviceWorker::Ptr pWorker,
+		const std::string& connectionString,
+		std::size_t timeout,
+		const std::string& device);
+
 	Connectors      _connectors;
+	Workers         _workers;
+	mutable
 	Poco::FastMutex _mutex;
 };
 
@@ -3,6 +3,7 @@
 #include "Reach/Data/SessionImpl.h"
 #include "Poco/RefCountedObject.h"
 #include "Poco/AutoPtr.h"
+#include <atomic>
 
 namespace Reach {
 namespace Data {
@@ -36,9 +37,28 @@ namespace Data {
 
 		void shutdown();
 		/// Shuts down the session.
+
+		void markDead();
+		/// Marks the session dead, e.g. because its device has been removed,
+		/// and closes it. SessionContainer does not hand out dead sessions.
+
+		bool revive();
+		/// Reopens a dead session. Returns true if the session is alive
+		/// afterwards, false if reopening failed, another thread is reopening
+		/// it or the session is shut down.
+
+		bool isDead() const;
+		/// Returns true if the session has been marked dead.
+
+		bool checkAlive();
+		/// Probes the session with SessionImpl::isAlive() and marks it
+		/// dead if the probe fails. Returns true if the session is alive.
+
 	private:
 		Poco::AutoPtr<SessionImpl> _pImpl;
-		bool _shutdown;
+		std::atomic<bool> _shutdown;
+		std::atomic<bool> _dead;
+		std::atomic<bool> _reviving;
 	};
 
 	inline std::string SessionHolder::name(const std::string& connector,
@@ -67,4 +87,9 @@ namespace Data {
 		return !_shutdown;
 	}
 
+	inline bool SessionHolder::isDead() const
+	{
+		return _dead;
+	}
+
 } } ///namespace Reach::Data
\ No newline at end of file
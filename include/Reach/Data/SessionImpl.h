@@ -19,10 +19,20 @@
 
 
 #include "Reach/Data/Data.h"
+#include "Reach/Data/StatementExecutor.h"
 #include "Poco/RefCountedObject.h"
+#include "Poco/SharedPtr.h"
 #include "Poco/String.h"
 #include "Poco/Format.h"
 #include "Poco/Any.h"
+#include "Poco/Mutex.h"
+#include "Poco/RWLock.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Thread.h"
+#include "Poco/ActiveResult.h"
+#include "Poco/Exception.h"
+#include <functional>
+#include <vector>
 
 
 namespace Reach {
@@ -30,6 +40,8 @@ namespace Data {
 
 
 class StatementImpl;
+class StatementTemplate;
+class StatementTemplateCache;
 
 
 class Data_API SessionImpl: public Poco::RefCountedObject
@@ -37,6 +49,52 @@ class Data_API SessionImpl: public Poco::RefCountedObject
 	/// SessionImpl objects are noncopyable.
 {
 public:
+	typedef Poco::ActiveResult<std::string>        StringResult;
+	typedef Poco::ActiveResult<bool>               BoolResult;
+	typedef Poco::ActiveResult<int>                IntResult;
+	typedef Poco::ActiveResult<void>               VoidResult;
+	typedef DeviceResultJob<std::string>::Callback StringCallback;
+	typedef DeviceResultJob<bool>::Callback        BoolCallback;
+	typedef DeviceResultJob<int>::Callback         IntCallback;
+
+	struct BatchResult
+		/// The outcome of one item of a batch operation.
+	{
+		BatchResult();
+
+		void setError(const Poco::Exception& exc);
+			/// Records the exception the item failed with.
+
+		bool        failed;  /// True if the item failed.
+		std::string value;   /// The result of the item, e.g. a signature.
+		std::string message; /// The error message, if the item failed.
+		int         code;    /// The error code, if the item failed.
+	};
+
+	typedef std::vector<BatchResult> BatchResults;
+
+	class Data_API DeviceGuard
+		/// DeviceGuard serializes a device operation with the
+		/// transactions on a session (see lockDevice()). Session,
+		/// statements and the default *Async() implementations put
+		/// one around every device operation they run.
+	{
+	public:
+		explicit DeviceGuard(SessionImpl& session);
+			/// Waits while another thread has a transaction
+			/// in progress on the session.
+
+		~DeviceGuard();
+			/// Lets a waiting begin() proceed.
+
+	private:
+		DeviceGuard();
+		DeviceGuard(const DeviceGuard&);
+		DeviceGuard& operator = (const DeviceGuard&);
+
+		SessionImpl* _pLocked;
+	};
+
 	static const std::size_t LOGIN_TIMEOUT_INFINITE = 0;
 		/// Infinite connection/login timeout.
 
@@ -49,6 +107,20 @@ public:
 	static const std::size_t CONNECTION_TIMEOUT_DEFAULT = CONNECTION_TIMEOUT_INFINITE;
 		/// Default connection/login timeout in seconds.
 
+	static const short SIGN_CERTIFICATE = 1;
+		/// The certificate type of the signing certificate,
+		/// see getCertBase64String().
+
+	static const short EXCHANGE_CERTIFICATE = 2;
+		/// The certificate type of the encryption certificate,
+		/// see getCertBase64String().
+
+	static const std::size_t AUTH_LIFETIME_INFINITE = 0;
+		/// A successful login stays valid until it is invalidated.
+
+	static const std::size_t AUTH_LIFETIME_DEFAULT = 300;
+		/// Default authentication lifetime in seconds.
+
 	SessionImpl(const std::string& connectionString,
 		std::size_t timeout = LOGIN_TIMEOUT_DEFAULT);
 		/// Creates the SessionImpl.
@@ -70,6 +142,28 @@ public:
 	virtual bool isConnected() = 0;
 		/// Returns true if session is connected, false otherwise.
 
+	virtual bool isAlive();
+		/// Returns true if the session is connected and its device
+		/// is still attached. Must be cheap, i.e. must not wait for
+		/// the device. The default implementation returns isConnected().
+
+	virtual Poco::SharedPtr<StatementImpl> createStatementImpl();
+		/// Creates a StatementImpl executing its commands
+		/// against this session.
+
+	Poco::SharedPtr<StatementTemplate> statementTemplate(const std::string& text);
+		/// Returns the prepared template for the given command text.
+		/// Templates are cached per session, so statements executing
+		/// the same text share one template and parse it only once.
+
+	void setExecutor(StatementExecutor::Ptr pExecutor);
+		/// Sets the executor running the asynchronous statements
+		/// of this session. If null, the default executor is used.
+
+	StatementExecutor::Ptr getExecutor() const;
+		/// Returns the executor running the asynchronous
+		/// statements of this session.
+
 	void setLoginTimeout(std::size_t timeout);
 		/// Sets the session login timeout value.
 
@@ -90,6 +184,74 @@ public:
 	virtual const std::string& contianerName() const = 0;
 
 	virtual bool login(const std::string& passwd) = 0;
+		/// Verifies the PIN on the device. Implementations record
+		/// the outcome with setLoggedIn().
+
+	bool ensureLoggedIn(const std::string& passwd);
+		/// Calls login() unless isLoggedIn() returns true, in which case
+		/// the device is not accessed at all. The PIN is never stored.
+		/// Returns true if the session is authenticated.
+
+	virtual bool isLoggedIn();
+		/// Returns true if the last login() succeeded, the authentication
+		/// lifetime has not expired and the login has not been invalidated
+		/// since, e.g. by close() or the removal of the device.
+
+	virtual void invalidateLogin();
+		/// Forgets a successful login, so that the next
+		/// ensureLoggedIn() verifies the PIN on the device again.
+
+	virtual void setAuthLifetime(std::size_t seconds);
+		/// Sets the time a successful login is trusted by isLoggedIn().
+		/// AUTH_LIFETIME_INFINITE trusts it until it is invalidated.
+
+	std::size_t getAuthLifetime() const;
+		/// Returns the authentication lifetime in seconds.
+
+	virtual void begin();
+		/// Starts a transaction. The calling thread gets exclusive use
+		/// of the device until it calls commit() or rollback(), so that
+		/// a sequence of operations runs back to back.
+		/// Blocks while another thread has a transaction in progress,
+		/// and until the device operations of other threads that are
+		/// under way are done; further ones wait for the end of the
+		/// transaction (see DeviceGuard).
+		/// Throws an InvalidAccessException if the calling thread
+		/// already has a transaction in progress on this session.
+
+	virtual void commit();
+		/// Ends the transaction and releases the device.
+		/// Throws an InvalidAccessException if the calling thread
+		/// has no transaction in progress.
+
+	virtual void rollback();
+		/// Ends the transaction, releases the device and forgets the
+		/// login. Operations already executed on the device cannot be
+		/// undone; rollback() is meant for sequences that failed and
+		/// may have left the key in an unknown state.
+
+	virtual bool canTransact();
+		/// Returns true if the session supports transactions.
+		/// The default implementation returns true.
+
+	virtual bool isTransaction();
+		/// Returns true if a transaction is in progress.
+
+	bool isTransactionOwner() const;
+		/// Returns true if the calling thread has a transaction in progress.
+
+	virtual SessionImpl* lockDevice();
+		/// Waits until no other thread has a transaction in progress and
+		/// takes a shared lock on the device that keeps begin() waiting,
+		/// unless the calling thread has the transaction in progress.
+		/// Returns the session to pass the lock back to with unlockDevice(),
+		/// or null if no lock was taken. Use a DeviceGuard instead.
+		///
+		/// Sessions forwarding their transactions to another session
+		/// forward lockDevice() as well.
+
+	void unlockDevice();
+		/// Releases the lock taken by lockDevice().
 
 	virtual bool changePW(const std::string& oldCode, const std::string& newCode) = 0;
 
@@ -117,6 +279,134 @@ public:
 
 	virtual bool verifySignByP7(const std::string& textual, const std::string& signature) = 0;
 
+	virtual BatchResults signBatchP1(const std::vector<std::string>& messages);
+		/// Signs each message like signByP1() and returns the results
+		/// in the order of the messages. An item that fails does not stop
+		/// the batch; its result records the error instead. Once the current
+		/// CancellationToken has been cancelled, the remaining items fail.
+		///
+		/// The default implementation calls signByP1() for each message.
+		/// Connectors override it to check the session and select the sign
+		/// method once for the whole batch.
+
+	virtual BatchResults signBatchP7(const std::vector<std::string>& textuals, int mode);
+		/// Signs each text like signByP7(). See signBatchP1().
+
+	virtual std::string signDigest(const std::string& digest);
+		/// Signs a digest computed on the host with a MessageDigest,
+		/// without hashing it again, so that large messages need not be
+		/// sent to the device. The signature verifies like one created
+		/// by signByP1() for the whole message.
+		///
+		/// The default implementation throws a NotSupportedException.
+		/// Connectors whose provider can sign digests override it and
+		/// report so in the "digest" feature. The SOF and FJCA connectors
+		/// do not, because their providers always hash the data themselves.
+
+	virtual std::string signFile(const std::string& path);
+		/// Signs the contents of the given file. The signature verifies
+		/// like one created by signByP1() for the contents.
+		///
+		/// If the session has the "digest" feature, the default implementation
+		/// hashes the file on the host with MessageDigest::updateFile(), without
+		/// holding it in memory, and signs the digest with signDigest(). The
+		/// algorithm follows the key of the signing certificate (see
+		/// SignatureVerifier::algorithmFor()). Otherwise it throws a
+		/// NotSupportedException without reading the file.
+		///
+		/// Connectors whose provider signs files itself override it; the SOF
+		/// and FJCA connectors pass the path to their provider, which reads
+		/// and hashes the whole file.
+
+	virtual bool verifyFile(const std::string& base64, const std::string& path, const std::string& signature);
+		/// Verifies a signature of the contents of the given file with
+		/// the given certificate. The default implementation verifies
+		/// on the host with SignatureVerifier::verifyFile().
+
+	virtual void encryptFile(const std::string& inPath, const std::string& outPath);
+		/// Encrypts the file at inPath into outPath on the host with a
+		/// FileCipher and a new random key. The key is encrypted with
+		/// encryptData() for the encryption certificate of the session
+		/// and stored in the file, so the file can only be decrypted
+		/// with the device holding the matching private key.
+		///
+		/// Only the key goes to the device; the file is processed on
+		/// the threads of the default StatementExecutor.
+
+	virtual void decryptFile(const std::string& inPath, const std::string& outPath);
+		/// Decrypts a file created by encryptFile() into outPath,
+		/// recovering its key with decryptData().
+
+	// asynchronous counterparts
+	//
+	// Each returns the result of the operation right away and calls the
+	// callback, if any, with it as soon as it is available, on the thread
+	// that completed the operation. The current CancellationToken of the
+	// calling thread applies to the operation.
+	//
+	// The default implementations run the synchronous operation on the
+	// executor of the session (see getExecutor()). Sessions that queue
+	// their device operations anyway override them, so that no thread
+	// blocks while the operation waits for the device.
+
+	virtual BoolResult loginAsync(const std::string& passwd, const BoolCallback& callback = BoolCallback());
+
+	virtual BoolResult changePWAsync(const std::string& oldCode, const std::string& newCode, const BoolCallback& callback = BoolCallback());
+
+	virtual StringResult getUserListAsync(const StringCallback& callback = StringCallback());
+
+	virtual StringResult getCertBase64StringAsync(short ctype, const StringCallback& callback = StringCallback());
+
+	virtual IntResult getPinRetryCountAsync(const IntCallback& callback = IntCallback());
+
+	virtual StringResult getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback = StringCallback());
+
+	virtual StringResult getSerialNumberAsync(const StringCallback& callback = StringCallback());
+
+	virtual StringResult getKeyIDAsync(const StringCallback& callback = StringCallback());
+
+	virtual StringResult encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback = StringCallback());
+
+	virtual StringResult decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback = StringCallback());
+
+	virtual StringResult signByP1Async(const std::string& message, const StringCallback& callback = StringCallback());
+
+	virtual BoolResult verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback = BoolCallback());
+
+	virtual StringResult signByP7Async(const std::string& textual, int mode, const StringCallback& callback = StringCallback());
+
+	virtual BoolResult verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback = BoolCallback());
+
+	virtual void setFeature(const std::string& name, bool state) = 0;
+		/// Set the state of a feature.
+		///
+		/// Features are a generic extension mechanism for session implementations.
+		/// and are defined by the underlying SessionImpl instance.
+		///
+		/// Throws a NotSupportedException if the requested feature is
+		/// not supported by the underlying implementation.
+
+	virtual bool getFeature(const std::string& name) = 0;
+		/// Look up the state of a feature.
+		///
+		/// Throws a NotSupportedException if the requested feature is
+		/// not supported by the underlying implementation.
+
+	virtual void setProperty(const std::string& name, const Poco::Any& value) = 0;
+		/// Set the value of a property.
+		///
+		/// Properties are a generic extension mechanism for session implementations.
+		/// and are defined by the underlying SessionImpl instance.
+		///
+		/// Throws a NotSupportedException if the requested property is
+		/// not supported by the underlying implementation.
+
+	virtual Poco::Any getProperty(const std::string& name) = 0;
+		/// Look up the value of a property.
+		///
+		/// Throws a NotSupportedException if the requested property is
+		/// not supported by the underlying implementation.
+
 	const std::string& connectionString() const;
 		/// Returns the connection string.
 
@@ -132,19 +422,79 @@ protected:
 		/// disconnetced sessions. Throws InvalidAccessException when called on
 		/// a connected session.
 
+	void setLoggedIn(bool loggedIn);
+		/// Records the outcome of a login. Must be called with false
+		/// whenever the device may have dropped the authentication.
+
+	void endTransaction();
+		/// Releases the transaction of the calling thread.
+
+	template <class R>
+	Poco::ActiveResult<R> submit(const std::function<R()>& function, const typename DeviceResultJob<R>::Callback& callback)
+		/// Runs the function on the executor of the session, under the
+		/// current CancellationToken of the calling thread and a DeviceGuard.
+		/// Runs it right away when called from the thread having a
+		/// transaction in progress, which would otherwise wait for itself.
+	{
+		if (isTransactionOwner())
+		{
+			DeviceResultJob<R> job(function, callback);
+			job.setCancellation(CancellationToken::Ptr(CancellationToken::current(), true));
+			job.execute();
+			return job.result();
+		}
+
+		Poco::AutoPtr<SessionImpl> pThis(this, true);
+		DeviceResultJob<R>* pJob = new DeviceResultJob<R>([pThis, function]() -> R
+			{
+				DeviceGuard guard(*pThis);
+				return function();
+			}, callback);
+		pJob->setCancellation(CancellationToken::Ptr(CancellationToken::current(), true));
+		Poco::ActiveResult<R> result = pJob->result();
+		getExecutor()->enqueue(pJob);
+		return result;
+	}
+
 private:
 	SessionImpl();
 	SessionImpl(const SessionImpl&);
 	SessionImpl& operator = (const SessionImpl&);
 
-	std::string _connectionString;
-	std::size_t _loginTimeout;
+	std::string        _connectionString;
+	std::size_t        _loginTimeout;
+	std::size_t        _authLifetime;
+	bool               _loggedIn;
+	Poco::Timestamp    _loginTime;
+	bool               _transaction;
+	Poco::Thread::TID  _transactionOwner;
+	Poco::RWLock       _deviceLock;
+	Poco::SharedPtr<StatementTemplateCache> _pTemplates;
+	StatementExecutor::Ptr _pExecutor;
+	mutable
+	Poco::FastMutex    _stateMutex;
 };
 
 
 //
 // inlines
 //
+inline SessionImpl::BatchResult::BatchResult():
+	failed(false),
+	code(0)
+{
+}
+
+
+inline void SessionImpl::BatchResult::setError(const Poco::Exception& exc)
+{
+	failed = true;
+	value.clear();
+	message = exc.displayText();
+	code = exc.code();
+}
+
+
 inline const std::string& SessionImpl::connectionString() const
 {
 	return _connectionString;
@@ -163,6 +513,13 @@ inline std::size_t SessionImpl::getLoginTimeout() const
 }
 
 
+inline std::size_t SessionImpl::getAuthLifetime() const
+{
+	Poco::FastMutex::ScopedLock lock(_stateMutex);
+	return _authLifetime;
+}
+
+
 inline std::string SessionImpl::uri(const std::string& connector,
 	const std::string& connectionString)
 {
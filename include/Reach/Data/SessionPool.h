@@ -0,0 +1,277 @@
+//
+// SessionPool.h
+//
+// Library: Data
+// Package: SessionPooling
+// Module:  SessionPool
+//
+// Definition of the SessionPool class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_SessionPool_INCLUDED
+#define RData_SessionPool_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/PooledSessionHolder.h"
+#include "Reach/Data/PooledSessionImpl.h"
+#include "Reach/Data/Session.h"
+#include "Poco/HashMap.h"
+#include "Poco/Any.h"
+#include "Poco/Timer.h"
+#include "Poco/Mutex.h"
+#include "Poco/Condition.h"
+#include <list>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API SessionPool: public Poco::RefCountedObject
+	/// This class implements session pooling for RData.
+	///
+	/// Creating a connection to a device is often a time consuming
+	/// operation. Therefore it makes sense to reuse a session object
+	/// once it is no longer needed.
+	///
+	/// A SessionPool manages a collection of SessionImpl objects
+	/// (decorated with a PooledSessionImpl).
+	///
+	/// When a SessionImpl object is requested, the SessionPool first
+	/// looks in its set of already initialized SessionImpl for an
+	/// available object. If one is found, it is returned to the
+	/// client and marked as "in-use". If no SessionImpl is available,
+	/// the SessionPool attempts to create a new one for the client.
+	/// To avoid excessive creation of SessionImpl objects, a limit
+	/// can be set on the maximum number of objects.
+	/// Sessions found not to be connected to the device are purged
+	/// from the pool whenever one of the following events occurs:
+	///
+	///   - JanitorTimer event
+	///   - get() request
+	///   - putBack() request
+	///
+	/// Not connected idle sessions can not exist.
+	///
+	/// Usage example:
+	///
+	///     SessionPool pool("SOF", "key");
+	///     ...
+	///     Session sess(pool.get());
+	///     ...
+	///
+	/// Sessions handed out by the pool have already been opened and
+	/// probed by the connector (device open, container lookup and
+	/// algorithm selection), so a get() on a warm pool costs no
+	/// device round-trip.
+	///
+	/// When the pool is exhausted, get() throws immediately while
+	/// get(milliseconds) waits for a session to be returned to the
+	/// pool, providing back-pressure to the callers.
+{
+public:
+	SessionPool(const std::string& connector,
+		const std::string& connectionString,
+		int minSessions = 1,
+		int maxSessions = 32,
+		int idleTime = 60);
+		/// Creates the SessionPool for sessions with the given connector
+		/// and connectionString.
+		///
+		/// The pool allows for at most maxSessions sessions to be created.
+		/// If a session has been idle for more than idleTime seconds, and more than
+		/// minSessions sessions are in the pool, the session is automatically destroyed.
+		///
+		/// The constructor opens minSessions sessions right away, so the first
+		/// requests do not wait for the device. If opening fails, e.g. because
+		/// the device is not attached yet, the remaining sessions are opened
+		/// on demand. Features, properties and customizeSession() are applied
+		/// to these sessions when the first session is handed out.
+
+	~SessionPool();
+		/// Destroys the SessionPool.
+
+	Session get();
+		/// Returns a Session.
+		///
+		/// If there are unused sessions available, one of the
+		/// unused sessions is recycled. Otherwise, a new session
+		/// is created.
+		///
+		/// If the maximum number of sessions for this pool has
+		/// already been created, a SessionPoolExhaustedException
+		/// is thrown.
+
+	Session get(long milliseconds);
+		/// Returns a Session.
+		///
+		/// Behaves like get(), except that if the maximum number
+		/// of sessions has already been created, waits up to
+		/// milliseconds for a session to be returned to the pool
+		/// before a SessionPoolExhaustedException is thrown.
+
+	template <typename T>
+	Session get(const std::string& name, const T& value)
+		/// Returns a Session with requested property set.
+		/// The property can be different from the default pool
+		/// value, in which case it is reset back to the pool
+		/// value when the session is reused.
+	{
+		Session s = get();
+		SessionImpl* pImpl = static_cast<PooledSessionImpl*>(s.impl())->impl();
+		{
+			Poco::Mutex::ScopedLock lock(_mutex);
+			_addPropertyMap.insert(AddPropertyMap::value_type(pImpl,
+				std::make_pair(name, s.getProperty(name))));
+		}
+		s.setProperty(name, value);
+
+		return s;
+	}
+
+	Session get(const std::string& name, bool value);
+		/// Returns a Session with requested feature set.
+		/// The feature can be different from the default pool
+		/// value, in which case it is reset back to the pool
+		/// value when the session is reused.
+
+	int capacity() const;
+		/// Returns the maximum number of sessions the SessionPool will manage.
+
+	int used() const;
+		/// Returns the number of sessions currently in use.
+
+	int idle() const;
+		/// Returns the number of idle sessions.
+
+	int dead();
+		/// Returns the number of not connected active sessions.
+
+	int allocated() const;
+		/// Returns the number of allocated sessions.
+
+	int available() const;
+		/// Returns the number of available (idle + remaining capacity) sessions.
+
+	std::string name() const;
+		/// Returns the name for this pool.
+
+	static std::string name(const std::string& connector,
+		const std::string& connectionString);
+		/// Returns the name formatted from supplied arguments as "connector:///connectionString".
+
+	void setFeature(const std::string& name, bool state);
+		/// Sets feature for all the sessions.
+		/// Throws InvalidAccessException once a session was handed out.
+
+	bool getFeature(const std::string& name);
+		/// Returns the requested feature.
+
+	void setProperty(const std::string& name, const Poco::Any& value);
+		/// Sets property for all sessions.
+		/// Throws InvalidAccessException once a session was handed out.
+
+	Poco::Any getProperty(const std::string& name);
+		/// Returns the requested property.
+
+	void shutdown();
+		/// Shuts down the session pool.
+
+	bool isActive() const;
+		/// Returns true if session pool is active (not shut down).
+
+protected:
+	virtual void customizeSession(Session& session);
+		/// Can be overridden by subclass to perform custom initialization
+		/// of a newly created database session.
+		///
+		/// The default implementation does nothing.
+
+	typedef Poco::AutoPtr<PooledSessionHolder>    PooledSessionHolderPtr;
+	typedef Poco::AutoPtr<PooledSessionImpl>      PooledSessionImplPtr;
+	typedef std::list<PooledSessionHolderPtr>     SessionList;
+	typedef Poco::HashMap<std::string, bool>      FeatureMap;
+	typedef Poco::HashMap<std::string, Poco::Any> PropertyMap;
+
+	void purgeDeadSessions();
+	int deadImpl(SessionList& rSessions);
+	void applySettings(SessionImpl* pImpl);
+	void putBack(PooledSessionHolderPtr pHolder);
+	void onJanitorTimer(Poco::Timer&);
+
+private:
+	typedef std::pair<std::string, Poco::Any> PropertyPair;
+	typedef std::pair<std::string, bool> FeaturePair;
+	typedef std::map<SessionImpl*, PropertyPair> AddPropertyMap;
+	typedef std::map<SessionImpl*, FeaturePair> AddFeatureMap;
+
+	SessionPool(const SessionPool&);
+	SessionPool& operator = (const SessionPool&);
+
+	Session getImpl();
+		/// Hands out an idle session, creating one if capacity allows.
+		/// Must be called with the mutex held; sessions are created and
+		/// opened with the mutex released.
+
+	void configure();
+		/// Applies the settings to the sessions opened by the constructor
+		/// and freezes them. Must be called with the mutex held.
+
+	void prepare(Session& session);
+		/// Applies the settings and customizeSession() to the session.
+
+	void closeAll(SessionList& sessionList);
+
+	std::string    _connector;
+	std::string    _connectionString;
+	int            _minSessions;
+	int            _maxSessions;
+	int            _idleTime;
+	int            _nSessions;
+	SessionList    _idleSessions;
+	SessionList    _activeSessions;
+	Poco::Timer    _janitorTimer;
+	FeatureMap     _featureMap;
+	PropertyMap    _propertyMap;
+	bool           _shutdown;
+	bool           _configured;
+	AddPropertyMap _addPropertyMap;
+	AddFeatureMap  _addFeatureMap;
+	Poco::Condition _sessionReturned;
+	mutable
+	Poco::Mutex    _mutex;
+
+	friend class PooledSessionImpl;
+};
+
+
+inline std::string SessionPool::name(const std::string& connector,
+	const std::string& connectionString)
+{
+	return Session::uri(connector, connectionString);
+}
+
+
+inline std::string SessionPool::name() const
+{
+	return name(_connector, _connectionString);
+}
+
+
+inline bool SessionPool::isActive() const
+{
+	return !_shutdown;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_SessionPool_INCLUDED
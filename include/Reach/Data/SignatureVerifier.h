@@ -0,0 +1,193 @@
+//
+// SignatureVerifier.h
+//
+// Library: Data
+// Package: Crypto
+// Module:  SignatureVerifier
+//
+// Definition of the SignatureVerifier class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_SignatureVerifier_INCLUDED
+#define RData_SignatureVerifier_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/StatementExecutor.h"
+#include "Poco/RefCountedObject.h"
+#include "Poco/AutoPtr.h"
+#include "Poco/Mutex.h"
+#include <string>
+#include <vector>
+#include <map>
+
+
+typedef struct evp_pkey_st EVP_PKEY;
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API SignatureVerifier: public Poco::RefCountedObject
+	/// A SignatureVerifier checks P1 signatures, as created by
+	/// Session::signByP1(), on the host with OpenSSL instead of the
+	/// device provider.
+	///
+	/// Verification needs only the signer's certificate, so it does not
+	/// have to wait for a device and can run on any number of threads.
+	/// verifyBatch() spreads a batch of verifications over the threads of
+	/// a StatementExecutor:
+	///
+	///     SignatureVerifier::Ptr pVerifier = new SignatureVerifier(SignatureVerifier::ALG_SM3_SM2);
+	///     SignatureVerifier::Results results = pVerifier->verifyBatch(requests);
+	///
+	/// Certificates and signatures are Base64 encoded, as returned by
+	/// Session::getCertBase64String() and Session::signByP1(). The public
+	/// keys of recently used certificates are cached, so re-verifying
+	/// many signatures of the same signer parses its certificate once.
+	///
+	/// SM2 signatures are checked with the signer ID set with setUserID(),
+	/// by default the ID of GM/T 0009, and may be DER encoded or the
+	/// plain 64 byte concatenation of r and s.
+	///
+	/// Requires OpenSSL 1.1.1 or newer for SM2 and SM3.
+{
+public:
+	typedef Poco::AutoPtr<SignatureVerifier> Ptr;
+
+	enum Algorithm
+		/// The signature algorithms, with the values
+		/// of the SGD_ constants of GM/T 0006.
+	{
+		ALG_SHA1_RSA   = 0x00010002,
+		ALG_SHA256_RSA = 0x00010004,
+		ALG_SM3_SM2    = 0x00020201
+	};
+
+	struct Data_API Request
+		/// A signature to verify.
+	{
+		Request();
+		Request(const std::string& certificate, const std::string& message, const std::string& signature);
+
+		std::string certificate; /// the Base64 encoded certificate of the signer
+		std::string message;     /// the signed message
+		std::string signature;   /// the Base64 encoded signature
+	};
+
+	struct Data_API Result
+		/// The outcome of a verification.
+	{
+		Result();
+
+		bool        valid; /// true if the signature is valid
+		std::string error; /// why the signature could not be checked, if so
+	};
+
+	typedef std::vector<Request> Requests;
+	typedef std::vector<Result>  Results;
+
+	explicit SignatureVerifier(Algorithm algorithm, StatementExecutor::Ptr pExecutor = 0);
+		/// Creates the SignatureVerifier for the given algorithm.
+		/// Batches run on the given executor, or on the
+		/// default executor if none is given.
+
+	bool verify(const std::string& certificate, const std::string& message, const std::string& signature);
+		/// Verifies the signature on the calling thread. Returns false if
+		/// the signature does not match. Throws a Poco::DataFormatException
+		/// if the certificate cannot be decoded, and a NotSupportedException
+		/// if its key does not fit the algorithm.
+
+	bool verifyDigest(const std::string& certificate, const std::string& digest, const std::string& signature);
+		/// Verifies a signature of a message, given the digest of the
+		/// message as computed by a MessageDigest for the algorithm and
+		/// the certificate. Throws like verify().
+
+	bool verifyFile(const std::string& certificate, const std::string& path, const std::string& signature);
+		/// Verifies a signature of the contents of the given file,
+		/// reading the file in chunks with MessageDigest::updateFile().
+		/// Throws like verify(), and a Poco::FileException if the file
+		/// cannot be read.
+
+	Results verifyBatch(const Requests& requests);
+		/// Verifies the signatures on the executor threads and returns
+		/// their results in the order of the requests. A request that
+		/// cannot be checked gets its error set instead of failing
+		/// the batch. Small batches, and batches started from an
+		/// executor thread, are verified on the calling thread.
+
+	void setUserID(const std::string& id);
+		/// Sets the signer ID of SM2 signatures. Must not
+		/// be called while verifications are running.
+
+	const std::string& getUserID() const;
+		/// Returns the signer ID of SM2 signatures.
+
+	Algorithm algorithm() const;
+		/// Returns the signature algorithm.
+
+	static Algorithm algorithmFor(const std::string& certificate);
+		/// Returns the algorithm for signatures of the given Base64
+		/// encoded certificate's key: ALG_SM3_SM2 for SM2 keys and
+		/// ALG_SHA256_RSA for RSA keys. Throws a NotSupportedException
+		/// for other keys.
+
+	static const std::string DEFAULT_USER_ID;
+		/// The default signer ID of SM2 signatures, "1234567812345678".
+
+protected:
+	~SignatureVerifier();
+		/// Releases the cached keys and destroys the SignatureVerifier.
+
+private:
+	enum
+	{
+		MIN_PARALLEL_BATCH = 16,
+		JOBS_PER_THREAD    = 4,
+		MAX_CACHED_KEYS    = 256
+	};
+
+	typedef std::map<std::string, EVP_PKEY*> KeyMap;
+
+	SignatureVerifier();
+	SignatureVerifier(const SignatureVerifier&);
+	SignatureVerifier& operator = (const SignatureVerifier&);
+
+	EVP_PKEY* key(const std::string& certificate);
+	void verifyRange(const Requests& requests, Results& results, std::size_t begin, std::size_t end);
+	void clearKeys();
+
+	Algorithm              _algorithm;
+	StatementExecutor::Ptr _pExecutor;
+	std::string            _userID;
+	KeyMap                 _keys;
+	Poco::FastMutex        _mutex;
+};
+
+
+//
+// inlines
+//
+inline const std::string& SignatureVerifier::getUserID() const
+{
+	return _userID;
+}
+
+
+inline SignatureVerifier::Algorithm SignatureVerifier::algorithm() const
+{
+	return _algorithm;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_SignatureVerifier_INCLUDED
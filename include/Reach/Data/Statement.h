@@ -20,12 +20,14 @@
 
 #include "Reach/Data/Data.h"
 #include "Reach/Data/StatementImpl.h"
+#include "Reach/Data/CancellationToken.h"
 #include "Poco/SharedPtr.h"
 #include "Poco/Mutex.h"
-#include "Poco/ActiveMethod.h"
 #include "Poco/ActiveResult.h"
+#include "Poco/AutoPtr.h"
 #include "Poco/Format.h"
 #include <algorithm>
+#include <functional>
 
 
 namespace Reach {
@@ -34,6 +36,50 @@ namespace Data {
 class Session;
 
 
+template <typename T>
+class Use
+	/// Use binds a variable by reference to the next placeholder
+	/// of a statement, see Keywords::use().
+{
+public:
+	explicit Use(const T& value): _value(value)
+		/// Creates the Use.
+	{
+	}
+
+	const T& value() const
+		/// Returns the bound variable.
+	{
+		return _value;
+	}
+
+private:
+	const T& _value;
+};
+
+
+template <typename T>
+class Into
+	/// Into receives the next result row of a statement
+	/// into a variable, see Keywords::into().
+{
+public:
+	explicit Into(T& value): _value(value)
+		/// Creates the Into.
+	{
+	}
+
+	T& value() const
+		/// Returns the receiving variable.
+	{
+		return _value;
+	}
+
+private:
+	T& _value;
+};
+
+
 class Data_API Statement
 	/// A Statement is used to execute SQL statements.
 	/// It does not contain code of its own.
@@ -65,10 +111,9 @@ class Data_API Statement
 public:
 	typedef void (*Manipulator)(Statement&);
 
-	typedef Poco::ActiveResult<std::size_t>                      Result;
-	typedef Poco::SharedPtr<Result>                              ResultPtr;
-	typedef Poco::ActiveMethod<std::size_t, bool, StatementImpl> AsyncExecMethod;
-	typedef Poco::SharedPtr<AsyncExecMethod>                     AsyncExecMethodPtr;
+	typedef Poco::ActiveResult<std::size_t>      Result;
+	typedef Poco::SharedPtr<Result>              ResultPtr;
+	typedef std::function<void(const Result&)>   Continuation;
 
 	static const int WAIT_FOREVER = -1;
 
@@ -115,6 +160,26 @@ public:
 	Statement& operator , (Manipulator manip);
 		/// Handles manipulators, such as now, async, etc.
 
+	template <typename T>
+	Statement& operator , (const Use<T>& use)
+		/// Binds the variable to the next placeholder. The variable is
+		/// read on every execution, see Binder.
+	{
+		Binder& binder = _pImpl->binder();
+		binder.bind(binder.size(), use.value());
+		return *this;
+	}
+
+	template <typename T>
+	Statement& operator , (const Into<T>& into)
+		/// Delivers the next result row into the variable on
+		/// every execution, see Extractor.
+	{
+		Extractor& extractor = _pImpl->extractor();
+		extractor.into(extractor.size(), into.value());
+		return *this;
+	}
+
 	Statement& operator , (char value);
 		/// Adds the value to the list of values to be supplied to the SQL string formatting function.
 
@@ -167,6 +232,26 @@ public:
 	const std::string& toString() const;
 		/// Creates a string from the accumulated SQL statement.
 
+	const StatementImpl::Results& results() const;
+		/// Returns the results of the last execution, one row per
+		/// executed operation. For asynchronous statements, call
+		/// wait() first.
+
+	const StatementImpl::BatchResults& batchResults() const;
+		/// Returns the results of the last batch execution, one
+		/// Results per argument set. For asynchronous statements,
+		/// call wait() first.
+
+	Statement& addBatch();
+		/// Completes the values supplied since the previous call as one
+		/// argument set of a batch. The next execution runs the statement
+		/// once per argument set, as one batch against the device (see
+		/// StatementImpl). Values supplied after the last call to addBatch()
+		/// form the last argument set.
+		///
+		/// Requires the "bulk" feature of the session to be set; throws
+		/// a NotSupportedException otherwise.
+
 	std::size_t execute(bool reset = true);
 		/// Executes the statement synchronously or asynchronously.
 		/// Stops when either a limit is hit or the whole statement was executed.
@@ -181,7 +266,8 @@ public:
 		/// obtained by calling wait() on the statement at a later point in time.
 
 	const Result& executeAsync(bool reset = true);
-		/// Executes the statement asynchronously.
+		/// Executes the statement asynchronously on the executor of
+		/// the session (see SessionImpl::getExecutor()).
 		/// Stops when either a limit is hit or the whole statement was executed.
 		/// Returns immediately. Calling wait() (on either the result returned from this
 		/// call or the statement itself) returns the number of rows extracted or number
@@ -189,6 +275,34 @@ public:
 		/// When executed on a synchronous statement, this method does not alter the
 		/// statement's synchronous nature.
 
+	Statement& then(const Continuation& continuation);
+		/// Chains the continuation to the last asynchronous execution.
+		/// It is called with the result on an executor thread as soon as the
+		/// execution completes, so follow-up work (e.g. executing another
+		/// statement) does not need to block in wait(). If the execution
+		/// has completed already, the continuation is submitted right away.
+		/// Exceptions thrown by a continuation go to Poco::ErrorHandler.
+		/// Throws a Poco::InvalidAccessException if the statement
+		/// has not been executed asynchronously.
+
+	Statement& setDeadline(const Poco::Timestamp& deadline);
+		/// Sets an absolute deadline for the executions of the statement.
+		/// Once it has passed, operations not yet started are dropped,
+		/// whether they wait in the executor, in the queue of a device
+		/// worker or behind earlier operations of the statement, and the
+		/// execution fails with a DeadlineExceededException.
+
+	Statement& setCancellation(CancellationToken::Ptr pToken);
+		/// Sets a token that cancels the executions of the statement
+		/// when it is cancelled, e.g. one shared by all statements
+		/// issued for a client connection. See CancellationToken.
+
+	void cancel();
+		/// Cancels the asynchronous execution in progress. Operations
+		/// not yet started are dropped and the execution fails with an
+		/// OperationCancelledException; an operation that has already
+		/// reached the device runs to completion.
+
 	void setAsync(bool async = true);
 		/// Sets the asynchronous flag. If this flag is true, executeAsync() is called
 		/// from the now() manipulator. This setting does not affect the statement's
@@ -202,6 +316,8 @@ public:
 		/// returns immediately for synchronous ones. The return value for
 		/// asynchronous statement is the execution result (i.e. number of
 		/// rows retrieved). For synchronous statements, the return value is zero.
+		/// A TimeoutException does not stop the execution; call cancel()
+		/// to drop the work that has not started yet.
 
 	bool initialized();
 		/// Returns true if the statement was initialized (i.e. not executed yet).
@@ -227,6 +343,17 @@ protected:
 		/// Returns the underlying session.
 
 private:
+	class Completion;
+	class ExecutionJob;
+	typedef Poco::AutoPtr<Completion> CompletionPtr;
+
+	void bindArguments();
+		/// Passes the values or the batch supplied since
+		/// the last execution to the implementation.
+
+	CancellationToken::Ptr createToken() const;
+		/// Returns a new token for an execution, or null if there is
+		/// neither a deadline nor a cancellation token.
 
 	const Result& doAsyncExec(bool reset = true);
 		/// Asynchronously executes the statement.
@@ -244,8 +371,13 @@ private:
 	bool                _async;
 	mutable ResultPtr   _pResult;
 	Poco::Mutex               _mutex;
-	AsyncExecMethodPtr  _pAsyncExec;
+	CompletionPtr       _pCompletion;
+	CancellationToken::Ptr    _pCancellation;
+	CancellationToken::Ptr    _pExecution;
+	Poco::Timestamp           _deadline;
+	bool                      _hasDeadline;
 	std::vector<Poco::Any>    _arguments;
+	StatementImpl::Batch      _batch;
 	mutable std::string _stmtString;
 };
 
@@ -282,6 +414,45 @@ inline void Data_API async(Statement& statement)
 	statement.setAsync(true);
 }
 
+
+inline void Data_API batch(Statement& statement)
+	/// Completes the values supplied so far as one argument
+	/// set of a batch, see Statement::addBatch().
+{
+	statement.addBatch();
+}
+
+
+//
+// Bindings
+//
+
+template <typename T>
+inline Use<T> use(T& t)
+	/// Binds the variable by reference to the next placeholder:
+	///
+	///     std::string pin("12345678");
+	///     Statement stmt(session);
+	///     stmt << "login %s", use(pin);
+	///     stmt.execute();
+	///     pin = "87654321";
+	///     stmt.execute();   // logs in with the new PIN
+	///
+	/// Values bound with use() cannot be combined with
+	/// values supplied directly or with batches.
+{
+	return Use<T>(t);
+}
+
+
+template <typename T>
+inline Into<T> into(T& t)
+	/// Delivers the next result row into the variable. A
+	/// std::vector<std::string> receives all remaining rows.
+{
+	return Into<T>(t);
+}
+
 } // namespace Keywords
 
 
@@ -397,6 +568,17 @@ inline const std::string& Statement::toString() const
 	return _stmtString = _pImpl->toString();
 }
 
+inline const StatementImpl::Results& Statement::results() const
+{
+	return _pImpl->results();
+}
+
+
+inline const StatementImpl::BatchResults& Statement::batchResults() const
+{
+	return _pImpl->batchResults();
+}
+
 inline bool Statement::initialized()
 {
 	return _pImpl->getState() == StatementImpl::ST_INITIALIZED;
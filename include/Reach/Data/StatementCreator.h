@@ -21,6 +21,7 @@
 #include "Reach/Data/Data.h"
 #include "Reach/Data/SessionImpl.h"
 #include "Reach/Data/Statement.h"
+#include "Reach/Data/DataException.h"
 #include "Poco/AutoPtr.h"
 
 
@@ -0,0 +1,175 @@
+//
+// StatementExecutor.h
+//
+// Library: Data
+// Package: Execution
+// Module:  StatementExecutor
+//
+// Definition of the StatementExecutor class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_StatementExecutor_INCLUDED
+#define RData_StatementExecutor_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/DeviceWorker.h"
+#include "Poco/RefCountedObject.h"
+#include "Poco/AutoPtr.h"
+#include "Poco/ActiveResult.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+#include "Poco/Mutex.h"
+#include "Poco/Condition.h"
+#include <functional>
+#include <vector>
+#include <deque>
+#include <atomic>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API StatementExecutor: public Poco::RefCountedObject
+	/// A StatementExecutor runs asynchronous statement executions
+	/// and their continuations on a fixed set of threads, by default
+	/// one per processor.
+	///
+	/// Every thread owns a queue. Jobs submitted from other threads are
+	/// spread across the queues round-robin, while jobs submitted by a
+	/// running job (e.g. a continuation) go to the queue of its own thread
+	/// and run next. A thread that runs out of work steals the oldest job
+	/// of another queue. Queues are unbounded, so submitting never blocks
+	/// and never fails for lack of threads.
+	///
+	/// Sessions use the executor configured for their connector (see
+	/// SessionFactory::setExecutor()), or the default executor.
+{
+public:
+	typedef Poco::AutoPtr<StatementExecutor> Ptr;
+
+	explicit StatementExecutor(int threads = 0, const std::string& name = "StatementExecutor");
+		/// Creates the StatementExecutor and starts its threads.
+		/// If threads is zero or negative, one thread per processor is started.
+
+	~StatementExecutor();
+		/// Stops the executor and destroys it. Jobs still queued
+		/// are cancelled.
+
+	template <class R>
+	Poco::ActiveResult<R> submit(const std::function<R()>& function,
+		const typename DeviceResultJob<R>::Callback& callback = typename DeviceResultJob<R>::Callback())
+		/// Queues the function for execution and returns its result.
+		/// The callback, if any, is called with the result on the
+		/// executor thread that ran the job.
+	{
+		DeviceResultJob<R>* pJob = new DeviceResultJob<R>(function, callback);
+		Poco::ActiveResult<R> result = pJob->result();
+		enqueue(pJob);
+		return result;
+	}
+
+	void enqueue(DeviceJob* pJob);
+		/// Queues the job for execution. Takes ownership of the job.
+		/// If the executor has been stopped, the job is cancelled.
+
+	bool isExecutorThread() const;
+		/// Returns true if called from one of the executor's threads.
+
+	const std::string& name() const;
+		/// Returns the name of the executor.
+
+	int threads() const;
+		/// Returns the number of threads.
+
+	int pending() const;
+		/// Returns the number of jobs queued but not yet started.
+
+	void stop();
+		/// Stops the threads after their currently running jobs.
+		/// Jobs still queued are cancelled.
+
+	static Ptr defaultExecutor();
+		/// Returns the executor used by sessions without
+		/// an executor of their own, creating it on first use.
+
+private:
+	class Worker: public Poco::Runnable
+	{
+	public:
+		Worker(StatementExecutor& owner, std::size_t index);
+		~Worker();
+
+		void push(DeviceJob* pJob);
+		DeviceJob* pop();
+		DeviceJob* steal();
+		void start();
+		void join();
+		bool isCurrent() const;
+		void run();
+
+	private:
+		StatementExecutor&      _owner;
+		std::size_t             _index;
+		std::deque<DeviceJob*>  _jobs;
+		Poco::FastMutex         _mutex;
+		Poco::Thread            _thread;
+	};
+
+	typedef std::vector<Worker*> WorkerVec;
+
+	StatementExecutor(const StatementExecutor&);
+	StatementExecutor& operator = (const StatementExecutor&);
+
+	DeviceJob* next(std::size_t self);
+	Worker* currentWorker() const;
+
+	std::string           _name;
+	WorkerVec             _workers;
+	std::atomic<unsigned> _next;
+	std::atomic<int>      _pending;
+	std::atomic<int>      _idle;
+	std::atomic<bool>     _stopped;
+	Poco::FastMutex       _mutex;
+	Poco::Condition       _ready;
+};
+
+
+//
+// inlines
+//
+inline const std::string& StatementExecutor::name() const
+{
+	return _name;
+}
+
+
+inline int StatementExecutor::threads() const
+{
+	return static_cast<int>(_workers.size());
+}
+
+
+inline int StatementExecutor::pending() const
+{
+	return _pending.load();
+}
+
+
+inline bool StatementExecutor::isExecutorThread() const
+{
+	return currentWorker() != 0;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_StatementExecutor_INCLUDED
@@ -20,6 +20,10 @@
 
 #include "Reach/Data/Data.h"
 #include "Reach/Data/SessionImpl.h"
+#include "Reach/Data/OperationPlan.h"
+#include "Reach/Data/StatementTemplate.h"
+#include "Reach/Data/Binder.h"
+#include "Reach/Data/Extractor.h"
 #include "Poco/RefCountedObject.h"
 #include "Poco/String.h"
 #include "Poco/Format.h"
@@ -37,12 +41,30 @@ namespace Data {
 
 
 class Data_API StatementImpl
-	/// StatementImpl interface that subclasses must implement to define database dependent query execution.
+	/// StatementImpl compiles the command text of a Statement into an
+	/// OperationPlan and executes it against the session.
+	/// See OperationPlan for the command syntax.
+	///
+	/// The command text may contain Poco::format() placeholders. It is
+	/// prepared once into a StatementTemplate, shared through the session,
+	/// and the bound values are placed into the plan on every execution.
+	///
+	/// Values bound by reference through the Binder are read on every
+	/// execution, and the result rows are delivered to the variables of
+	/// the Extractor after it.
+	///
+	/// If a batch of argument sets is bound, the statement is executed once
+	/// per set, all within one exclusive use of the device (see
+	/// SessionImpl::begin()), checking the login only once.
 	///
 	/// StatementImpl's are noncopyable.
 {
 public:
 	typedef Poco::SharedPtr<StatementImpl> Ptr;
+	typedef OperationPlan::Results         Results;
+	typedef std::vector<Results>           BatchResults;
+	typedef StatementTemplate::Arguments   Arguments;
+	typedef std::vector<Arguments>         Batch;
 
 	enum State
 	{
@@ -65,27 +87,42 @@ public:
 		/// Appends SQL statement (fragments).
 	{
 		_ostr << t;
+		_dirty = true;
 	}
 
 	std::string toString() const;
 		/// Create a string version of the SQL statement.
 
 	std::size_t execute(const bool& reset = true);
-		/// Executes a statement. Returns the number of rows 
-		/// extracted for statements returning data or number of rows 
-		/// affected for all other statements (insert, update, delete).
-		/// If reset is true (default), the underlying bound storage is
-		/// reset and reused. In case of containers, this means they are
-		/// cleared and resized to accomodate the number of rows returned by
-		/// this execution step. When reset is false, data is appended to the
-		/// bound containers during multiple execute calls.
+		/// Executes a statement. Returns the number of operations
+		/// executed, i.e. the number of result rows produced.
+		/// The command text is only prepared again if it has changed
+		/// since the previous execution; the values bound last are
+		/// reused unless new ones have been bound.
+		/// If reset is true (default), the results of previous
+		/// executions are discarded. When reset is false, the results
+		/// are appended during multiple execute calls.
+
+	const Results& results() const;
+		/// Returns the results, one row per executed operation.
+		/// Empty for batch executions.
+
+	const BatchResults& batchResults() const;
+		/// Returns the results of a batch execution,
+		/// one Results per argument set.
+
+	Binder& binder();
+		/// Returns the Binder holding the values bound by reference.
+
+	Extractor& extractor();
+		/// Returns the Extractor receiving the result rows.
 
 	void reset();
 		/// Resets the statement, so that we can reuse all bindings and re-execute again.
 
 	State getState() const;
 		/// Returns the state of the Statement.
-		
+
 protected:
 
 	SessionImpl& session();
@@ -95,8 +132,18 @@ private:
 	void prepareFunc();
 		/// Compiles the statement.
 
-	void formatSQL(std::vector<Poco::Any>& arguments);
-		/// Formats the SQL string by filling in placeholders with values from supplied vector.
+	void bind(Arguments& arguments);
+		/// Takes over the values for the placeholders of the command text,
+		/// leaving arguments empty.
+
+	void bind(Batch& batch);
+		/// Takes over the argument sets of a batch, leaving batch empty.
+
+	std::size_t executeBatch();
+		/// Executes the statement for every argument set of the batch.
+
+	std::size_t executeBound();
+		/// Executes the statement with the values of the binder.
 
 
 	StatementImpl(const StatementImpl& stmt);
@@ -107,6 +154,15 @@ private:
 	State                    _state;
 	SessionImpl&             _rSession;
 	std::ostringstream       _ostr;
+	bool                     _dirty;
+	StatementTemplate::Ptr   _pTemplate;
+	Arguments                _arguments;
+	Batch                    _batch;
+	Binder                   _binder;
+	Extractor                _extractor;
+	OperationPlan            _plan;
+	Results                  _results;
+	BatchResults             _batchResults;
 
 	friend class Statement; 
 };
@@ -129,6 +185,30 @@ inline StatementImpl::State StatementImpl::getState() const
 }
 
 
+inline const StatementImpl::Results& StatementImpl::results() const
+{
+	return _results;
+}
+
+
+inline const StatementImpl::BatchResults& StatementImpl::batchResults() const
+{
+	return _batchResults;
+}
+
+
+inline Binder& StatementImpl::binder()
+{
+	return _binder;
+}
+
+
+inline Extractor& StatementImpl::extractor()
+{
+	return _extractor;
+}
+
+
 inline SessionImpl& StatementImpl::session()
 {
 	return _rSession;
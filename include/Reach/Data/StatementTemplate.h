@@ -0,0 +1,174 @@
+//
+// StatementTemplate.h
+//
+// Library: Data
+// Package: DataCore
+// Module:  StatementTemplate
+//
+// Definition of the StatementTemplate and StatementTemplateCache classes.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_StatementTemplate_INCLUDED
+#define RData_StatementTemplate_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/OperationPlan.h"
+#include "Reach/Data/Binder.h"
+#include "Poco/LRUCache.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/Any.h"
+#include <vector>
+#include <string>
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API StatementTemplate
+	/// StatementTemplate is the prepared form of the command text of a
+	/// Statement, which may contain Poco::format() placeholders.
+	///
+	/// The text is parsed once into commands whose arguments consist of
+	/// literal segments and typed slots. Binding a set of arguments only
+	/// formats the slots and places the values into the operations; the
+	/// command text is neither formatted nor parsed again.
+	///
+	/// Binding gives the same result as formatting the whole text with
+	/// Poco::format() and parsing it into an OperationPlan. A value that
+	/// would change the structure of the command (e.g. an unquoted value
+	/// containing white space) is bound that way.
+	///
+	/// StatementTemplate objects are immutable and shared through the
+	/// StatementTemplateCache of the session.
+{
+public:
+	typedef Poco::SharedPtr<StatementTemplate> Ptr;
+	typedef std::vector<Poco::Any>             Arguments;
+
+	explicit StatementTemplate(const std::string& text);
+		/// Creates the StatementTemplate. Throws a Poco::SyntaxException
+		/// if the text has no placeholders and is malformed.
+
+	~StatementTemplate();
+		/// Destroys the StatementTemplate.
+
+	const OperationPlan& bind(const Arguments& arguments, OperationPlan& plan) const;
+		/// Binds the arguments and returns the resulting plan, which is
+		/// either the given plan, filled in, or, if the text has no
+		/// placeholders, the plan compiled with the template.
+		/// The operations of the given plan are overwritten in place, so
+		/// a plan reused across executions keeps its storage.
+		/// Throws a Poco::SyntaxException if the result is malformed.
+
+	const OperationPlan& bind(const Binder& binder, OperationPlan& plan) const;
+		/// Binds the values of the binder, see bind(const Arguments&, OperationPlan&).
+		/// Common conversions are formatted straight from the bound
+		/// variables, see Binder.
+
+	const std::string& text() const;
+		/// Returns the command text.
+
+	std::size_t slots() const;
+		/// Returns the number of placeholders.
+
+private:
+	struct Segment
+	{
+		Segment();
+
+		std::string literal;
+		int         index;   /// argument index, -1 for literal text
+		std::string spec;    /// format spec without the index
+		char        type;
+		bool        quoted;
+	};
+
+	typedef std::vector<Segment> Token;
+	typedef std::vector<Token>   Tokens;
+
+	struct Command
+	{
+		Command();
+
+		OperationPlan::Command command;
+		Tokens                 args;
+	};
+
+	StatementTemplate();
+	StatementTemplate(const StatementTemplate&);
+	StatementTemplate& operator = (const StatementTemplate&);
+
+	void parse();
+	bool parseSpec(std::string::const_iterator& it, std::string::const_iterator end, Segment& slot);
+	void endToken(Token& token, Tokens& tokens);
+	void endCommand(Tokens& tokens);
+
+	template <class Source>
+	const OperationPlan& bindPlan(const Source& source, OperationPlan& plan) const;
+
+	template <class Source>
+	bool bindToken(const Token& token, const Source& source, std::string& value) const;
+
+	void format(const Arguments& arguments, std::string& text) const;
+	void format(const Binder& binder, std::string& text) const;
+	static void appendSlot(const Segment& slot, const Arguments& arguments, std::string& value);
+	static void appendSlot(const Segment& slot, const Binder& binder, std::string& value);
+
+	std::string          _text;
+	std::vector<Command> _commands;
+	OperationPlan        _plan;
+	std::size_t          _slots;
+	int                  _nextIndex;
+	bool                 _direct;
+};
+
+
+class Data_API StatementTemplateCache: public Poco::LRUCache<std::string, StatementTemplate>
+	/// StatementTemplateCache holds the most recently used
+	/// statement templates of a session, keyed by their text.
+{
+public:
+	enum
+	{
+		DEFAULT_SIZE = 64
+	};
+
+	explicit StatementTemplateCache(long size = DEFAULT_SIZE);
+		/// Creates the StatementTemplateCache.
+
+	~StatementTemplateCache();
+		/// Destroys the StatementTemplateCache.
+
+	StatementTemplate::Ptr find(const std::string& text);
+		/// Returns the template for the given text,
+		/// creating and caching it if necessary.
+};
+
+
+//
+// inlines
+//
+inline const std::string& StatementTemplate::text() const
+{
+	return _text;
+}
+
+
+inline std::size_t StatementTemplate::slots() const
+{
+	return _slots;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_StatementTemplate_INCLUDED
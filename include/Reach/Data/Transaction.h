@@ -0,0 +1,116 @@
+//
+// Transaction.h
+//
+// Library: Data
+// Package: DataCore
+// Module:  Transaction
+//
+// Definition of the Transaction class.
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#ifndef RData_Transaction_INCLUDED
+#define RData_Transaction_INCLUDED
+
+
+#include "Reach/Data/Data.h"
+#include "Reach/Data/Session.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+class Data_API Transaction
+	/// Transaction runs a sequence of device operations back to back:
+	/// the device is taken once for the calling thread and, if a PIN
+	/// is given, the login is verified once, instead of for every
+	/// operation. For example:
+	///
+	///     Transaction trans(session, pin);
+	///     std::string cert = session.getCertBase64String(1);
+	///     for (...) signatures.push_back(session.signByP1(message));
+	///     std::string serial = session.getSerialNumber();
+	///     trans.commit();
+	///
+	/// A transaction still in progress when the Transaction
+	/// is destroyed is rolled back.
+{
+public:
+	explicit Transaction(Session& session);
+		/// Creates the Transaction and starts it.
+
+	Transaction(Session& session, const std::string& passwd);
+		/// Creates the Transaction, starts it and makes sure the session
+		/// is logged in (see Session::ensureLoggedIn()). If the login
+		/// fails, the transaction is rolled back and a
+		/// LoginFailedException is thrown.
+
+	~Transaction();
+		/// Destroys the Transaction, rolling it back if it is
+		/// still in progress.
+
+	template <typename T>
+	void transact(const T& t)
+		/// Calls t(session) and commits. If t throws,
+		/// the transaction is rolled back and the exception
+		/// is rethrown.
+	{
+		try
+		{
+			t(_session);
+		}
+		catch (...)
+		{
+			rollback();
+			throw;
+		}
+		commit();
+	}
+
+	void commit();
+		/// Ends the transaction.
+
+	void rollback();
+		/// Ends the transaction and forgets the login.
+
+	bool isActive() const;
+		/// Returns true if the transaction is in progress.
+
+	Session& session();
+		/// Returns the session.
+
+private:
+	Transaction();
+	Transaction(const Transaction&);
+	Transaction& operator = (const Transaction&);
+
+	Session& _session;
+	bool     _active;
+};
+
+
+//
+// inlines
+//
+inline bool Transaction::isActive() const
+{
+	return _active;
+}
+
+
+inline Session& Transaction::session()
+{
+	return _session;
+}
+
+
+} } // namespace Reach::Data
+
+
+#endif // RData_Transaction_INCLUDED
@@ -0,0 +1,487 @@
+//
+// BalancedSessionImpl.cpp
+//
+// Library: Data
+// Package: Execution
+// Module:  BalancedSessionImpl
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/BalancedSessionImpl.h"
+#include "Poco/Exception.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+BalancedSessionImpl::Member::Member(Poco::AutoPtr<SessionImpl> impl):
+	pImpl(impl),
+	outstanding(0)
+{
+}
+
+
+BalancedSessionImpl::Lease::Lease(Member& member):
+	_member(member)
+{
+	++_member.outstanding;
+}
+
+
+BalancedSessionImpl::Lease::~Lease()
+{
+	--_member.outstanding;
+}
+
+
+SessionImpl* BalancedSessionImpl::Lease::operator -> () const
+{
+	return _member.pImpl;
+}
+
+
+BalancedSessionImpl::BalancedSessionImpl(const Members& members):
+	SessionImpl(members.empty() ? std::string() : members.front()->connectionString(),
+		members.empty() ? LOGIN_TIMEOUT_DEFAULT : members.front()->getLoginTimeout()),
+	_next(0)
+{
+	if (members.empty())
+		throw Poco::InvalidArgumentException("BalancedSessionImpl requires at least one member");
+
+	for (Members::const_iterator it = members.begin(); it != members.end(); ++it)
+	{
+		poco_check_ptr (it->get());
+		_members.push_back(new Member(*it));
+	}
+
+	// signatures of any member must verify against the certificate
+	// handed out, which the first member answers
+	std::vector<StringResult> certificates;
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+		certificates.push_back((*it)->pImpl->getCertBase64StringAsync(SIGN_CERTIFICATE));
+	std::string certificate = DeviceWorker::await(certificates.front());
+	for (std::size_t i = 1; i < certificates.size(); ++i)
+	{
+		if (DeviceWorker::await(certificates[i]) != certificate)
+			throw Poco::InvalidArgumentException("Balanced devices hold different signing certificates");
+	}
+}
+
+
+BalancedSessionImpl::~BalancedSessionImpl()
+{
+}
+
+
+BalancedSessionImpl::MemberPtr BalancedSessionImpl::select()
+{
+	std::size_t count = _members.size();
+	std::size_t start = _next++ % count;
+
+	std::size_t best = start;
+	int least = _members[best]->outstanding.load();
+	for (std::size_t i = 1; i < count && least > 0; ++i)
+	{
+		std::size_t index = (start + i) % count;
+		int n = _members[index]->outstanding.load();
+		if (n < least)
+		{
+			best = index;
+			least = n;
+		}
+	}
+	return _members[best];
+}
+
+
+template <class R>
+Poco::ActiveResult<R> BalancedSessionImpl::dispatch(const std::function<Poco::ActiveResult<R>(SessionImpl*, const typename DeviceResultJob<R>::Callback&)>& start,
+	const typename DeviceResultJob<R>::Callback& callback)
+{
+	return dispatch<R>(select(), start, callback);
+}
+
+
+template <class R>
+Poco::ActiveResult<R> BalancedSessionImpl::dispatch(MemberPtr pMember,
+	const std::function<Poco::ActiveResult<R>(SessionImpl*, const typename DeviceResultJob<R>::Callback&)>& start,
+	const typename DeviceResultJob<R>::Callback& callback)
+{
+	++pMember->outstanding;
+	try
+	{
+		return start(pMember->pImpl, [pMember, callback](const Poco::ActiveResult<R>& result)
+		{
+			--pMember->outstanding;
+			if (callback) callback(result);
+		});
+	}
+	catch (...)
+	{
+		--pMember->outstanding;
+		throw;
+	}
+}
+
+
+void BalancedSessionImpl::open(const std::string& connect)
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+		(*it)->pImpl->open(connect);
+}
+
+
+void BalancedSessionImpl::close()
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+		(*it)->pImpl->close();
+}
+
+
+bool BalancedSessionImpl::isConnected()
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+	{
+		if ((*it)->pImpl->isConnected()) return true;
+	}
+	return false;
+}
+
+
+bool BalancedSessionImpl::isAlive()
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+	{
+		if ((*it)->pImpl->isAlive()) return true;
+	}
+	return false;
+}
+
+
+void BalancedSessionImpl::setConnectionTimeout(std::size_t timeout)
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+		(*it)->pImpl->setConnectionTimeout(timeout);
+}
+
+
+std::size_t BalancedSessionImpl::getConnectionTimeout()
+{
+	return primary()->getConnectionTimeout();
+}
+
+
+const std::string& BalancedSessionImpl::connectorName() const
+{
+	return primary()->connectorName();
+}
+
+
+const std::string& BalancedSessionImpl::contianerName() const
+{
+	return primary()->contianerName();
+}
+
+
+bool BalancedSessionImpl::login(const std::string& passwd)
+{
+	bool result = true;
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+	{
+		if (!(*it)->pImpl->login(passwd)) result = false;
+	}
+	return result;
+}
+
+
+bool BalancedSessionImpl::isLoggedIn()
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+	{
+		if (!(*it)->pImpl->isLoggedIn()) return false;
+	}
+	return true;
+}
+
+
+void BalancedSessionImpl::invalidateLogin()
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+		(*it)->pImpl->invalidateLogin();
+}
+
+
+void BalancedSessionImpl::setAuthLifetime(std::size_t seconds)
+{
+	SessionImpl::setAuthLifetime(seconds);
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+		(*it)->pImpl->setAuthLifetime(seconds);
+}
+
+
+void BalancedSessionImpl::begin()
+{
+	SessionImpl::begin();
+
+	// members are always taken in the same order, so
+	// concurrent transactions cannot deadlock
+	MemberVec::iterator it = _members.begin();
+	try
+	{
+		for (; it != _members.end(); ++it)
+			(*it)->pImpl->begin();
+	}
+	catch (...)
+	{
+		while (it != _members.begin())
+			(*--it)->pImpl->commit();
+		endTransaction();
+		throw;
+	}
+}
+
+
+void BalancedSessionImpl::commit()
+{
+	if (isTransactionOwner())
+	{
+		for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+			(*it)->pImpl->commit();
+	}
+	SessionImpl::commit();
+}
+
+
+void BalancedSessionImpl::rollback()
+{
+	if (isTransactionOwner())
+	{
+		for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+			(*it)->pImpl->rollback();
+	}
+	SessionImpl::rollback();
+}
+
+
+bool BalancedSessionImpl::changePW(const std::string& oldCode, const std::string& newCode)
+{
+	bool result = true;
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+	{
+		if (!(*it)->pImpl->changePW(oldCode, newCode)) result = false;
+	}
+	return result;
+}
+
+
+std::string BalancedSessionImpl::getUserList()
+{
+	return primary()->getUserList();
+}
+
+
+std::string BalancedSessionImpl::getCertBase64String(short ctype)
+{
+	return primary()->getCertBase64String(ctype);
+}
+
+
+int BalancedSessionImpl::getPinRetryCount()
+{
+	return primary()->getPinRetryCount();
+}
+
+
+std::string BalancedSessionImpl::getCertInfo(const std::string& base64, int type)
+{
+	Lease lease(*select());
+	return lease->getCertInfo(base64, type);
+}
+
+
+std::string BalancedSessionImpl::getSerialNumber()
+{
+	return primary()->getSerialNumber();
+}
+
+
+std::string BalancedSessionImpl::getKeyID()
+{
+	return primary()->getKeyID();
+}
+
+
+std::string BalancedSessionImpl::encryptData(const std::string& paintText, const std::string& base64)
+{
+	Lease lease(*select());
+	return lease->encryptData(paintText, base64);
+}
+
+
+std::string BalancedSessionImpl::decryptData(const std::string& encryptBuffer)
+{
+	// only the first member holds the key of the certificate handed out
+	Lease lease(*_members.front());
+	return lease->decryptData(encryptBuffer);
+}
+
+
+std::string BalancedSessionImpl::signByP1(const std::string& message)
+{
+	Lease lease(*select());
+	return lease->signByP1(message);
+}
+
+
+bool BalancedSessionImpl::verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature)
+{
+	Lease lease(*select());
+	return lease->verifySignByP1(base64, msg, signature);
+}
+
+
+std::string BalancedSessionImpl::signByP7(const std::string& textual, int mode)
+{
+	Lease lease(*select());
+	return lease->signByP7(textual, mode);
+}
+
+
+bool BalancedSessionImpl::verifySignByP7(const std::string& textual, const std::string& signature)
+{
+	Lease lease(*select());
+	return lease->verifySignByP7(textual, signature);
+}
+
+
+BalancedSessionImpl::BatchResults BalancedSessionImpl::signBatchP1(const std::vector<std::string>& messages)
+{
+	Lease lease(*select());
+	return lease->signBatchP1(messages);
+}
+
+
+BalancedSessionImpl::BatchResults BalancedSessionImpl::signBatchP7(const std::vector<std::string>& textuals, int mode)
+{
+	Lease lease(*select());
+	return lease->signBatchP7(textuals, mode);
+}
+
+
+std::string BalancedSessionImpl::signDigest(const std::string& digest)
+{
+	Lease lease(*select());
+	return lease->signDigest(digest);
+}
+
+
+std::string BalancedSessionImpl::signFile(const std::string& path)
+{
+	Lease lease(*select());
+	return lease->signFile(path);
+}
+
+
+bool BalancedSessionImpl::verifyFile(const std::string& base64, const std::string& path, const std::string& signature)
+{
+	Lease lease(*select());
+	return lease->verifyFile(base64, path, signature);
+}
+
+
+BalancedSessionImpl::StringResult BalancedSessionImpl::getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback)
+{
+	return dispatch<std::string>([&](SessionImpl* pImpl, const StringCallback& done)
+		{
+			return pImpl->getCertInfoAsync(base64, type, done);
+		}, callback);
+}
+
+
+BalancedSessionImpl::StringResult BalancedSessionImpl::encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback)
+{
+	return dispatch<std::string>([&](SessionImpl* pImpl, const StringCallback& done)
+		{
+			return pImpl->encryptDataAsync(paintText, base64, done);
+		}, callback);
+}
+
+
+BalancedSessionImpl::StringResult BalancedSessionImpl::decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback)
+{
+	return dispatch<std::string>(_members.front(), [&](SessionImpl* pImpl, const StringCallback& done)
+		{
+			return pImpl->decryptDataAsync(encryptBuffer, done);
+		}, callback);
+}
+
+
+BalancedSessionImpl::StringResult BalancedSessionImpl::signByP1Async(const std::string& message, const StringCallback& callback)
+{
+	return dispatch<std::string>([&](SessionImpl* pImpl, const StringCallback& done)
+		{
+			return pImpl->signByP1Async(message, done);
+		}, callback);
+}
+
+
+BalancedSessionImpl::BoolResult BalancedSessionImpl::verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback)
+{
+	return dispatch<bool>([&](SessionImpl* pImpl, const BoolCallback& done)
+		{
+			return pImpl->verifySignByP1Async(base64, msg, signature, done);
+		}, callback);
+}
+
+
+BalancedSessionImpl::StringResult BalancedSessionImpl::signByP7Async(const std::string& textual, int mode, const StringCallback& callback)
+{
+	return dispatch<std::string>([&](SessionImpl* pImpl, const StringCallback& done)
+		{
+			return pImpl->signByP7Async(textual, mode, done);
+		}, callback);
+}
+
+
+BalancedSessionImpl::BoolResult BalancedSessionImpl::verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback)
+{
+	return dispatch<bool>([&](SessionImpl* pImpl, const BoolCallback& done)
+		{
+			return pImpl->verifySignByP7Async(textual, signature, done);
+		}, callback);
+}
+
+
+void BalancedSessionImpl::setFeature(const std::string& name, bool state)
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+		(*it)->pImpl->setFeature(name, state);
+}
+
+
+bool BalancedSessionImpl::getFeature(const std::string& name)
+{
+	return primary()->getFeature(name);
+}
+
+
+void BalancedSessionImpl::setProperty(const std::string& name, const Poco::Any& value)
+{
+	for (MemberVec::iterator it = _members.begin(); it != _members.end(); ++it)
+		(*it)->pImpl->setProperty(name, value);
+}
+
+
+Poco::Any BalancedSessionImpl::getProperty(const std::string& name)
+{
+	return primary()->getProperty(name);
+}
+
+
+} } // namespace Reach::Data
@@ -0,0 +1,294 @@
+//
+// Binder.cpp
+//
+// Library: Data
+// Package: DataCore
+// Module:  Binder
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/Binder.h"
+#include "Poco/NumberFormatter.h"
+#include "Poco/Exception.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	template <typename T>
+	const T& value(const void* pValue)
+	{
+		return *static_cast<const T*>(pValue);
+	}
+
+	bool isInteger(char conversion)
+	{
+		return conversion == 'd' || conversion == 'i' || conversion == 'u';
+	}
+}
+
+
+Binder::Binder():
+	_size(0)
+{
+}
+
+
+Binder::~Binder()
+{
+}
+
+
+void Binder::bind(std::size_t pos, const bool& val)
+{
+	add(pos, BD_BOOL, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const char& val)
+{
+	add(pos, BD_CHAR, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const Poco::Int8& val)
+{
+	add(pos, BD_INT8, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const Poco::UInt8& val)
+{
+	add(pos, BD_UINT8, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const Poco::Int16& val)
+{
+	add(pos, BD_INT16, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const Poco::UInt16& val)
+{
+	add(pos, BD_UINT16, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const Poco::Int32& val)
+{
+	add(pos, BD_INT32, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const Poco::UInt32& val)
+{
+	add(pos, BD_UINT32, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const Poco::Int64& val)
+{
+	add(pos, BD_INT64, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const Poco::UInt64& val)
+{
+	add(pos, BD_UINT64, &val);
+}
+
+
+#ifndef POCO_LONG_IS_64_BIT
+void Binder::bind(std::size_t pos, const long& val)
+{
+	add(pos, BD_LONG, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const unsigned long& val)
+{
+	add(pos, BD_ULONG, &val);
+}
+#endif
+
+
+void Binder::bind(std::size_t pos, const float& val)
+{
+	add(pos, BD_FLOAT, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const double& val)
+{
+	add(pos, BD_DOUBLE, &val);
+}
+
+
+void Binder::bind(std::size_t pos, const char* const& pVal)
+{
+	add(pos, BD_CSTRING, &pVal);
+}
+
+
+void Binder::bind(std::size_t pos, const std::string& val)
+{
+	add(pos, BD_STRING, &val);
+}
+
+
+bool Binder::append(std::size_t pos, char conversion, std::string& str) const
+{
+	const Binding& binding = at(pos);
+	switch (binding.type)
+	{
+	case BD_BOOL:
+		if (conversion != 'b') return false;
+		str += value<bool>(binding.pValue) ? '1' : '0';
+		return true;
+	case BD_CHAR:
+		if (conversion != 'c') return false;
+		str += value<char>(binding.pValue);
+		return true;
+	case BD_INT8:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, static_cast<int>(value<Poco::Int8>(binding.pValue)));
+		return true;
+	case BD_UINT8:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, static_cast<unsigned>(value<Poco::UInt8>(binding.pValue)));
+		return true;
+	case BD_INT16:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, static_cast<int>(value<Poco::Int16>(binding.pValue)));
+		return true;
+	case BD_UINT16:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, static_cast<unsigned>(value<Poco::UInt16>(binding.pValue)));
+		return true;
+	case BD_INT32:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, value<Poco::Int32>(binding.pValue));
+		return true;
+	case BD_UINT32:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, value<Poco::UInt32>(binding.pValue));
+		return true;
+	case BD_INT64:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, value<Poco::Int64>(binding.pValue));
+		return true;
+	case BD_UINT64:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, value<Poco::UInt64>(binding.pValue));
+		return true;
+#ifndef POCO_LONG_IS_64_BIT
+	case BD_LONG:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, value<long>(binding.pValue));
+		return true;
+	case BD_ULONG:
+		if (!isInteger(conversion)) return false;
+		Poco::NumberFormatter::append(str, value<unsigned long>(binding.pValue));
+		return true;
+#endif
+	case BD_CSTRING:
+		if (conversion != 's') return false;
+		if (value<const char*>(binding.pValue)) str += value<const char*>(binding.pValue);
+		return true;
+	case BD_STRING:
+		if (conversion != 's') return false;
+		str += value<std::string>(binding.pValue);
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+Poco::Any Binder::any(std::size_t pos) const
+{
+	const Binding& binding = at(pos);
+	switch (binding.type)
+	{
+	case BD_BOOL:
+		return value<bool>(binding.pValue);
+	case BD_CHAR:
+		return value<char>(binding.pValue);
+	case BD_INT8:
+		return value<Poco::Int8>(binding.pValue);
+	case BD_UINT8:
+		return value<Poco::UInt8>(binding.pValue);
+	case BD_INT16:
+		return value<Poco::Int16>(binding.pValue);
+	case BD_UINT16:
+		return value<Poco::UInt16>(binding.pValue);
+	case BD_INT32:
+		return value<Poco::Int32>(binding.pValue);
+	case BD_UINT32:
+		return value<Poco::UInt32>(binding.pValue);
+	case BD_INT64:
+		return value<Poco::Int64>(binding.pValue);
+	case BD_UINT64:
+		return value<Poco::UInt64>(binding.pValue);
+#ifndef POCO_LONG_IS_64_BIT
+	case BD_LONG:
+		return value<long>(binding.pValue);
+	case BD_ULONG:
+		return value<unsigned long>(binding.pValue);
+#endif
+	case BD_FLOAT:
+		return value<float>(binding.pValue);
+	case BD_DOUBLE:
+		return value<double>(binding.pValue);
+	case BD_CSTRING:
+		return std::string(value<const char*>(binding.pValue) ? value<const char*>(binding.pValue) : "");
+	case BD_STRING:
+		return value<std::string>(binding.pValue);
+	}
+	throw Poco::BugcheckException("Unhandled binding type");
+}
+
+
+void Binder::reset()
+{
+	_overflow.clear();
+	_size = 0;
+}
+
+
+void Binder::add(std::size_t pos, Type type, const void* pValue)
+{
+	if (pos > _size) throw Poco::InvalidArgumentException("Binding position out of order");
+
+	Binding binding;
+	binding.type = type;
+	binding.pValue = pValue;
+	if (pos < INLINE_SIZE)
+		_inline[pos] = binding;
+	else if (pos - INLINE_SIZE < _overflow.size())
+		_overflow[pos - INLINE_SIZE] = binding;
+	else
+		_overflow.push_back(binding);
+
+	if (pos == _size) ++_size;
+}
+
+
+const Binder::Binding& Binder::at(std::size_t pos) const
+{
+	if (pos >= _size) throw Poco::RangeException("Binding position out of range");
+
+	return pos < INLINE_SIZE ? _inline[pos] : _overflow[pos - INLINE_SIZE];
+}
+
+
+} } // namespace Reach::Data
@@ -0,0 +1,138 @@
+//
+// CancellationToken.cpp
+//
+// Library: Data
+// Package: Execution
+// Module:  CancellationToken
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/CancellationToken.h"
+#include "Reach/Data/DataException.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	thread_local CancellationToken* pCurrentToken = 0;
+}
+
+
+//
+// CancellationToken::Scope
+//
+
+
+CancellationToken::Scope::Scope(CancellationToken* pToken):
+	_pPrevious(pCurrentToken)
+{
+	pCurrentToken = pToken;
+}
+
+
+CancellationToken::Scope::~Scope()
+{
+	pCurrentToken = _pPrevious;
+}
+
+
+//
+// CancellationToken
+//
+
+
+CancellationToken::CancellationToken():
+	_cancelled(false),
+	_deadline(NO_DEADLINE)
+{
+}
+
+
+CancellationToken::CancellationToken(Ptr pParent):
+	_pParent(pParent),
+	_cancelled(false),
+	_deadline(NO_DEADLINE)
+{
+}
+
+
+CancellationToken::~CancellationToken()
+{
+}
+
+
+void CancellationToken::cancel(const std::string& reason)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	if (_cancelled.load()) return;
+	_reason = reason;
+	_cancelled.store(true);
+}
+
+
+void CancellationToken::setDeadline(const Poco::Timestamp& deadline)
+{
+	_deadline.store(deadline.epochMicroseconds());
+}
+
+
+bool CancellationToken::isCancelled() const
+{
+	for (const CancellationToken* pToken = this; pToken; pToken = pToken->_pParent)
+	{
+		if (pToken->_cancelled.load()) return true;
+	}
+	Poco::Timestamp::TimeVal deadline = earliestDeadline();
+	return deadline != NO_DEADLINE && Poco::Timestamp().epochMicroseconds() >= deadline;
+}
+
+
+void CancellationToken::check() const
+{
+	for (const CancellationToken* pToken = this; pToken; pToken = pToken->_pParent)
+	{
+		if (pToken->_cancelled.load())
+		{
+			Poco::FastMutex::ScopedLock lock(pToken->_mutex);
+			throw OperationCancelledException(pToken->_reason);
+		}
+	}
+	Poco::Timestamp::TimeVal deadline = earliestDeadline();
+	if (deadline != NO_DEADLINE && Poco::Timestamp().epochMicroseconds() >= deadline)
+		throw DeadlineExceededException();
+}
+
+
+CancellationToken* CancellationToken::current()
+{
+	return pCurrentToken;
+}
+
+
+void CancellationToken::checkCurrent()
+{
+	if (pCurrentToken) pCurrentToken->check();
+}
+
+
+Poco::Timestamp::TimeVal CancellationToken::earliestDeadline() const
+{
+	Poco::Timestamp::TimeVal result = NO_DEADLINE;
+	for (const CancellationToken* pToken = this; pToken; pToken = pToken->_pParent)
+	{
+		Poco::Timestamp::TimeVal deadline = pToken->_deadline.load();
+		if (deadline != NO_DEADLINE && (result == NO_DEADLINE || deadline < result)) result = deadline;
+	}
+	return result;
+}
+
+
+} } // namespace Reach::Data
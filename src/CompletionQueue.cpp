@@ -0,0 +1,166 @@
+//
+// CompletionQueue.cpp
+//
+// Library: Data
+// Package: Execution
+// Module:  CompletionQueue
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/CompletionQueue.h"
+#if defined(POCO_OS_FAMILY_UNIX)
+#if POCO_OS == POCO_OS_LINUX
+#include <sys/eventfd.h>
+#endif
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+
+namespace Reach {
+namespace Data {
+
+
+//
+// CompletionQueue::Completion
+//
+
+
+CompletionQueue::Completion::Completion(Poco::UInt64 tag, const Poco::Any& value):
+	_tag(tag),
+	_value(value)
+{
+}
+
+
+CompletionQueue::Completion::Completion(Poco::UInt64 tag, const Poco::Exception& exc):
+	_tag(tag),
+	_pException(exc.clone())
+{
+}
+
+
+//
+// CompletionQueue
+//
+
+
+CompletionQueue::CompletionQueue():
+	_signalled(false),
+	_readFd(-1),
+	_writeFd(-1)
+{
+#if defined(POCO_OS_FAMILY_UNIX)
+#if POCO_OS == POCO_OS_LINUX
+	_readFd = _writeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_readFd < 0) throw Poco::SystemException("cannot create eventfd", errno);
+#else
+	int fds[2];
+	if (pipe(fds) != 0) throw Poco::SystemException("cannot create pipe", errno);
+	for (int i = 0; i < 2; ++i)
+	{
+		fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+		fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+	}
+	_readFd = fds[0];
+	_writeFd = fds[1];
+#endif
+#endif
+}
+
+
+CompletionQueue::~CompletionQueue()
+{
+#if defined(POCO_OS_FAMILY_UNIX)
+	if (_writeFd >= 0 && _writeFd != _readFd) close(_writeFd);
+	if (_readFd >= 0) close(_readFd);
+#endif
+}
+
+
+void CompletionQueue::post(const Completion& completion)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	_completions.push_back(completion);
+	if (!_signalled)
+	{
+		_signalled = true;
+		signal();
+		_ready.broadcast();
+	}
+}
+
+
+std::size_t CompletionQueue::drain(Completions& completions, std::size_t max)
+{
+	completions.clear();
+
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	if (max == 0 || max >= _completions.size())
+	{
+		completions.swap(_completions);
+	}
+	else
+	{
+		completions.assign(_completions.begin(), _completions.begin() + max);
+		_completions.erase(_completions.begin(), _completions.begin() + max);
+	}
+	if (_completions.empty() && _signalled)
+	{
+		_signalled = false;
+		reset();
+	}
+	return completions.size();
+}
+
+
+bool CompletionQueue::wait(long milliseconds)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	if (_completions.empty()) _ready.tryWait(_mutex, milliseconds);
+	return !_completions.empty();
+}
+
+
+std::size_t CompletionQueue::size() const
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	return _completions.size();
+}
+
+
+void CompletionQueue::signal()
+{
+#if defined(POCO_OS_FAMILY_UNIX)
+	// The descriptor is non-blocking. A full pipe or eventfd counter
+	// is readable already, so a failed write loses no wake-up.
+#if POCO_OS == POCO_OS_LINUX
+	Poco::UInt64 one = 1;
+	ssize_t n = write(_writeFd, &one, sizeof(one));
+#else
+	char one = 1;
+	ssize_t n = write(_writeFd, &one, sizeof(one));
+#endif
+	(void) n;
+#endif
+}
+
+
+void CompletionQueue::reset()
+{
+#if defined(POCO_OS_FAMILY_UNIX)
+	char buffer[64];
+	while (read(_readFd, buffer, sizeof(buffer)) > 0)
+	{
+	}
+#endif
+}
+
+
+} } // namespace Reach::Data
@@ -13,6 +13,7 @@
 
 
 #include "Reach/Data/Connector.h"
+#include "Poco/Exception.h"
 
 
 namespace Reach {
@@ -29,4 +30,27 @@ Connector::~Connector()
 }
 
 
+std::vector<std::string> Connector::devices()
+{
+	return std::vector<std::string>();
+}
+
+
+Poco::AutoPtr<SessionImpl> Connector::createDeviceSession(const std::string& connectionString,
+	std::size_t timeout,
+	const std::string& device)
+{
+	if (!device.empty())
+		throw Poco::NotImplementedException("Device sessions not supported by connector", name());
+
+	return createSession(connectionString, timeout);
+}
+
+
+bool Connector::supportsBalancing() const
+{
+	return false;
+}
+
+
 } } // namespace Reach::Data
@@ -37,6 +37,9 @@ POCO_IMPLEMENT_EXCEPTION(NoDataException, DataException, "No data found")
 POCO_IMPLEMENT_EXCEPTION(LengthExceededException, DataException, "Data too long")
 POCO_IMPLEMENT_EXCEPTION(ConnectionFailedException, DataException, "Connection attempt failed")
 POCO_IMPLEMENT_EXCEPTION(NotConnectedException, DataException, "Not connected to data source")
+POCO_IMPLEMENT_EXCEPTION(LoginFailedException, DataException, "PIN verification failed")
+POCO_IMPLEMENT_EXCEPTION(OperationCancelledException, DataException, "Operation cancelled")
+POCO_IMPLEMENT_EXCEPTION(DeadlineExceededException, DataException, "Deadline exceeded")
 
 
 } } // namespace Poco::Data
@@ -0,0 +1,255 @@
+//
+// DeviceMonitor.cpp
+//
+// Library: Data
+// Package: Execution
+// Module:  DeviceMonitor
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/DeviceMonitor.h"
+#include "Poco/Timestamp.h"
+#include "Poco/ScopedUnlock.h"
+#include <algorithm>
+
+
+using Poco::FastMutex;
+
+
+namespace Reach {
+namespace Data {
+
+
+DeviceMonitor::DeviceMonitor(const std::string& name,
+	const Probe& probe,
+	long minInterval,
+	long maxInterval):
+	_name(name),
+	_probe(probe),
+	_minInterval(minInterval),
+	_maxInterval(maxInterval),
+	_interval(minInterval),
+	_present(false),
+	_stopped(true),
+	_waiters(0),
+	_thread(name)
+{
+	poco_assert (_probe && minInterval > 0 && minInterval <= maxInterval);
+}
+
+
+DeviceMonitor::~DeviceMonitor()
+{
+	try
+	{
+		stop();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
+}
+
+
+void DeviceMonitor::start(DeviceWorker::Ptr pWorker)
+{
+	if (pWorker)
+		start([pWorker]() { return pWorker; });
+	else
+		start(WorkerLocator());
+}
+
+
+void DeviceMonitor::start(const WorkerLocator& locator)
+{
+	{
+		FastMutex::ScopedLock lock(_mutex);
+		if (!_stopped) return;
+		_locator = locator;
+	}
+
+	bool present = probe();
+	FastMutex::ScopedLock lock(_mutex);
+	_present = present;
+	_interval = _minInterval;
+	_stopped = false;
+	_thread.start(*this);
+}
+
+
+bool DeviceMonitor::isPresent() const
+{
+	FastMutex::ScopedLock lock(_mutex);
+	return _present;
+}
+
+
+long DeviceMonitor::interval() const
+{
+	FastMutex::ScopedLock lock(_mutex);
+	return _interval;
+}
+
+
+bool DeviceMonitor::waitForDevice(long milliseconds)
+{
+	if (Poco::Thread::current() == &_thread) return probe();
+
+	DeviceWorker::Ptr pWorker = worker();
+	FastMutex::ScopedLock lock(_mutex);
+	if (_present) return true;
+	if (_stopped)
+	{
+		Poco::ScopedUnlock<FastMutex> unlock(_mutex);
+		return probe();
+	}
+	if (pWorker && pWorker->isWorkerThread())
+	{
+		Poco::ScopedUnlock<FastMutex> unlock(_mutex);
+		return poll(milliseconds);
+	}
+
+	++_waiters;
+	_wakeUp.set();
+	Poco::Timestamp start;
+	while (!_present && !_stopped)
+	{
+		long remaining = milliseconds - static_cast<long>(start.elapsed()/1000);
+		if (remaining <= 0) break;
+		_changed.tryWait(_mutex, remaining);
+	}
+	--_waiters;
+	return _present;
+}
+
+
+bool DeviceMonitor::retry(const Probe& attempt, long milliseconds)
+{
+	Poco::Timestamp start;
+	long interval = _minInterval;
+	for (;;)
+	{
+		if (attempt()) return true;
+
+		long remaining = milliseconds - static_cast<long>(start.elapsed()/1000);
+		if (remaining <= 0) return false;
+		if (!isPresent())
+		{
+			waitForDevice(remaining);
+			remaining = milliseconds - static_cast<long>(start.elapsed()/1000);
+			if (remaining <= 0) return false;
+		}
+
+		Poco::Thread::sleep(std::min(remaining, interval));
+		interval = std::min(2*interval, _maxInterval);
+	}
+}
+
+
+void DeviceMonitor::wakeUp()
+{
+	_wakeUp.set();
+}
+
+
+void DeviceMonitor::stop()
+{
+	{
+		FastMutex::ScopedLock lock(_mutex);
+		if (_stopped) return;
+		_stopped = true;
+		_changed.broadcast();
+	}
+	_wakeUp.set();
+	if (Poco::Thread::current() != &_thread) _thread.join();
+}
+
+
+void DeviceMonitor::run()
+{
+	for (;;)
+	{
+		bool present = probe();
+		bool changed = false;
+		long interval = 0;
+		{
+			FastMutex::ScopedLock lock(_mutex);
+			if (_stopped) break;
+
+			changed = (present != _present);
+			_present = present;
+			if (changed || _waiters > 0)
+				_interval = _minInterval;
+			else
+				_interval = std::min(2*_interval, _maxInterval);
+			interval = _interval;
+			if (changed) _changed.broadcast();
+		}
+
+		if (changed)
+		{
+			try
+			{
+				if (present)
+					deviceConnected.notify(this, _name);
+				else
+					deviceDisconnected.notify(this, _name);
+			}
+			catch (...)
+			{
+				// a failing subscriber must not stop the monitor
+			}
+		}
+
+		_wakeUp.tryWait(interval);
+	}
+}
+
+
+bool DeviceMonitor::probe()
+{
+	try
+	{
+		DeviceWorker::Ptr pWorker = worker();
+		if (pWorker && !pWorker->isWorkerThread())
+			return DeviceWorker::await(pWorker->submit<bool>(_probe));
+		return _probe();
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+
+DeviceWorker::Ptr DeviceMonitor::worker() const
+{
+	WorkerLocator locator;
+	{
+		FastMutex::ScopedLock lock(_mutex);
+		locator = _locator;
+	}
+	return locator ? locator() : DeviceWorker::Ptr();
+}
+
+
+bool DeviceMonitor::poll(long milliseconds)
+{
+	Poco::Timestamp start;
+	for (;;)
+	{
+		if (probe()) return true;
+
+		long remaining = milliseconds - static_cast<long>(start.elapsed()/1000);
+		if (remaining <= 0) return false;
+		Poco::Thread::sleep(std::min(remaining, _minInterval));
+	}
+}
+
+
+} } // namespace Reach::Data
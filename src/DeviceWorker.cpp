@@ -0,0 +1,470 @@
+//
+// DeviceWorker.cpp
+//
+// Library: Data
+// Package: Execution
+// Module:  DeviceWorker
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/DeviceWorker.h"
+#include <algorithm>
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	thread_local DeviceJob::Priority threadPriority = DeviceJob::PRIO_NORMAL;
+	thread_local bool workerDestroyed = false;
+}
+
+
+//
+// DeviceJob::PriorityScope
+//
+
+
+DeviceJob::PriorityScope::PriorityScope(Priority priority):
+	_previous(threadPriority)
+{
+	threadPriority = priority;
+}
+
+
+DeviceJob::PriorityScope::~PriorityScope()
+{
+	threadPriority = _previous;
+}
+
+
+//
+// DeviceJob
+//
+
+
+DeviceJob::DeviceJob():
+	_next(0),
+	_priority(threadPriority)
+{
+}
+
+
+DeviceJob::~DeviceJob()
+{
+}
+
+
+void DeviceJob::execute()
+{
+	if (_pToken)
+	{
+		try
+		{
+			_pToken->check();
+		}
+		catch (Poco::Exception& exc)
+		{
+			reject(exc);
+			return;
+		}
+	}
+	CancellationToken::Scope scope(_pToken);
+	PriorityScope priority(_priority);
+	run();
+}
+
+
+void DeviceJob::reject(const Poco::Exception& exc)
+{
+	cancel(exc.displayText());
+}
+
+
+DeviceJob::Priority DeviceJob::currentPriority()
+{
+	return threadPriority;
+}
+
+
+//
+// DeviceHold
+//
+
+
+class DeviceHoldJob: public DeviceJob
+{
+public:
+	DeviceHoldJob(DeviceHold* pHold):
+		_pHold(pHold, true)
+	{
+	}
+
+	void run()
+	{
+		_pHold->enter();
+	}
+
+	void cancel(const std::string& reason)
+	{
+		_pHold->cancel(reason);
+	}
+
+private:
+	DeviceHold::Ptr _pHold;
+};
+
+
+DeviceHold::DeviceHold():
+	_entered(false),
+	_released(false),
+	_cancelled(false)
+{
+}
+
+
+DeviceHold::~DeviceHold()
+{
+}
+
+
+void DeviceHold::end()
+{
+	_released.set();
+}
+
+
+void DeviceHold::enter()
+{
+	_entered.set();
+	_released.wait();
+}
+
+
+void DeviceHold::cancel(const std::string& reason)
+{
+	_reason = reason;
+	_cancelled = true;
+	_entered.set();
+}
+
+
+void DeviceHold::wait()
+{
+	_entered.wait();
+	if (_cancelled) throw Poco::IllegalStateException(_reason);
+}
+
+
+//
+// DeviceQueue
+//
+
+
+DeviceQueue::DeviceQueue():
+	_head(&_stub),
+	_tail(&_stub)
+{
+}
+
+
+DeviceQueue::~DeviceQueue()
+{
+	poco_assert_dbg (_tail == &_stub && _head.load() == &_stub);
+}
+
+
+void DeviceQueue::push(DeviceJob* pJob)
+{
+	pJob->_next.store(0, std::memory_order_relaxed);
+	DeviceJob* pPrev = _head.exchange(pJob, std::memory_order_acq_rel);
+	pPrev->_next.store(pJob, std::memory_order_release);
+}
+
+
+DeviceJob* DeviceQueue::pop()
+{
+	DeviceJob* pTail = _tail;
+	DeviceJob* pNext = pTail->_next.load(std::memory_order_acquire);
+	if (pTail == &_stub)
+	{
+		if (!pNext) return 0;
+		_tail = pNext;
+		pTail = pNext;
+		pNext = pNext->_next.load(std::memory_order_acquire);
+	}
+	if (pNext)
+	{
+		_tail = pNext;
+		return pTail;
+	}
+
+	// pTail is the last linked job; a producer may be between
+	// the exchange and the link in push()
+	if (pTail != _head.load(std::memory_order_acquire)) return 0;
+
+	push(&_stub);
+	pNext = pTail->_next.load(std::memory_order_acquire);
+	if (pNext)
+	{
+		_tail = pNext;
+		return pTail;
+	}
+	return 0;
+}
+
+
+//
+// DeviceScheduler
+//
+
+
+DeviceScheduler::DeviceScheduler():
+	_sequence(0),
+	_starvationLimit(8)
+{
+	std::fill(_waited, _waited + DeviceJob::PRIO_CLASSES, 0);
+	_targets[DeviceJob::PRIO_INTERACTIVE].store(50*Poco::Timespan::MILLISECONDS);
+	_targets[DeviceJob::PRIO_NORMAL].store(Poco::Timespan::SECONDS);
+	_targets[DeviceJob::PRIO_BULK].store(60*Poco::Timespan::SECONDS);
+}
+
+
+DeviceScheduler::~DeviceScheduler()
+{
+	poco_assert_dbg (empty());
+}
+
+
+void DeviceScheduler::push(DeviceJob* pJob)
+{
+	int priority = pJob->priority();
+	poco_assert_dbg (priority >= 0 && priority < DeviceJob::PRIO_CLASSES);
+
+	Entry entry;
+	entry.due = Poco::Timestamp().epochMicroseconds() + _targets[priority].load();
+	CancellationToken::Ptr pToken = pJob->cancellation();
+	if (pToken && pToken->hasDeadline())
+		entry.due = std::min(entry.due, pToken->deadline().epochMicroseconds());
+	entry.sequence = _sequence++;
+	entry.pJob = pJob;
+
+	Heap& heap = _heaps[priority];
+	heap.push_back(entry);
+	std::push_heap(heap.begin(), heap.end());
+}
+
+
+DeviceJob* DeviceScheduler::pop()
+{
+	int limit = _starvationLimit.load();
+	int next = -1;
+	for (int priority = 0; priority < DeviceJob::PRIO_CLASSES; ++priority)
+	{
+		if (_heaps[priority].empty()) continue;
+		if (next < 0)
+		{
+			next = priority;
+			if (limit <= 0) break;
+		}
+		else if (_waited[priority] >= limit)
+		{
+			next = priority;
+			break;
+		}
+	}
+	if (next < 0) return 0;
+
+	// lower classes that still wait have been passed over once more
+	_waited[next] = 0;
+	for (int priority = next + 1; priority < DeviceJob::PRIO_CLASSES; ++priority)
+	{
+		if (!_heaps[priority].empty()) ++_waited[priority];
+	}
+
+	Heap& heap = _heaps[next];
+	std::pop_heap(heap.begin(), heap.end());
+	DeviceJob* pJob = heap.back().pJob;
+	heap.pop_back();
+	if (heap.empty()) _waited[next] = 0;
+	return pJob;
+}
+
+
+bool DeviceScheduler::empty() const
+{
+	for (int priority = 0; priority < DeviceJob::PRIO_CLASSES; ++priority)
+	{
+		if (!_heaps[priority].empty()) return false;
+	}
+	return true;
+}
+
+
+//
+// DeviceWorker
+//
+
+
+DeviceWorker::DeviceWorker(const std::string& name):
+	_name(name),
+	_pending(0),
+	_sleeping(false),
+	_stopped(false),
+	_thread(name)
+{
+	for (int priority = 0; priority < DeviceJob::PRIO_CLASSES; ++priority)
+	{
+		_classPending[priority].store(0);
+	}
+	_thread.start(*this);
+}
+
+
+DeviceWorker::~DeviceWorker()
+{
+	if (isWorkerThread())
+	{
+		// a job dropped the last reference: the thread can not join
+		// itself, so it cancels the remaining jobs, and run() returns
+		// without touching the worker again; the thread is detached
+		_stopped.store(true);
+		drain();
+		workerDestroyed = true;
+		return;
+	}
+
+	try
+	{
+		stop();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
+}
+
+
+void DeviceWorker::enqueue(DeviceJob* pJob)
+{
+	poco_check_ptr (pJob);
+
+	// announce the job before checking the stopped flag, so that
+	// drain() either waits for it or the job is cancelled here
+	++_pending;
+	if (_stopped.load())
+	{
+		--_pending;
+		pJob->cancel("Device worker stopped: " + _name);
+		delete pJob;
+		return;
+	}
+
+	if (!pJob->cancellation()) pJob->setCancellation(CancellationToken::Ptr(CancellationToken::current(), true));
+	if (pJob->priority() < 0 || pJob->priority() >= DeviceJob::PRIO_CLASSES) pJob->setPriority(DeviceJob::PRIO_NORMAL);
+	++_classPending[pJob->priority()];
+	_queue.push(pJob);
+	if (_sleeping.exchange(false)) _wakeUp.set();
+}
+
+
+DeviceHold::Ptr DeviceWorker::hold()
+{
+	poco_assert (!isWorkerThread());
+
+	DeviceHold::Ptr pHold = new DeviceHold;
+	enqueue(new DeviceHoldJob(pHold));
+	pHold->wait();
+	return pHold;
+}
+
+
+void DeviceWorker::stop()
+{
+	if (_stopped.exchange(true)) return;
+
+	_sleeping.store(false);
+	_wakeUp.set();
+	if (!isWorkerThread()) _thread.join();
+}
+
+
+void DeviceWorker::run()
+{
+	while (!_stopped.load())
+	{
+		DeviceJob* pJob = next();
+		if (pJob)
+		{
+			pJob->execute();
+			delete pJob;
+			if (workerDestroyed) return;
+			continue;
+		}
+
+		// a producer has announced a job that is not linked yet
+		if (_pending.load() > 0)
+		{
+			Poco::Thread::yield();
+			continue;
+		}
+
+		_sleeping.store(true);
+		if (_pending.load() > 0 || _stopped.load())
+		{
+			_sleeping.store(false);
+			continue;
+		}
+		_wakeUp.wait();
+	}
+	drain();
+}
+
+
+DeviceJob* DeviceWorker::next()
+{
+	// move the jobs submitted meanwhile to the scheduler, but not
+	// without bound, so a flood of submissions cannot stall the device
+	for (int i = 0; i < MAX_TRANSFER; ++i)
+	{
+		DeviceJob* pJob = _queue.pop();
+		if (!pJob) break;
+		_scheduler.push(pJob);
+	}
+
+	DeviceJob* pJob = _scheduler.pop();
+	if (pJob)
+	{
+		--_classPending[pJob->priority()];
+		--_pending;
+	}
+	return pJob;
+}
+
+
+void DeviceWorker::drain()
+{
+	// producers that passed the stopped check before stop()
+	// may still be linking their jobs
+	while (_pending.load() > 0)
+	{
+		DeviceJob* pJob = next();
+		if (pJob)
+		{
+			pJob->cancel("Device worker stopped: " + _name);
+			delete pJob;
+			if (workerDestroyed) return;
+		}
+		else Poco::Thread::yield();
+	}
+}
+
+
+} } // namespace Reach::Data
@@ -0,0 +1,141 @@
+//
+// Extractor.cpp
+//
+// Library: Data
+// Package: DataCore
+// Module:  Extractor
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/Extractor.h"
+#include "Poco/NumberParser.h"
+#include "Poco/Exception.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+Extractor::Extractor():
+	_size(0)
+{
+}
+
+
+Extractor::~Extractor()
+{
+}
+
+
+void Extractor::into(std::size_t pos, std::string& val)
+{
+	add(pos, EX_STRING, &val);
+}
+
+
+void Extractor::into(std::size_t pos, bool& val)
+{
+	add(pos, EX_BOOL, &val);
+}
+
+
+void Extractor::into(std::size_t pos, Poco::Int32& val)
+{
+	add(pos, EX_INT32, &val);
+}
+
+
+void Extractor::into(std::size_t pos, Poco::Int64& val)
+{
+	add(pos, EX_INT64, &val);
+}
+
+
+void Extractor::into(std::size_t pos, Rows& val)
+{
+	add(pos, EX_ROWS, &val);
+}
+
+
+std::size_t Extractor::extract(const Rows& rows) const
+{
+	std::size_t count = 0;
+	for (std::size_t pos = 0; pos < _size; ++pos)
+	{
+		const Extraction& extraction = at(pos);
+		if (extraction.type == EX_ROWS)
+		{
+			Rows& target = *static_cast<Rows*>(extraction.pValue);
+			if (pos < rows.size())
+			{
+				target.assign(rows.begin() + pos, rows.end());
+				count += rows.size() - pos;
+			}
+			else target.clear();
+			continue;
+		}
+
+		if (pos >= rows.size()) throw Poco::RangeException("No result row for variable");
+		const std::string& row = rows[pos];
+		switch (extraction.type)
+		{
+		case EX_STRING:
+			*static_cast<std::string*>(extraction.pValue) = row;
+			break;
+		case EX_BOOL:
+			*static_cast<bool*>(extraction.pValue) = Poco::NumberParser::parseBool(row);
+			break;
+		case EX_INT32:
+			*static_cast<Poco::Int32*>(extraction.pValue) = Poco::NumberParser::parse(row);
+			break;
+		case EX_INT64:
+			*static_cast<Poco::Int64*>(extraction.pValue) = Poco::NumberParser::parse64(row);
+			break;
+		default:
+			break;
+		}
+		++count;
+	}
+	return count;
+}
+
+
+void Extractor::reset()
+{
+	_overflow.clear();
+	_size = 0;
+}
+
+
+void Extractor::add(std::size_t pos, Type type, void* pValue)
+{
+	if (pos > _size) throw Poco::InvalidArgumentException("Extraction position out of order");
+
+	Extraction extraction;
+	extraction.type = type;
+	extraction.pValue = pValue;
+	if (pos < INLINE_SIZE)
+		_inline[pos] = extraction;
+	else if (pos - INLINE_SIZE < _overflow.size())
+		_overflow[pos - INLINE_SIZE] = extraction;
+	else
+		_overflow.push_back(extraction);
+
+	if (pos == _size) ++_size;
+}
+
+
+const Extractor::Extraction& Extractor::at(std::size_t pos) const
+{
+	if (pos >= _size) throw Poco::RangeException("Extraction position out of range");
+
+	return pos < INLINE_SIZE ? _inline[pos] : _overflow[pos - INLINE_SIZE];
+}
+
+
+} } // namespace Reach::Data
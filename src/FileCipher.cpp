@@ -0,0 +1,410 @@
+//
+// FileCipher.cpp
+//
+// Library: Data
+// Package: Crypto
+// Module:  FileCipher
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/FileCipher.h"
+#include "Reach/Data/DeviceWorker.h"
+#include "Poco/FileStream.h"
+#include "Poco/Buffer.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/NumberFormatter.h"
+#include "Poco/Exception.h"
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/crypto.h>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	const char          MAGIC[] = "RDSM4CTR";
+	const unsigned char VERSION = 1;
+
+	enum
+	{
+		MAGIC_SIZE      = 8,
+		FIXED_HEADER    = 36,
+		NONCE_SIZE      = 8,
+		PREFIX_SIZE     = 24,
+		SM4_KEY_SIZE    = 16,
+		SM4_BLOCK_SIZE  = 16,
+		MAX_KEY_INFO    = 64*1024
+	};
+
+
+	void putUInt32(char* p, Poco::UInt32 value)
+	{
+		for (int i = 3; i >= 0; --i, value >>= 8) p[i] = static_cast<char>(value & 0xFF);
+	}
+
+
+	void putUInt64(char* p, Poco::UInt64 value)
+	{
+		for (int i = 7; i >= 0; --i, value >>= 8) p[i] = static_cast<char>(value & 0xFF);
+	}
+
+
+	Poco::UInt32 getUInt32(const char* p)
+	{
+		Poco::UInt32 value = 0;
+		for (int i = 0; i < 4; ++i) value = (value << 8) | static_cast<unsigned char>(p[i]);
+		return value;
+	}
+
+
+	Poco::UInt64 getUInt64(const char* p)
+	{
+		Poco::UInt64 value = 0;
+		for (int i = 0; i < 8; ++i) value = (value << 8) | static_cast<unsigned char>(p[i]);
+		return value;
+	}
+
+
+	std::string randomBytes(int length)
+	{
+		std::string result(static_cast<std::size_t>(length), '\0');
+		if (RAND_bytes(reinterpret_cast<unsigned char*>(&result[0]), length) != 1)
+			throw Poco::SystemException("cannot generate random bytes");
+		return result;
+	}
+}
+
+
+//
+// FileCipher::Frame
+//
+
+
+class FileCipher::Frame
+	/// A chunk of the file and the room for its MAC. The prefix
+	/// that goes into the MAC is stored right before the data,
+	/// so the MAC is computed over one contiguous range.
+{
+public:
+	explicit Frame(std::size_t chunkSize):
+		index(0),
+		size(0),
+		_buffer(PREFIX_SIZE + chunkSize + MAC_SIZE)
+	{
+	}
+
+	char* prefix()
+	{
+		return _buffer.begin();
+	}
+
+	char* data()
+	{
+		return _buffer.begin() + PREFIX_SIZE;
+	}
+
+	char* mac()
+	{
+		return data() + size;
+	}
+
+	Poco::UInt64 index;
+	std::size_t  size;
+
+private:
+	Poco::Buffer<char> _buffer;
+};
+
+
+//
+// FileCipher::Header
+//
+
+
+FileCipher::Header::Header():
+	chunkSize(0),
+	plainSize(0),
+	dataOffset(0)
+{
+}
+
+
+//
+// FileCipher
+//
+
+
+FileCipher::FileCipher(const std::string& key, StatementExecutor::Ptr pExecutor):
+	_key(key),
+	_chunkSize(DEFAULT_CHUNK_SIZE),
+	_pExecutor(pExecutor)
+{
+	if (_key.size() != KEY_SIZE) throw Poco::InvalidArgumentException("FileCipher key size");
+	if (!_pExecutor) _pExecutor = StatementExecutor::defaultExecutor();
+}
+
+
+FileCipher::~FileCipher()
+{
+	OPENSSL_cleanse(&_key[0], _key.size());
+}
+
+
+void FileCipher::setChunkSize(std::size_t chunkSize)
+{
+	if (chunkSize == 0 || chunkSize % SM4_BLOCK_SIZE != 0 || chunkSize > MAX_CHUNK_SIZE)
+		throw Poco::InvalidArgumentException("FileCipher chunk size");
+	_chunkSize = chunkSize;
+}
+
+
+void FileCipher::encryptFile(const std::string& inPath, const std::string& outPath, const std::string& keyInfo)
+{
+	if (keyInfo.size() > MAX_KEY_INFO) throw Poco::InvalidArgumentException("FileCipher key info too long");
+
+	Poco::FileInputStream istr(inPath, std::ios::binary);
+	istr.seekg(0, std::ios::end);
+	Header header;
+	header.chunkSize = static_cast<Poco::UInt32>(_chunkSize);
+	header.plainSize = static_cast<Poco::UInt64>(istr.tellg());
+	header.nonce = randomBytes(NONCE_SIZE);
+	header.keyInfo = keyInfo;
+	header.dataOffset = FIXED_HEADER + keyInfo.size();
+	istr.seekg(0, std::ios::beg);
+
+	char fixed[FIXED_HEADER] = { 0 };
+	std::memcpy(fixed, MAGIC, MAGIC_SIZE);
+	fixed[8] = static_cast<char>(VERSION);
+	putUInt32(fixed + 12, header.chunkSize);
+	putUInt64(fixed + 16, header.plainSize);
+	std::memcpy(fixed + 24, header.nonce.data(), NONCE_SIZE);
+	putUInt32(fixed + 32, static_cast<Poco::UInt32>(keyInfo.size()));
+
+	Poco::FileOutputStream ostr(outPath, std::ios::binary);
+	ostr.write(fixed, FIXED_HEADER);
+	ostr.write(keyInfo.data(), static_cast<std::streamsize>(keyInfo.size()));
+	process(istr, ostr, header, true);
+}
+
+
+void FileCipher::decryptFile(const std::string& inPath, const std::string& outPath)
+{
+	Poco::FileInputStream istr(inPath, std::ios::binary);
+	Header header = readHeader(istr);
+	Poco::FileOutputStream ostr(outPath, std::ios::binary);
+	process(istr, ostr, header, false);
+}
+
+
+std::string FileCipher::decryptRange(const std::string& path, Poco::UInt64 offset, std::size_t length)
+{
+	Poco::FileInputStream istr(path, std::ios::binary);
+	Header header = readHeader(istr);
+	std::string result;
+	if (offset >= header.plainSize || length == 0) return result;
+
+	Poco::UInt64 end = std::min<Poco::UInt64>(offset + length, header.plainSize);
+	result.reserve(static_cast<std::size_t>(end - offset));
+	Frame frame(header.chunkSize);
+	for (Poco::UInt64 i = offset/header.chunkSize; i*header.chunkSize < end; ++i)
+	{
+		Poco::UInt64 begin = i*header.chunkSize;
+		frame.index = i;
+		frame.size = static_cast<std::size_t>(std::min<Poco::UInt64>(header.chunkSize, header.plainSize - begin));
+		istr.seekg(static_cast<std::streamoff>(header.dataOffset + i*(header.chunkSize + MAC_SIZE)), std::ios::beg);
+		istr.read(frame.data(), static_cast<std::streamsize>(frame.size + MAC_SIZE));
+		if (static_cast<std::size_t>(istr.gcount()) != frame.size + MAC_SIZE)
+			throw Poco::DataFormatException("encrypted file is truncated", path);
+		processFrame(frame, header, false);
+
+		std::size_t from = static_cast<std::size_t>(std::max(offset, begin) - begin);
+		std::size_t to = static_cast<std::size_t>(std::min<Poco::UInt64>(end - begin, frame.size));
+		result.append(frame.data() + from, to - from);
+	}
+	return result;
+}
+
+
+std::string FileCipher::keyInfo(const std::string& path)
+{
+	Poco::FileInputStream istr(path, std::ios::binary);
+	return readHeader(istr).keyInfo;
+}
+
+
+Poco::UInt64 FileCipher::plainSize(const std::string& path)
+{
+	Poco::FileInputStream istr(path, std::ios::binary);
+	return readHeader(istr).plainSize;
+}
+
+
+std::string FileCipher::generateKey()
+{
+	return randomBytes(KEY_SIZE);
+}
+
+
+void FileCipher::process(std::istream& istr, std::ostream& ostr, const Header& header, bool encrypt)
+{
+	// Frames are read and written in windows on the calling thread. While
+	// the frames of one window are processed on the executor, the next
+	// window is read.
+	bool parallel = _pExecutor->threads() > 1 && !_pExecutor->isExecutorThread();
+	std::size_t windowSize = parallel ? static_cast<std::size_t>(_pExecutor->threads())*WINDOW_PER_THREAD : 1;
+	std::size_t frameSize = encrypt ? 0 : MAC_SIZE;
+
+	typedef Poco::SharedPtr<Frame> FramePtr;
+	std::vector<FramePtr> windows[2];
+	std::size_t filled[2] = { 0, 0 };
+	Poco::UInt64 next = 0;
+	Poco::UInt64 frames = (header.plainSize + header.chunkSize - 1)/header.chunkSize;
+
+	auto read = [&](int w)
+	{
+		filled[w] = 0;
+		while (filled[w] < windowSize && next < frames)
+		{
+			if (windows[w].size() == filled[w]) windows[w].push_back(new Frame(header.chunkSize));
+			Frame& frame = *windows[w][filled[w]];
+			frame.index = next;
+			frame.size = static_cast<std::size_t>(std::min<Poco::UInt64>(header.chunkSize, header.plainSize - next*header.chunkSize));
+			istr.read(frame.data(), static_cast<std::streamsize>(frame.size + frameSize));
+			if (static_cast<std::size_t>(istr.gcount()) != frame.size + frameSize)
+			{
+				if (encrypt) throw Poco::ReadFileException("file changed while encrypting");
+				throw Poco::DataFormatException("encrypted file is truncated");
+			}
+			++filled[w];
+			++next;
+		}
+	};
+
+	int current = 0;
+	read(current);
+	while (filled[current] > 0)
+	{
+		std::vector<Poco::ActiveResult<void> > pending;
+		if (parallel)
+		{
+			for (std::size_t i = 0; i < filled[current]; ++i)
+			{
+				Frame* pFrame = windows[current][i].get();
+				pending.push_back(_pExecutor->submit<void>([this, pFrame, &header, encrypt]()
+				{
+					processFrame(*pFrame, header, encrypt);
+				}));
+			}
+		}
+		else processFrame(*windows[current][0], header, encrypt);
+
+		try
+		{
+			read(current ^ 1);
+		}
+		catch (...)
+		{
+			for (std::size_t i = 0; i < pending.size(); ++i) pending[i].wait();
+			throw;
+		}
+
+		// wait for all jobs before rethrowing, they refer to the frames
+		for (std::size_t i = 0; i < pending.size(); ++i) pending[i].wait();
+		for (std::size_t i = 0; i < pending.size(); ++i) DeviceWorker::await(pending[i]);
+
+		for (std::size_t i = 0; i < filled[current]; ++i)
+		{
+			Frame& frame = *windows[current][i];
+			ostr.write(frame.data(), static_cast<std::streamsize>(frame.size + MAC_SIZE - frameSize));
+		}
+		if (!ostr.good()) throw Poco::WriteFileException("cannot write file");
+		current ^= 1;
+	}
+	ostr.flush();
+	if (!ostr.good()) throw Poco::WriteFileException("cannot write file");
+}
+
+
+void FileCipher::processFrame(Frame& frame, const Header& header, bool encrypt) const
+{
+	const unsigned char* pKey = reinterpret_cast<const unsigned char*>(_key.data());
+	std::memcpy(frame.prefix(), header.nonce.data(), NONCE_SIZE);
+	putUInt64(frame.prefix() + 8, frame.index);
+	putUInt64(frame.prefix() + 16, header.plainSize);
+
+	unsigned char mac[EVP_MAX_MD_SIZE];
+	unsigned int macLength = 0;
+	if (!encrypt)
+	{
+		if (!HMAC(EVP_sm3(), pKey + SM4_KEY_SIZE, SM4_KEY_SIZE,
+			reinterpret_cast<const unsigned char*>(frame.prefix()), PREFIX_SIZE + frame.size, mac, &macLength)
+			|| macLength != MAC_SIZE)
+			throw Poco::SystemException("cannot compute frame MAC");
+		if (CRYPTO_memcmp(mac, frame.mac(), MAC_SIZE) != 0)
+			throw Poco::DataFormatException("encrypted frame failed authentication", Poco::NumberFormatter::format(frame.index));
+	}
+
+	unsigned char counter[SM4_BLOCK_SIZE];
+	std::memcpy(counter, header.nonce.data(), NONCE_SIZE);
+	putUInt64(reinterpret_cast<char*>(counter) + NONCE_SIZE, frame.index*(header.chunkSize/SM4_BLOCK_SIZE));
+
+	EVP_CIPHER_CTX* pContext = EVP_CIPHER_CTX_new();
+	int length = 0;
+	bool ok = pContext
+		&& EVP_EncryptInit_ex(pContext, EVP_sm4_ctr(), 0, pKey, counter) == 1
+		&& EVP_EncryptUpdate(pContext,
+			reinterpret_cast<unsigned char*>(frame.data()), &length,
+			reinterpret_cast<const unsigned char*>(frame.data()), static_cast<int>(frame.size)) == 1;
+	EVP_CIPHER_CTX_free(pContext);
+	if (!ok) throw Poco::SystemException("cannot encrypt frame");
+
+	if (encrypt)
+	{
+		if (!HMAC(EVP_sm3(), pKey + SM4_KEY_SIZE, SM4_KEY_SIZE,
+			reinterpret_cast<const unsigned char*>(frame.prefix()), PREFIX_SIZE + frame.size, mac, &macLength)
+			|| macLength != MAC_SIZE)
+			throw Poco::SystemException("cannot compute frame MAC");
+		std::memcpy(frame.mac(), mac, MAC_SIZE);
+	}
+}
+
+
+FileCipher::Header FileCipher::readHeader(std::istream& istr)
+{
+	char fixed[FIXED_HEADER];
+	istr.read(fixed, FIXED_HEADER);
+	if (istr.gcount() != FIXED_HEADER || std::memcmp(fixed, MAGIC, MAGIC_SIZE) != 0)
+		throw Poco::DataFormatException("not an encrypted file");
+	if (static_cast<unsigned char>(fixed[8]) != VERSION)
+		throw Poco::DataFormatException("unsupported encrypted file version");
+
+	Header header;
+	header.chunkSize = getUInt32(fixed + 12);
+	header.plainSize = getUInt64(fixed + 16);
+	header.nonce.assign(fixed + 24, NONCE_SIZE);
+	Poco::UInt32 keyInfoLength = getUInt32(fixed + 32);
+	if (header.chunkSize == 0 || header.chunkSize % SM4_BLOCK_SIZE != 0 || header.chunkSize > MAX_CHUNK_SIZE || keyInfoLength > MAX_KEY_INFO)
+		throw Poco::DataFormatException("invalid encrypted file header");
+
+	header.keyInfo.resize(keyInfoLength);
+	if (keyInfoLength > 0) istr.read(&header.keyInfo[0], keyInfoLength);
+	if (static_cast<Poco::UInt32>(istr.gcount()) != keyInfoLength && keyInfoLength > 0)
+		throw Poco::DataFormatException("encrypted file is truncated");
+	header.dataOffset = FIXED_HEADER + keyInfoLength;
+	return header;
+}
+
+
+} } // namespace Reach::Data
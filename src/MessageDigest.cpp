@@ -0,0 +1,314 @@
+//
+// MessageDigest.cpp
+//
+// Library: Data
+// Package: Crypto
+// Module:  MessageDigest
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/MessageDigest.h"
+#include "Reach/Data/DataException.h"
+#include "Poco/Base64Decoder.h"
+#include "Poco/FileStream.h"
+#include "Poco/Buffer.h"
+#include "Poco/Thread.h"
+#include "Poco/Runnable.h"
+#include "Poco/Mutex.h"
+#include "Poco/Condition.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/Exception.h"
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <sstream>
+#include <iterator>
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	// the parameters a, b, xG and yG of the SM2 curve, GM/T 0003.5
+	const unsigned char SM2_CURVE[128] =
+	{
+		0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+		0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFC,
+		0x28, 0xE9, 0xFA, 0x9E, 0x9D, 0x9F, 0x5E, 0x34, 0x4D, 0x5A, 0x9E, 0x4B, 0xCF, 0x65, 0x09, 0xA7,
+		0xF3, 0x97, 0x89, 0xF5, 0x15, 0xAB, 0x8F, 0x92, 0xDD, 0xBC, 0xBD, 0x41, 0x4D, 0x94, 0x0E, 0x93,
+		0x32, 0xC4, 0xAE, 0x2C, 0x1F, 0x19, 0x81, 0x19, 0x5F, 0x99, 0x04, 0x46, 0x6A, 0x39, 0xC9, 0x94,
+		0x8F, 0xE3, 0x0B, 0xBF, 0xF2, 0x66, 0x0B, 0xE1, 0x71, 0x5A, 0x45, 0x89, 0x33, 0x4C, 0x74, 0xC7,
+		0xBC, 0x37, 0x36, 0xA2, 0xF4, 0xF6, 0x77, 0x9C, 0x59, 0xBD, 0xCE, 0xE3, 0x6B, 0x69, 0x21, 0x53,
+		0xD0, 0xA9, 0x87, 0x7C, 0xC6, 0x2A, 0x47, 0x40, 0x02, 0xDF, 0x32, 0xE5, 0x21, 0x39, 0xF0, 0xA0
+	};
+
+
+	const EVP_MD* digestOf(SignatureVerifier::Algorithm algorithm)
+	{
+		switch (algorithm)
+		{
+		case SignatureVerifier::ALG_SM3_SM2:
+			return EVP_sm3();
+		case SignatureVerifier::ALG_SHA1_RSA:
+			return EVP_sha1();
+		case SignatureVerifier::ALG_SHA256_RSA:
+			return EVP_sha256();
+		default:
+			throw NotSupportedException("signature algorithm");
+		}
+	}
+
+
+	std::string sm2PublicKey(const std::string& certificate)
+		/// Returns the public key of the certificate as
+		/// the 64 byte concatenation of x and y.
+	{
+		std::istringstream istr(certificate);
+		Poco::Base64Decoder decoder(istr);
+		std::string der((std::istreambuf_iterator<char>(decoder)), std::istreambuf_iterator<char>());
+
+		const unsigned char* pDER = reinterpret_cast<const unsigned char*>(der.data());
+		X509* pCert = d2i_X509(0, &pDER, static_cast<long>(der.size()));
+		if (!pCert)
+		{
+			ERR_clear_error();
+			throw Poco::DataFormatException("invalid certificate");
+		}
+
+		bool sm2 = false;
+		EVP_PKEY* pKey = X509_get0_pubkey(pCert);
+		if (pKey)
+		{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+			sm2 = EVP_PKEY_is_a(pKey, "SM2") != 0;
+#else
+			const EC_KEY* pEC = EVP_PKEY_get0_EC_KEY(pKey);
+			sm2 = pEC && EC_GROUP_get_curve_name(EC_KEY_get0_group(pEC)) == NID_sm2;
+#endif
+		}
+		std::string result;
+		ASN1_BIT_STRING* pBits = X509_get0_pubkey_bitstr(pCert);
+		if (sm2 && pBits && ASN1_STRING_length(pBits) == 65 && ASN1_STRING_get0_data(pBits)[0] == 0x04)
+		{
+			result.assign(reinterpret_cast<const char*>(ASN1_STRING_get0_data(pBits)) + 1, 64);
+		}
+		X509_free(pCert);
+		ERR_clear_error();
+		if (result.empty()) throw NotSupportedException("certificate key does not fit the signature algorithm");
+		return result;
+	}
+
+
+	class FileReader: public Poco::Runnable
+		/// Reads a file into two buffers on its own thread, so the
+		/// next chunk is read while the caller hashes the current one.
+	{
+	public:
+		enum
+		{
+			CHUNK_SIZE = 1024*1024
+		};
+
+		explicit FileReader(const std::string& path):
+			_istr(path, std::ios::binary),
+			_filled(0),
+			_read(0),
+			_holding(false),
+			_stopped(false),
+			_thread("FileReader")
+		{
+			_buffers[0] = new Poco::Buffer<char>(CHUNK_SIZE);
+			_buffers[1] = new Poco::Buffer<char>(CHUNK_SIZE);
+			_thread.start(*this);
+		}
+
+		~FileReader()
+		{
+			{
+				Poco::FastMutex::ScopedLock lock(_mutex);
+				_stopped = true;
+			}
+			_changed.broadcast();
+			_thread.join();
+		}
+
+		std::size_t next(const char*& data)
+			/// Releases the previous chunk and returns the next one,
+			/// waiting until it has been read. Returns zero at the
+			/// end of the file.
+		{
+			Poco::FastMutex::ScopedLock lock(_mutex);
+			if (_holding)
+			{
+				--_filled;
+				_read ^= 1;
+				_holding = false;
+				_changed.broadcast();
+			}
+			while (_filled == 0 && _pException.isNull()) _changed.wait(_mutex);
+			if (_filled == 0) _pException->rethrow();
+			_holding = true;
+			data = _buffers[_read]->begin();
+			return _sizes[_read];
+		}
+
+		void run()
+		{
+			int write = 0;
+			std::size_t size = 0;
+			do
+			{
+				{
+					Poco::FastMutex::ScopedLock lock(_mutex);
+					while (_filled == 2 && !_stopped) _changed.wait(_mutex);
+					if (_stopped) return;
+				}
+				try
+				{
+					_istr.read(_buffers[write]->begin(), CHUNK_SIZE);
+					if (_istr.bad()) throw Poco::ReadFileException("cannot read file");
+					size = static_cast<std::size_t>(_istr.gcount());
+				}
+				catch (Poco::Exception& exc)
+				{
+					Poco::FastMutex::ScopedLock lock(_mutex);
+					_pException = exc.clone();
+					_changed.broadcast();
+					return;
+				}
+				Poco::FastMutex::ScopedLock lock(_mutex);
+				_sizes[write] = size;
+				++_filled;
+				write ^= 1;
+				_changed.broadcast();
+			}
+			while (size > 0);
+		}
+
+	private:
+		Poco::FileInputStream                _istr;
+		Poco::SharedPtr<Poco::Buffer<char> > _buffers[2];
+		std::size_t                          _sizes[2];
+		int                                  _filled;
+		int                                  _read;
+		bool                                 _holding;
+		bool                                 _stopped;
+		Poco::SharedPtr<Poco::Exception>     _pException;
+		Poco::FastMutex                      _mutex;
+		Poco::Condition                      _changed;
+		Poco::Thread                         _thread;
+	};
+}
+
+
+MessageDigest::MessageDigest(SignatureVerifier::Algorithm algorithm):
+	_algorithm(algorithm),
+	_pContext(0)
+{
+	if (_algorithm == SignatureVerifier::ALG_SM3_SM2)
+		throw Poco::InvalidArgumentException("SM2 digests need the signer's certificate");
+	init();
+}
+
+
+MessageDigest::MessageDigest(SignatureVerifier::Algorithm algorithm, const std::string& certificate, const std::string& userID):
+	_algorithm(algorithm),
+	_pContext(0)
+{
+	if (_algorithm == SignatureVerifier::ALG_SM3_SM2)
+	{
+		if (userID.size() >= 8192) throw Poco::InvalidArgumentException("SM2 signer ID too long");
+
+		// Z = SM3(ENTL || ID || a || b || xG || yG || xA || yA)
+		std::string z;
+		z += static_cast<char>((userID.size()*8) >> 8);
+		z += static_cast<char>((userID.size()*8) & 0xFF);
+		z += userID;
+		z.append(reinterpret_cast<const char*>(SM2_CURVE), sizeof(SM2_CURVE));
+		z += sm2PublicKey(certificate);
+
+		unsigned char md[EVP_MAX_MD_SIZE];
+		unsigned int length = 0;
+		if (!EVP_Digest(z.data(), z.size(), md, &length, EVP_sm3(), 0))
+			throw Poco::SystemException("cannot compute SM2 Z value");
+		_z.assign(reinterpret_cast<char*>(md), length);
+	}
+	init();
+}
+
+
+MessageDigest::~MessageDigest()
+{
+	EVP_MD_CTX_free(_pContext);
+}
+
+
+void MessageDigest::init()
+{
+	digestOf(_algorithm);
+	_pContext = EVP_MD_CTX_new();
+	if (!_pContext) throw Poco::OutOfMemoryException("MessageDigest");
+	try
+	{
+		reset();
+	}
+	catch (...)
+	{
+		EVP_MD_CTX_free(_pContext);
+		throw;
+	}
+}
+
+
+void MessageDigest::reset()
+{
+	if (!EVP_DigestInit_ex(_pContext, digestOf(_algorithm), 0))
+		throw Poco::SystemException("cannot initialize digest");
+	if (!_z.empty()) update(_z.data(), _z.size());
+}
+
+
+void MessageDigest::update(const void* data, std::size_t length)
+{
+	if (length && !EVP_DigestUpdate(_pContext, data, length))
+		throw Poco::SystemException("cannot update digest");
+}
+
+
+void MessageDigest::updateFile(const std::string& path)
+{
+	FileReader reader(path);
+	const char* data = 0;
+	while (std::size_t size = reader.next(data))
+	{
+		update(data, size);
+	}
+}
+
+
+std::string MessageDigest::digest()
+{
+	unsigned char md[EVP_MAX_MD_SIZE];
+	unsigned int length = 0;
+	if (!EVP_DigestFinal_ex(_pContext, md, &length))
+		throw Poco::SystemException("cannot finalize digest");
+	reset();
+	return std::string(reinterpret_cast<char*>(md), length);
+}
+
+
+std::size_t MessageDigest::digestLength() const
+{
+	return static_cast<std::size_t>(EVP_MD_size(digestOf(_algorithm)));
+}
+
+
+} } // namespace Reach::Data
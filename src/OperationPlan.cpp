@@ -0,0 +1,266 @@
+//
+// OperationPlan.cpp
+//
+// Library: Data
+// Package: DataCore
+// Module:  OperationPlan
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/OperationPlan.h"
+#include "Reach/Data/CancellationToken.h"
+#include "Poco/NumberParser.h"
+#include "Poco/NumberFormatter.h"
+#include "Poco/String.h"
+#include "Poco/Exception.h"
+#include "Poco/Ascii.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	struct CommandInfo
+	{
+		const char*            keyword;
+		OperationPlan::Command command;
+		std::size_t            minArgs;
+		std::size_t            maxArgs;
+		int                    numericArg; // index of an integer argument, or -1
+	};
+
+	const CommandInfo COMMANDS[] =
+	{
+		{ "login",    OperationPlan::CMD_LOGIN,     1, 1, -1 },
+		{ "sign",     OperationPlan::CMD_SIGN,      1, 1, -1 },
+		{ "signp7",   OperationPlan::CMD_SIGN_P7,   1, 2,  1 },
+		{ "verify",   OperationPlan::CMD_VERIFY,    3, 3, -1 },
+		{ "verifyp7", OperationPlan::CMD_VERIFY_P7, 2, 2, -1 },
+		{ "encrypt",  OperationPlan::CMD_ENCRYPT,   2, 2, -1 },
+		{ "decrypt",  OperationPlan::CMD_DECRYPT,   1, 1, -1 },
+		{ "certinfo", OperationPlan::CMD_CERT_INFO, 2, 2,  1 },
+		{ "cert",     OperationPlan::CMD_CERT,      1, 1,  0 },
+		{ "serial",   OperationPlan::CMD_SERIAL,    0, 0, -1 },
+		{ "keyid",    OperationPlan::CMD_KEY_ID,    0, 0, -1 },
+		{ "userlist", OperationPlan::CMD_USER_LIST, 0, 0, -1 },
+		{ "retries",  OperationPlan::CMD_RETRIES,   0, 0, -1 }
+	};
+
+	const CommandInfo* findCommand(const std::string& keyword)
+	{
+		for (std::size_t i = 0; i < sizeof(COMMANDS)/sizeof(COMMANDS[0]); ++i)
+		{
+			if (Poco::icompare(keyword, COMMANDS[i].keyword) == 0) return &COMMANDS[i];
+		}
+		return 0;
+	}
+
+	const CommandInfo& commandInfo(OperationPlan::Command command)
+	{
+		for (std::size_t i = 0; i < sizeof(COMMANDS)/sizeof(COMMANDS[0]); ++i)
+		{
+			if (COMMANDS[i].command == command) return COMMANDS[i];
+		}
+		throw Poco::BugcheckException("Unhandled command");
+	}
+
+	std::string boolResult(bool value)
+	{
+		return value ? "1" : "0";
+	}
+}
+
+
+OperationPlan::OperationPlan()
+{
+}
+
+
+OperationPlan::OperationPlan(const std::string& text)
+{
+	std::vector<std::string> tokens;
+	std::string token;
+	bool inToken = false;
+
+	std::string::const_iterator it = text.begin();
+	std::string::const_iterator end = text.end();
+	while (it != end)
+	{
+		char c = *it++;
+		if (c == '\'')
+		{
+			// quoted argument, '' stands for a quote
+			for (;;)
+			{
+				if (it == end) throw Poco::SyntaxException("Unterminated quote in command", text);
+				c = *it++;
+				if (c == '\'')
+				{
+					if (it == end || *it != '\'') break;
+					++it;
+				}
+				token += c;
+			}
+			inToken = true;
+		}
+		else if (Poco::Ascii::isSpace(c) || c == ';')
+		{
+			if (inToken)
+			{
+				tokens.push_back(token);
+				token.clear();
+				inToken = false;
+			}
+			if (c == ';' || c == '\n' || c == '\r') add(tokens);
+		}
+		else
+		{
+			token += c;
+			inToken = true;
+		}
+	}
+	if (inToken) tokens.push_back(token);
+	add(tokens);
+}
+
+
+OperationPlan::~OperationPlan()
+{
+}
+
+
+void OperationPlan::add(std::vector<std::string>& tokens)
+{
+	if (tokens.empty()) return;
+
+	const CommandInfo* pInfo = findCommand(tokens[0]);
+	if (!pInfo) throw Poco::SyntaxException("Unknown command", tokens[0]);
+
+	std::size_t args = tokens.size() - 1;
+	if (args < pInfo->minArgs || args > pInfo->maxArgs)
+		throw Poco::SyntaxException("Wrong number of arguments", tokens[0]);
+
+	Operation op;
+	op.command = pInfo->command;
+	op.args.assign(tokens.begin() + 1, tokens.end());
+	check(op);
+	_operations.push_back(op);
+	tokens.clear();
+}
+
+
+bool OperationPlan::lookup(const std::string& keyword, std::size_t args, Command& command)
+{
+	const CommandInfo* pInfo = findCommand(keyword);
+	if (!pInfo || args < pInfo->minArgs || args > pInfo->maxArgs) return false;
+
+	command = pInfo->command;
+	return true;
+}
+
+
+void OperationPlan::check(const Operation& op)
+{
+	const CommandInfo& info = commandInfo(op.command);
+	int value = 0;
+	if (info.numericArg >= 0 && static_cast<std::size_t>(info.numericArg) < op.args.size() &&
+		!Poco::NumberParser::tryParse(op.args[info.numericArg], value))
+		throw Poco::SyntaxException("Integer argument expected", info.keyword);
+}
+
+
+OperationPlan::Batch::Batch():
+	loggedIn(false)
+{
+}
+
+
+std::size_t OperationPlan::execute(SessionImpl& session, Results& results) const
+{
+	for (Operations::const_iterator it = _operations.begin(); it != _operations.end(); ++it)
+	{
+		CancellationToken::checkCurrent();
+		results.push_back(run(session, *it, 0));
+	}
+
+	return _operations.size();
+}
+
+
+std::size_t OperationPlan::execute(SessionImpl& session, Results& results, Batch& batch) const
+{
+	for (Operations::const_iterator it = _operations.begin(); it != _operations.end(); ++it)
+	{
+		CancellationToken::checkCurrent();
+		results.push_back(run(session, *it, &batch));
+	}
+
+	return _operations.size();
+}
+
+
+std::string OperationPlan::run(SessionImpl& session, const Operation& op, Batch* pBatch)
+{
+	SessionImpl::DeviceGuard guard(session);
+	const std::vector<std::string>& a = op.args;
+	switch (op.command)
+	{
+	case CMD_LOGIN:
+		if (pBatch)
+		{
+			if (pBatch->loggedIn && pBatch->pin == a[0]) return boolResult(true);
+			pBatch->loggedIn = session.ensureLoggedIn(a[0]);
+			pBatch->pin = pBatch->loggedIn ? a[0] : std::string();
+			return boolResult(pBatch->loggedIn);
+		}
+		return boolResult(session.ensureLoggedIn(a[0]));
+	case CMD_SIGN:
+		return session.signByP1(a[0]);
+	case CMD_SIGN_P7:
+		return session.signByP7(a[0], a.size() > 1 ? Poco::NumberParser::parse(a[1]) : 0);
+	case CMD_VERIFY:
+		return boolResult(session.verifySignByP1(a[0], a[1], a[2]));
+	case CMD_VERIFY_P7:
+		return boolResult(session.verifySignByP7(a[0], a[1]));
+	case CMD_ENCRYPT:
+		return session.encryptData(a[0], a[1]);
+	case CMD_DECRYPT:
+		return session.decryptData(a[0]);
+	case CMD_CERT_INFO:
+		return session.getCertInfo(a[0], Poco::NumberParser::parse(a[1]));
+	case CMD_CERT:
+		return session.getCertBase64String(static_cast<short>(Poco::NumberParser::parse(a[0])));
+	case CMD_SERIAL:
+		return session.getSerialNumber();
+	case CMD_KEY_ID:
+		return session.getKeyID();
+	case CMD_USER_LIST:
+		return session.getUserList();
+	case CMD_RETRIES:
+		return Poco::NumberFormatter::format(session.getPinRetryCount());
+	}
+	throw Poco::BugcheckException("Unhandled command");
+}
+
+
+std::string OperationPlan::quote(const std::string& argument)
+{
+	std::string result("'");
+	for (std::string::const_iterator it = argument.begin(); it != argument.end(); ++it)
+	{
+		if (*it == '\'') result += '\'';
+		result += *it;
+	}
+	result += '\'';
+	return result;
+}
+
+
+} } // namespace Reach::Data
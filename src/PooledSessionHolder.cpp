@@ -0,0 +1,34 @@
+//
+// PooledSessionHolder.cpp
+//
+// Library: Data
+// Package: SessionPooling
+// Module:  PooledSessionHolder
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/PooledSessionHolder.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+PooledSessionHolder::PooledSessionHolder(SessionPool& owner, SessionImpl* pSessionImpl):
+	_owner(owner),
+	_pImpl(pSessionImpl, true)
+{
+}
+
+
+PooledSessionHolder::~PooledSessionHolder()
+{
+}
+
+
+} } // namespace Reach::Data
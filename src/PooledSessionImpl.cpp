@@ -0,0 +1,386 @@
+//
+// PooledSessionImpl.cpp
+//
+// Library: Data
+// Package: SessionPooling
+// Module:  PooledSessionImpl
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/PooledSessionImpl.h"
+#include "Reach/Data/DataException.h"
+#include "Reach/Data/SessionPool.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+PooledSessionImpl::PooledSessionImpl(PooledSessionHolder* pHolder):
+	SessionImpl(pHolder->session()->connectionString(),
+		pHolder->session()->getLoginTimeout()),
+	_pHolder(pHolder, true)
+{
+	setExecutor(pHolder->session()->getExecutor());
+}
+
+
+PooledSessionImpl::~PooledSessionImpl()
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
+}
+
+
+void PooledSessionImpl::open(const std::string& connect)
+{
+	access()->open(connect);
+}
+
+
+void PooledSessionImpl::close()
+{
+	if (_pHolder)
+	{
+		_pHolder->owner().putBack(_pHolder);
+		_pHolder = 0;
+	}
+}
+
+
+bool PooledSessionImpl::isConnected()
+{
+	return _pHolder ? access()->isConnected() : false;
+}
+
+
+bool PooledSessionImpl::isAlive()
+{
+	return _pHolder ? access()->isAlive() : false;
+}
+
+
+void PooledSessionImpl::setConnectionTimeout(std::size_t timeout)
+{
+	access()->setConnectionTimeout(timeout);
+}
+
+
+std::size_t PooledSessionImpl::getConnectionTimeout()
+{
+	return access()->getConnectionTimeout();
+}
+
+
+const std::string& PooledSessionImpl::connectorName() const
+{
+	return access()->connectorName();
+}
+
+
+const std::string& PooledSessionImpl::contianerName() const
+{
+	return access()->contianerName();
+}
+
+
+bool PooledSessionImpl::login(const std::string& passwd)
+{
+	return access()->login(passwd);
+}
+
+
+void PooledSessionImpl::begin()
+{
+	access()->begin();
+}
+
+
+void PooledSessionImpl::commit()
+{
+	access()->commit();
+}
+
+
+void PooledSessionImpl::rollback()
+{
+	access()->rollback();
+}
+
+
+bool PooledSessionImpl::canTransact()
+{
+	return access()->canTransact();
+}
+
+
+bool PooledSessionImpl::isTransaction()
+{
+	return _pHolder ? access()->isTransaction() : false;
+}
+
+
+SessionImpl* PooledSessionImpl::lockDevice()
+{
+	return access()->lockDevice();
+}
+
+
+bool PooledSessionImpl::isLoggedIn()
+{
+	return _pHolder ? access()->isLoggedIn() : false;
+}
+
+
+void PooledSessionImpl::invalidateLogin()
+{
+	if (_pHolder) access()->invalidateLogin();
+}
+
+
+void PooledSessionImpl::setAuthLifetime(std::size_t seconds)
+{
+	SessionImpl::setAuthLifetime(seconds);
+	access()->setAuthLifetime(seconds);
+}
+
+
+bool PooledSessionImpl::changePW(const std::string& oldCode, const std::string& newCode)
+{
+	return access()->changePW(oldCode, newCode);
+}
+
+
+std::string PooledSessionImpl::getUserList()
+{
+	return access()->getUserList();
+}
+
+
+std::string PooledSessionImpl::getCertBase64String(short ctype)
+{
+	return access()->getCertBase64String(ctype);
+}
+
+
+int PooledSessionImpl::getPinRetryCount()
+{
+	return access()->getPinRetryCount();
+}
+
+
+std::string PooledSessionImpl::getCertInfo(const std::string& base64, int type)
+{
+	return access()->getCertInfo(base64, type);
+}
+
+
+std::string PooledSessionImpl::getSerialNumber()
+{
+	return access()->getSerialNumber();
+}
+
+
+std::string PooledSessionImpl::getKeyID()
+{
+	return access()->getKeyID();
+}
+
+
+std::string PooledSessionImpl::encryptData(const std::string& paintText, const std::string& base64)
+{
+	return access()->encryptData(paintText, base64);
+}
+
+
+std::string PooledSessionImpl::decryptData(const std::string& encryptBuffer)
+{
+	return access()->decryptData(encryptBuffer);
+}
+
+
+std::string PooledSessionImpl::signByP1(const std::string& message)
+{
+	return access()->signByP1(message);
+}
+
+
+bool PooledSessionImpl::verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature)
+{
+	return access()->verifySignByP1(base64, msg, signature);
+}
+
+
+std::string PooledSessionImpl::signByP7(const std::string& textual, int mode)
+{
+	return access()->signByP7(textual, mode);
+}
+
+
+bool PooledSessionImpl::verifySignByP7(const std::string& textual, const std::string& signature)
+{
+	return access()->verifySignByP7(textual, signature);
+}
+
+
+PooledSessionImpl::BatchResults PooledSessionImpl::signBatchP1(const std::vector<std::string>& messages)
+{
+	return access()->signBatchP1(messages);
+}
+
+
+PooledSessionImpl::BatchResults PooledSessionImpl::signBatchP7(const std::vector<std::string>& textuals, int mode)
+{
+	return access()->signBatchP7(textuals, mode);
+}
+
+
+std::string PooledSessionImpl::signDigest(const std::string& digest)
+{
+	return access()->signDigest(digest);
+}
+
+
+std::string PooledSessionImpl::signFile(const std::string& path)
+{
+	return access()->signFile(path);
+}
+
+
+bool PooledSessionImpl::verifyFile(const std::string& base64, const std::string& path, const std::string& signature)
+{
+	return access()->verifyFile(base64, path, signature);
+}
+
+
+void PooledSessionImpl::setFeature(const std::string& name, bool state)
+{
+	access()->setFeature(name, state);
+}
+
+
+bool PooledSessionImpl::getFeature(const std::string& name)
+{
+	return access()->getFeature(name);
+}
+
+
+void PooledSessionImpl::setProperty(const std::string& name, const Poco::Any& value)
+{
+	access()->setProperty(name, value);
+}
+
+
+Poco::Any PooledSessionImpl::getProperty(const std::string& name)
+{
+	return access()->getProperty(name);
+}
+
+
+PooledSessionImpl::BoolResult PooledSessionImpl::loginAsync(const std::string& passwd, const BoolCallback& callback)
+{
+	return access()->loginAsync(passwd, callback);
+}
+
+
+PooledSessionImpl::BoolResult PooledSessionImpl::changePWAsync(const std::string& oldCode, const std::string& newCode, const BoolCallback& callback)
+{
+	return access()->changePWAsync(oldCode, newCode, callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::getUserListAsync(const StringCallback& callback)
+{
+	return access()->getUserListAsync(callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::getCertBase64StringAsync(short ctype, const StringCallback& callback)
+{
+	return access()->getCertBase64StringAsync(ctype, callback);
+}
+
+
+PooledSessionImpl::IntResult PooledSessionImpl::getPinRetryCountAsync(const IntCallback& callback)
+{
+	return access()->getPinRetryCountAsync(callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback)
+{
+	return access()->getCertInfoAsync(base64, type, callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::getSerialNumberAsync(const StringCallback& callback)
+{
+	return access()->getSerialNumberAsync(callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::getKeyIDAsync(const StringCallback& callback)
+{
+	return access()->getKeyIDAsync(callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback)
+{
+	return access()->encryptDataAsync(paintText, base64, callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback)
+{
+	return access()->decryptDataAsync(encryptBuffer, callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::signByP1Async(const std::string& message, const StringCallback& callback)
+{
+	return access()->signByP1Async(message, callback);
+}
+
+
+PooledSessionImpl::BoolResult PooledSessionImpl::verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback)
+{
+	return access()->verifySignByP1Async(base64, msg, signature, callback);
+}
+
+
+PooledSessionImpl::StringResult PooledSessionImpl::signByP7Async(const std::string& textual, int mode, const StringCallback& callback)
+{
+	return access()->signByP7Async(textual, mode, callback);
+}
+
+
+PooledSessionImpl::BoolResult PooledSessionImpl::verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback)
+{
+	return access()->verifySignByP7Async(textual, signature, callback);
+}
+
+
+SessionImpl* PooledSessionImpl::access() const
+{
+	if (_pHolder)
+	{
+		_pHolder->access();
+		return _pHolder->session();
+	}
+	else throw SessionUnavailableException();
+}
+
+
+} } // namespace Reach::Data
@@ -0,0 +1,433 @@
+//
+// QueuedSessionImpl.cpp
+//
+// Library: Data
+// Package: Execution
+// Module:  QueuedSessionImpl
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/QueuedSessionImpl.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+QueuedSessionImpl::QueuedSessionImpl(Poco::AutoPtr<SessionImpl> pImpl, DeviceWorker::Ptr pWorker):
+	SessionImpl(pImpl->connectionString(), pImpl->getLoginTimeout()),
+	_pImpl(pImpl),
+	_pWorker(pWorker)
+{
+	poco_check_ptr (_pWorker.get());
+}
+
+
+QueuedSessionImpl::~QueuedSessionImpl()
+{
+	try
+	{
+		release();
+
+		// make sure the device is released on its own thread
+		if (_pImpl->isConnected()) close();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
+}
+
+
+void QueuedSessionImpl::open(const std::string& connect)
+{
+	SessionImpl* pImpl = _pImpl;
+	execute<void>([&]() { pImpl->open(connect); });
+}
+
+
+void QueuedSessionImpl::close()
+{
+	SessionImpl* pImpl = _pImpl;
+	execute<void>([&]() { pImpl->close(); });
+}
+
+
+bool QueuedSessionImpl::isConnected()
+{
+	return _pImpl->isConnected();
+}
+
+
+bool QueuedSessionImpl::isAlive()
+{
+	return _pImpl->isAlive();
+}
+
+
+void QueuedSessionImpl::setConnectionTimeout(std::size_t timeout)
+{
+	_pImpl->setConnectionTimeout(timeout);
+}
+
+
+std::size_t QueuedSessionImpl::getConnectionTimeout()
+{
+	return _pImpl->getConnectionTimeout();
+}
+
+
+const std::string& QueuedSessionImpl::connectorName() const
+{
+	return _pImpl->connectorName();
+}
+
+
+const std::string& QueuedSessionImpl::contianerName() const
+{
+	return _pImpl->contianerName();
+}
+
+
+void QueuedSessionImpl::setFeature(const std::string& name, bool state)
+{
+	_pImpl->setFeature(name, state);
+}
+
+
+bool QueuedSessionImpl::getFeature(const std::string& name)
+{
+	return _pImpl->getFeature(name);
+}
+
+
+void QueuedSessionImpl::setProperty(const std::string& name, const Poco::Any& value)
+{
+	_pImpl->setProperty(name, value);
+}
+
+
+Poco::Any QueuedSessionImpl::getProperty(const std::string& name)
+{
+	return _pImpl->getProperty(name);
+}
+
+
+bool QueuedSessionImpl::login(const std::string& passwd)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<bool>([&]() { return pImpl->login(passwd); });
+}
+
+
+void QueuedSessionImpl::begin()
+{
+	SessionImpl::begin();
+	if (_pWorker->isWorkerThread()) return;
+
+	try
+	{
+		_pHold = _pWorker->hold();
+	}
+	catch (...)
+	{
+		endTransaction();
+		throw;
+	}
+}
+
+
+void QueuedSessionImpl::commit()
+{
+	if (isTransactionOwner()) release();
+	SessionImpl::commit();
+}
+
+
+void QueuedSessionImpl::rollback()
+{
+	if (isTransactionOwner()) release();
+	SessionImpl::rollback();
+}
+
+
+SessionImpl* QueuedSessionImpl::lockDevice()
+{
+	// the hold of a transaction keeps the jobs of other threads queued
+	return 0;
+}
+
+
+void QueuedSessionImpl::release()
+{
+	if (_pHold)
+	{
+		_pHold->end();
+		_pHold = 0;
+	}
+}
+
+
+bool QueuedSessionImpl::isLoggedIn()
+{
+	return _pImpl->isLoggedIn();
+}
+
+
+void QueuedSessionImpl::invalidateLogin()
+{
+	_pImpl->invalidateLogin();
+}
+
+
+void QueuedSessionImpl::setAuthLifetime(std::size_t seconds)
+{
+	SessionImpl::setAuthLifetime(seconds);
+	_pImpl->setAuthLifetime(seconds);
+}
+
+
+bool QueuedSessionImpl::changePW(const std::string& oldCode, const std::string& newCode)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<bool>([&]() { return pImpl->changePW(oldCode, newCode); });
+}
+
+
+std::string QueuedSessionImpl::getUserList()
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->getUserList(); });
+}
+
+
+std::string QueuedSessionImpl::getCertBase64String(short ctype)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->getCertBase64String(ctype); });
+}
+
+
+int QueuedSessionImpl::getPinRetryCount()
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<int>([&]() { return pImpl->getPinRetryCount(); });
+}
+
+
+std::string QueuedSessionImpl::getCertInfo(const std::string& base64, int type)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->getCertInfo(base64, type); });
+}
+
+
+std::string QueuedSessionImpl::getSerialNumber()
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->getSerialNumber(); });
+}
+
+
+std::string QueuedSessionImpl::getKeyID()
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->getKeyID(); });
+}
+
+
+std::string QueuedSessionImpl::encryptData(const std::string& paintText, const std::string& base64)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->encryptData(paintText, base64); });
+}
+
+
+std::string QueuedSessionImpl::decryptData(const std::string& encryptBuffer)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->decryptData(encryptBuffer); });
+}
+
+
+std::string QueuedSessionImpl::signByP1(const std::string& message)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->signByP1(message); });
+}
+
+
+bool QueuedSessionImpl::verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<bool>([&]() { return pImpl->verifySignByP1(base64, msg, signature); });
+}
+
+
+std::string QueuedSessionImpl::signByP7(const std::string& textual, int mode)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->signByP7(textual, mode); });
+}
+
+
+bool QueuedSessionImpl::verifySignByP7(const std::string& textual, const std::string& signature)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<bool>([&]() { return pImpl->verifySignByP7(textual, signature); });
+}
+
+
+QueuedSessionImpl::BatchResults QueuedSessionImpl::signBatchP1(const std::vector<std::string>& messages)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<BatchResults>([&]() { return pImpl->signBatchP1(messages); });
+}
+
+
+QueuedSessionImpl::BatchResults QueuedSessionImpl::signBatchP7(const std::vector<std::string>& textuals, int mode)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<BatchResults>([&]() { return pImpl->signBatchP7(textuals, mode); });
+}
+
+
+std::string QueuedSessionImpl::signDigest(const std::string& digest)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->signDigest(digest); });
+}
+
+
+std::string QueuedSessionImpl::signFile(const std::string& path)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<std::string>([&]() { return pImpl->signFile(path); });
+}
+
+
+bool QueuedSessionImpl::verifyFile(const std::string& base64, const std::string& path, const std::string& signature)
+{
+	SessionImpl* pImpl = _pImpl;
+	return execute<bool>([&]() { return pImpl->verifyFile(base64, path, signature); });
+}
+
+
+QueuedSessionImpl::VoidResult QueuedSessionImpl::openAsync(const std::string& connect)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<void>([=]() { pImpl->open(connect); });
+}
+
+
+QueuedSessionImpl::VoidResult QueuedSessionImpl::closeAsync()
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<void>([=]() { pImpl->close(); });
+}
+
+
+QueuedSessionImpl::BoolResult QueuedSessionImpl::loginAsync(const std::string& passwd, const BoolCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<bool>([=]() { return pImpl->login(passwd); }, callback);
+}
+
+
+QueuedSessionImpl::BoolResult QueuedSessionImpl::changePWAsync(const std::string& oldCode, const std::string& newCode, const BoolCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<bool>([=]() { return pImpl->changePW(oldCode, newCode); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::getUserListAsync(const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->getUserList(); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::getCertBase64StringAsync(short ctype, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->getCertBase64String(ctype); }, callback);
+}
+
+
+QueuedSessionImpl::IntResult QueuedSessionImpl::getPinRetryCountAsync(const IntCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<int>([=]() { return pImpl->getPinRetryCount(); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->getCertInfo(base64, type); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::getSerialNumberAsync(const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->getSerialNumber(); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::getKeyIDAsync(const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->getKeyID(); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->encryptData(paintText, base64); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->decryptData(encryptBuffer); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::signByP1Async(const std::string& message, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->signByP1(message); }, callback);
+}
+
+
+QueuedSessionImpl::BoolResult QueuedSessionImpl::verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<bool>([=]() { return pImpl->verifySignByP1(base64, msg, signature); }, callback);
+}
+
+
+QueuedSessionImpl::StringResult QueuedSessionImpl::signByP7Async(const std::string& textual, int mode, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<std::string>([=]() { return pImpl->signByP7(textual, mode); }, callback);
+}
+
+
+QueuedSessionImpl::BoolResult QueuedSessionImpl::verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pImpl = _pImpl;
+	return executeAsync<bool>([=]() { return pImpl->verifySignByP7(textual, signature); }, callback);
+}
+
+
+} } // namespace Reach::Data
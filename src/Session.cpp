@@ -24,7 +24,8 @@ namespace Data {
 
 
 Session::Session(Poco::AutoPtr<SessionImpl> pImpl):
-	_pImpl(pImpl)
+	_pImpl(pImpl),
+	_statementCreator(pImpl)
 {
 	poco_check_ptr (pImpl.get());
 }
@@ -47,7 +48,8 @@ Session::Session(const std::string& connection,
 }
 
 
-Session::Session(const Session& other):	_pImpl(other._pImpl)
+Session::Session(const Session& other):	_pImpl(other._pImpl),
+	_statementCreator(other._pImpl)
 {
 }
 
@@ -69,6 +71,7 @@ void Session::swap(Session& other)
 {
 	using std::swap;
 	swap(_pImpl, other._pImpl);
+	_statementCreator.swap(other._statementCreator);
 }
 
 
@@ -2,55 +2,93 @@
 #include "Reach/Data/SessionHolder.h"
 #include "Reach/Data/DataException.h"
 #include "Poco/Exception.h"
+#include "Poco/Delegate.h"
+#include "Poco/ThreadPool.h"
+#include "Poco/String.h"
+#include "Poco/Ascii.h"
 #include "Poco/URI.h"
+#include "Poco/Thread.h"
+#include <algorithm>
+#include <memory>
 
 using Poco::FastMutex;
 
 namespace Reach {
 namespace Data {
 
-SessionContainer::SessionContainer()
+SessionContainer::SessionContainer():
+	_pIndex(new SessionIndex),
+	_epoch(0),
+	_reopen(false),
+	_warmUpOne(this, &SessionContainer::warmUpOneImpl),
+	_warmUpAll(this, &SessionContainer::warmUpAllImpl)
 {
-
+	for (int epoch = 0; epoch < 2; ++epoch)
+	{
+		for (int stripe = 0; stripe < READER_STRIPES; ++stripe)
+			_readers[epoch][stripe].count = 0;
+	}
 }
 
 SessionContainer::~SessionContainer()
 {
-
+	try
+	{
+		_livenessTimer.stop();
+		while (!_monitors.empty()) unwatch(*_monitors.back());
+		delete _pIndex.load();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
 }
 
 void SessionContainer::add(SessionHolder* pSH)
 {
 	poco_check_ptr(pSH);
 
+	std::string k = normalize(pSH->name());
+
 	FastMutex::ScopedLock lock(_mutex);
 
-	if (_sessions.find(pSH->name()) != _sessions.end())
+	const SessionIndex* pCurrent = _pIndex.load();
+	if (pCurrent->find(k) != pCurrent->end())
 		throw SessionExitsException("Session already exists: " + pSH->name());
 
-	pSH->duplicate();
-	_sessions.insert(SessionMap::value_type(pSH->name(), pSH));
+	std::unique_ptr<SessionIndex> pIndex(new SessionIndex(*pCurrent));
+	pIndex->insert(SessionIndex::value_type(k, SessionHolderPtr(pSH, true)));
+	publish(pIndex.release());
 }
 
 Session SessionContainer::add(const std::string& sessionKey,
 	const std::string& connectionString,
 	std::size_t timeout)
 {
-	std::string name = Session::uri(sessionKey, connectionString);
-
-	FastMutex::ScopedLock lock(_mutex);
-	SessionMap::iterator it = _sessions.find(name);
+	std::string k = normalize(Session::uri(sessionKey, connectionString));
 
 	// session already exists, silently return a session from it
-	if (it != _sessions.end()) return it->second->get();
-		
-	Session s(sessionKey, connectionString);
-	SessionHolder* pSH = new SessionHolder(s.impl());
+	SessionHolderPtr pSH = find(k);
+	if (pSH) return pSH->get();
 
-	std::pair<SessionMap::iterator, bool> ins =
-		_sessions.insert(SessionMap::value_type(name, pSH));
+	// opening the device may take a while, lookups must not wait for it
+	Session s(sessionKey, connectionString, timeout);
 
-	return ins.first->second->get();
+	FastMutex::ScopedLock lock(_mutex);
+	const SessionIndex* pCurrent = _pIndex.load();
+	SessionIndex::const_iterator it = pCurrent->find(k);
+	if (it != pCurrent->end())
+	{
+		pSH = it->second;
+		return pSH->get();
+	}
+
+	pSH = new SessionHolder(s.impl());
+	std::unique_ptr<SessionIndex> pIndex(new SessionIndex(*pCurrent));
+	pIndex->insert(SessionIndex::value_type(k, pSH));
+	publish(pIndex.release());
+
+	return pSH->get();
 }
 
 bool SessionContainer::isActive(const std::string& sessionKey,
@@ -59,33 +97,313 @@ bool SessionContainer::isActive(const std::string& sessionKey,
 	std::string name = connectionString.empty() ?
 		sessionKey : Session::uri(sessionKey, connectionString);
 
-	SessionMap::const_iterator it = _sessions.find(name);
-	if (it != _sessions.end() && it->second->isActive())
+	SessionHolderPtr pSH = find(name);
+	return pSH && pSH->isActive();
+}
+
+Session SessionContainer::get(const std::string& name)
+{
+	SessionHolderPtr pSH = find(name);
+	if (!pSH) throw Poco::NotFoundException(name, 0x9001);/// no key device
+	if (pSH->isDead()) throw SessionUnavailableException(name);
+	return pSH->get();
+}
+
+void SessionContainer::remove(const std::string& name)
+{
+	std::string k = normalize(name);
+
+	FastMutex::ScopedLock lock(_mutex);
+	const SessionIndex* pCurrent = _pIndex.load();
+	if (pCurrent->find(k) == pCurrent->end()) return;
+
+	std::unique_ptr<SessionIndex> pIndex(new SessionIndex(*pCurrent));
+	pIndex->erase(k);
+	publish(pIndex.release());
+}
+
+void SessionContainer::clear()
+{
+	FastMutex::ScopedLock lock(_mutex);
+	publish(new SessionIndex);
+}
+
+void SessionContainer::shutdown()
+{
+	// shutting down may take a while, writers must not wait for it
+	SessionHolderVec hv = holders("");
+	for (SessionHolderVec::iterator it = hv.begin(); it != hv.end(); ++it)
+		(*it)->shutdown();
+}
+
+SessionContainer::SessionHolderPtr SessionContainer::find(const std::string& name) const
+{
 	{
-		return true;
+		Snapshot index(*this);
+		SessionIndex::const_iterator it = index->find(name);
+		if (it != index->end()) return it->second;
 	}
 
-	return false;
+	// keys are stored normalized, names built by Session::uri() match at once
+	std::string k = normalize(name);
+	if (k == name) return SessionHolderPtr();
+
+	Snapshot index(*this);
+	SessionIndex::const_iterator it = index->find(k);
+	if (it == index->end()) return SessionHolderPtr();
+	return it->second;
 }
 
-Session SessionContainer::get(const std::string& name)
+void SessionContainer::publish(SessionIndex* pIndex)
+{
+	// called with the mutex held, so there is no other writer
+	std::unique_ptr<SessionIndex> pRetired(_pIndex.exchange(pIndex));
+
+	// a reader registering from now on loads the new index; the readers that
+	// may still use the replaced one are counted in either epoch, and each
+	// flip lets the readers of the previous epoch drain while new ones
+	// register with the other
+	for (int i = 0; i < 2; ++i)
+	{
+		int epoch = _epoch.load();
+		_epoch = 1 - epoch;
+		waitForReaders(epoch);
+	}
+}
+
+void SessionContainer::waitForReaders(int epoch) const
+{
+	for (int stripe = 0; stripe < READER_STRIPES; ++stripe)
+	{
+		while (_readers[epoch][stripe].count.load() != 0)
+			Poco::Thread::yield();
+	}
+}
+
+std::string SessionContainer::normalize(const std::string& name)
+{
+	try
+	{
+		Poco::URI uri(name);
+		if (uri.getScheme().empty() || uri.getPath().empty()) return name;
+		return Session::uri(uri.getScheme(), uri.getPath().substr(1));
+	}
+	catch (Poco::SyntaxException&)
+	{
+		return name;
+	}
+}
+
+int SessionContainer::readerStripe()
+{
+	static std::atomic<unsigned> next(0);
+	static thread_local int stripe = -1;
+
+	if (stripe < 0) stripe = static_cast<int>(next++ % READER_STRIPES);
+	return stripe;
+}
+
+SessionContainer::Snapshot::Snapshot(const SessionContainer& container)
+{
+	// registering first keeps the index loaded below from being deleted
+	_pReaders = &container._readers[container._epoch.load()][readerStripe()].count;
+	++*_pReaders;
+	_pIndex = container._pIndex.load();
+}
+
+SessionContainer::Snapshot::~Snapshot()
+{
+	--*_pReaders;
+}
+
+std::size_t SessionContainer::KeyHash::operator () (const std::string& name) const
+{
+	// FNV-1a over the lowercased name
+	std::size_t hash = 2166136261U;
+	for (std::string::const_iterator it = name.begin(); it != name.end(); ++it)
+	{
+		hash ^= static_cast<unsigned char>(Poco::Ascii::toLower(*it));
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+bool SessionContainer::KeyEqual::operator () (const std::string& name1, const std::string& name2) const
 {
-	Poco::URI uri(name);
-	std::string path = uri.getPath();
-	poco_assert(!path.empty());
-	std::string n = Session::uri(uri.getScheme(), path.substr(1));
+	return name1.size() == name2.size() && Poco::icompare(name1, name2) == 0;
+}
 
+void SessionContainer::watch(DeviceMonitor& monitor)
+{
 	FastMutex::ScopedLock lock(_mutex);
-	SessionMap::iterator it = _sessions.find(n);
-	if (_sessions.end() == it) throw Poco::NotFoundException(n, 0x9001);/// no key device
-	return it->second->get();
+	if (std::find(_monitors.begin(), _monitors.end(), &monitor) != _monitors.end()) return;
+
+	monitor.deviceConnected += Poco::delegate(this, &SessionContainer::onDeviceConnected);
+	monitor.deviceDisconnected += Poco::delegate(this, &SessionContainer::onDeviceDisconnected);
+	_monitors.push_back(&monitor);
 }
 
-void SessionContainer::shutdown()
+void SessionContainer::unwatch(DeviceMonitor& monitor)
+{
+	FastMutex::ScopedLock lock(_mutex);
+	MonitorVec::iterator it = std::find(_monitors.begin(), _monitors.end(), &monitor);
+	if (it == _monitors.end()) return;
+
+	monitor.deviceConnected -= Poco::delegate(this, &SessionContainer::onDeviceConnected);
+	monitor.deviceDisconnected -= Poco::delegate(this, &SessionContainer::onDeviceDisconnected);
+	_monitors.erase(it);
+}
+
+SessionContainer::SessionHolderVec SessionContainer::holders(const std::string& connector) const
+{
+	SessionHolderVec result;
+
+	Snapshot index(*this);
+	SessionIndex::const_iterator it = index->begin();
+	SessionIndex::const_iterator end = index->end();
+	for (; it != end; ++it)
+	{
+		SessionHolderPtr pSH = it->second;
+		if (connector.empty() || Poco::icompare(pSH->session()->connectorName(), connector) == 0)
+			result.push_back(pSH);
+	}
+	return result;
+}
+
+void SessionContainer::onDeviceConnected(const void* pSender, const std::string& connector)
 {
-	SessionMap::iterator it = _sessions.begin();
-	SessionMap::iterator end = _sessions.end();
-	for (; it != end; ++it) it->second->shutdown();
+	// reopening may take a while, so do it outside the lock
+	SessionHolderVec hv = holders(connector);
+	for (SessionHolderVec::iterator it = hv.begin(); it != hv.end(); ++it)
+		(*it)->revive();
+}
+
+void SessionContainer::onDeviceDisconnected(const void* pSender, const std::string& connector)
+{
+	SessionHolderVec hv = holders(connector);
+	for (SessionHolderVec::iterator it = hv.begin(); it != hv.end(); ++it)
+		(*it)->markDead();
+}
+
+void SessionContainer::startLivenessCheck(long interval, bool reopen)
+{
+	poco_assert (interval > 0);
+
+	_livenessTimer.stop();
+	_reopen = reopen;
+	_livenessTimer.setStartInterval(interval);
+	_livenessTimer.setPeriodicInterval(interval);
+	_livenessTimer.start(Poco::TimerCallback<SessionContainer>(*this, &SessionContainer::onLivenessTimer));
+}
+
+void SessionContainer::stopLivenessCheck()
+{
+	_livenessTimer.stop();
+}
+
+void SessionContainer::checkLiveness(bool reopen)
+{
+	SessionHolderVec hv = holders("");
+
+	SessionHolderVec evict;
+	for (SessionHolderVec::iterator it = hv.begin(); it != hv.end(); ++it)
+	{
+		if (!(*it)->isActive() || (*it)->checkAlive()) continue;
+		if (!reopen || !(*it)->revive()) evict.push_back(*it);
+	}
+
+	if (evict.empty()) return;
+
+	FastMutex::ScopedLock lock(_mutex);
+	std::unique_ptr<SessionIndex> pIndex(new SessionIndex(*_pIndex.load()));
+	for (SessionHolderVec::iterator it = evict.begin(); it != evict.end(); ++it)
+	{
+		// the session may have been replaced in the meantime
+		SessionIndex::iterator sIt = pIndex->find(normalize((*it)->name()));
+		if (sIt != pIndex->end() && sIt->second == *it) pIndex->erase(sIt);
+	}
+	publish(pIndex.release());
+}
+
+void SessionContainer::onLivenessTimer(Poco::Timer&)
+{
+	try
+	{
+		checkLiveness(_reopen);
+	}
+	catch (Poco::Exception&)
+	{
+	}
+}
+
+Poco::ActiveResult<int> SessionContainer::warmUp(const std::vector<std::string>& uris,
+	std::size_t timeout)
+{
+	return _warmUpAll(WarmUpAll(uris, timeout));
+}
+
+bool SessionContainer::warmUpOneImpl(const WarmUpOne& arg)
+{
+	// the connector opens and probes the device while the session is created
+	Session s(arg.first, arg.second);
+	if (!s.isConnected()) throw ConnectionFailedException(arg.first);
+
+	std::string k = normalize(s.uri());
+
+	FastMutex::ScopedLock lock(_mutex);
+	const SessionIndex* pCurrent = _pIndex.load();
+	if (pCurrent->find(k) == pCurrent->end())
+	{
+		std::unique_ptr<SessionIndex> pIndex(new SessionIndex(*pCurrent));
+		pIndex->insert(SessionIndex::value_type(k, new SessionHolder(s.impl())));
+		publish(pIndex.release());
+	}
+	return true;
+}
+
+int SessionContainer::warmUpAllImpl(const WarmUpAll& arg)
+{
+	typedef Poco::ActiveResult<bool> Result;
+	typedef std::vector<std::pair<std::string, Result> > ResultVec;
+
+	ResultVec results;
+	std::string errors;
+	int ready = 0;
+
+	std::vector<std::string>::const_iterator it = arg.first.begin();
+	std::vector<std::string>::const_iterator end = arg.first.end();
+	for (; it != end; ++it)
+	{
+		try
+		{
+			results.push_back(ResultVec::value_type(*it, _warmUpOne(WarmUpOne(*it, arg.second))));
+		}
+		catch (Poco::NoThreadAvailableException&)
+		{
+			// thread pool exhausted, create the session on this thread
+			try
+			{
+				warmUpOneImpl(WarmUpOne(*it, arg.second));
+				++ready;
+			}
+			catch (Poco::Exception& exc)
+			{
+				errors.append(*it).append(": ").append(exc.displayText()).append("; ");
+			}
+		}
+	}
+
+	for (ResultVec::iterator rIt = results.begin(); rIt != results.end(); ++rIt)
+	{
+		rIt->second.wait();
+		if (rIt->second.exception())
+			errors.append(rIt->first).append(": ").append(rIt->second.exception()->displayText()).append("; ");
+		else
+			++ready;
+	}
+
+	if (!errors.empty()) throw SessionUnavailableException(errors);
+	return ready;
 }
 
 } } /// namespace Reach::Data
\ No newline at end of file
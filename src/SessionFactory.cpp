@@ -13,6 +13,8 @@
 
 
 #include "Reach/Data/SessionFactory.h"
+#include "Reach/Data/QueuedSessionImpl.h"
+#include "Reach/Data/BalancedSessionImpl.h"
 #include "Poco/URI.h"
 #include "Poco/String.h"
 
@@ -55,7 +57,58 @@ void SessionFactory::remove(const std::string& key)
 	poco_assert (_connectors.end() != it);
 
 	--(it->second.cnt);
-	if (it->second.cnt == 0) _connectors.erase(it);
+	if (it->second.cnt == 0)
+	{
+		_connectors.erase(it);
+
+		std::string prefix = key + "#";
+		Workers::iterator wIt = _workers.begin();
+		while (wIt != _workers.end())
+		{
+			if (Poco::icompare(wIt->first, 0, prefix.size(), prefix) == 0)
+				_workers.erase(wIt++);
+			else
+				++wIt;
+		}
+	}
+}
+
+
+void SessionFactory::setExecutionMode(const std::string& key, ExecutionMode mode)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	Connectors::iterator it = _connectors.find(key);
+	if (_connectors.end() == it) throw Poco::NotFoundException(key);
+	if (mode == EXEC_BALANCED && !it->second.ptrSI->supportsBalancing())
+		throw Poco::NotImplementedException("Balanced execution not supported by connector", key);
+	it->second.mode = mode;
+}
+
+
+SessionFactory::ExecutionMode SessionFactory::getExecutionMode(const std::string& key) const
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	Connectors::const_iterator it = _connectors.find(key);
+	if (_connectors.end() == it) throw Poco::NotFoundException(key);
+	return it->second.mode;
+}
+
+
+void SessionFactory::setExecutor(const std::string& key, StatementExecutor::Ptr pExecutor)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	Connectors::iterator it = _connectors.find(key);
+	if (_connectors.end() == it) throw Poco::NotFoundException(key);
+	it->second.pExecutor = pExecutor;
+}
+
+
+StatementExecutor::Ptr SessionFactory::getExecutor(const std::string& key) const
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	Connectors::const_iterator it = _connectors.find(key);
+	if (_connectors.end() == it) throw Poco::NotFoundException(key);
+	return it->second.pExecutor;
 }
 
 
@@ -64,13 +117,94 @@ Session SessionFactory::create(const std::string& key,
 	std::size_t timeout)
 {
 	Poco::SharedPtr<Connector> ptrSI;
+	ExecutionMode mode;
+	StatementExecutor::Ptr pExecutor;
 	{
 		Poco::FastMutex::ScopedLock lock(_mutex);
 		Connectors::iterator it = _connectors.find(key);
 		if (_connectors.end() == it) throw Poco::NotFoundException(key);
 		ptrSI = it->second.ptrSI;
+		mode = it->second.mode;
+		pExecutor = it->second.pExecutor;
 	}
-	return Session(ptrSI->createSession(connectionString, timeout));
+
+	Poco::AutoPtr<SessionImpl> pImpl = createImpl(ptrSI, mode, connectionString, timeout);
+	if (pExecutor) pImpl->setExecutor(pExecutor);
+	return Session(pImpl);
+}
+
+
+Poco::AutoPtr<SessionImpl> SessionFactory::createImpl(Poco::SharedPtr<Connector> ptrSI,
+	ExecutionMode mode,
+	const std::string& connectionString,
+	std::size_t timeout)
+{
+	std::string uri = SessionImpl::uri(ptrSI->name(), connectionString);
+	switch (mode)
+	{
+	case EXEC_QUEUED:
+		{
+			DeviceWorker::Ptr pWorker;
+			{
+				Poco::FastMutex::ScopedLock lock(_mutex);
+				pWorker = getWorker(ptrSI->name(), "");
+			}
+			return createQueued(ptrSI, pWorker, connectionString, timeout, "");
+		}
+	case EXEC_BALANCED:
+		{
+			std::vector<std::string> devices = ptrSI->devices();
+			if (devices.empty()) throw Poco::NotFoundException("No devices attached", uri);
+
+			std::vector<DeviceWorker::Ptr> workers;
+			{
+				Poco::FastMutex::ScopedLock lock(_mutex);
+				// the first device is the one opened by sessions without a
+				// device name, so it shares the worker of the queued sessions
+				workers.push_back(getWorker(ptrSI->name(), ""));
+				for (std::size_t i = 1; i < devices.size(); ++i)
+					workers.push_back(getWorker(ptrSI->name(), devices[i]));
+			}
+
+			// open all devices concurrently, each on its own worker
+			std::vector<Poco::ActiveResult<Poco::AutoPtr<SessionImpl> > > results;
+			for (std::size_t i = 0; i < devices.size(); ++i)
+			{
+				std::string device = devices[i];
+				results.push_back(workers[i]->submit<Poco::AutoPtr<SessionImpl> >([=]()
+				{
+					return ptrSI->createDeviceSession(connectionString, timeout, device);
+				}));
+			}
+
+			BalancedSessionImpl::Members members;
+			for (std::size_t i = 0; i < devices.size(); ++i)
+			{
+				Poco::AutoPtr<SessionImpl> pImpl = DeviceWorker::await(results[i]);
+				members.push_back(new QueuedSessionImpl(pImpl, workers[i]));
+			}
+			return new BalancedSessionImpl(members);
+		}
+	default:
+		return ptrSI->createSession(connectionString, timeout);
+	}
+}
+
+
+Poco::AutoPtr<SessionImpl> SessionFactory::createQueued(Poco::SharedPtr<Connector> ptrSI,
+	DeviceWorker::Ptr pWorker,
+	const std::string& connectionString,
+	std::size_t timeout,
+	const std::string& device)
+{
+	// the device is opened by the session constructor,
+	// so it has to be created on the worker thread as well
+	Poco::AutoPtr<SessionImpl> pImpl = DeviceWorker::await(
+		pWorker->submit<Poco::AutoPtr<SessionImpl> >([&]()
+		{
+			return ptrSI->createDeviceSession(connectionString, timeout, device);
+		}));
+	return new QueuedSessionImpl(pImpl, pWorker);
 }
 
 
@@ -83,9 +217,38 @@ Session SessionFactory::create(const std::string& uri,
 }
 
 
+DeviceWorker::Ptr SessionFactory::worker(const std::string& key, const std::string& device)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	return getWorker(key, device);
+}
+
+
+DeviceWorker::Ptr SessionFactory::queuedWorker(const std::string& key, const std::string& device)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	Connectors::const_iterator it = _connectors.find(key);
+	if (_connectors.end() == it || it->second.mode == EXEC_DIRECT) return DeviceWorker::Ptr();
+	return getWorker(key, device);
+}
+
+
+DeviceWorker::Ptr SessionFactory::getWorker(const std::string& key, const std::string& device)
+{
+	std::string id = key + "#" + device;
+	Workers::iterator it = _workers.find(id);
+	if (it != _workers.end()) return it->second;
+
+	DeviceWorker::Ptr pWorker = new DeviceWorker(id);
+	_workers.insert(Workers::value_type(id, pWorker));
+	return pWorker;
+}
+
+
 SessionFactory::SessionInfo::SessionInfo(Connector* pSI): 
 	cnt(1), 
-	ptrSI(pSI)
+	ptrSI(pSI),
+	mode(EXEC_DIRECT)
 {
 }
 
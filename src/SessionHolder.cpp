@@ -1,10 +1,11 @@
 #include "Reach/Data/SessionHolder.h"
+#include "Poco/Exception.h"
 
 namespace Reach {
 namespace Data {
 
 SessionHolder::SessionHolder(SessionImpl* pSessionImpl)
-	:_pImpl(pSessionImpl, true), _shutdown(false)
+	:_pImpl(pSessionImpl, true), _shutdown(false), _dead(false), _reviving(false)
 {
 
 }
@@ -16,10 +17,64 @@ SessionHolder::~SessionHolder()
 
 void SessionHolder::shutdown()
 {
-	if (_shutdown) return;
-	_shutdown = true;
+	if (_shutdown.exchange(true)) return;
 
 	_pImpl->close();
 }
 
+void SessionHolder::markDead()
+{
+	// the state is flipped first, the device I/O below must not block
+	// readers of isDead()
+	if (_dead.exchange(true)) return;
+
+	// a removed key forgets its PIN, even if closing fails
+	_pImpl->invalidateLogin();
+	try
+	{
+		_pImpl->close();
+	}
+	catch (Poco::Exception&)
+	{
+		// the device is gone, closing may legitimately fail
+	}
+}
+
+bool SessionHolder::checkAlive()
+{
+	if (isDead()) return false;
+
+	bool alive = false;
+	try
+	{
+		alive = _pImpl->isAlive();
+	}
+	catch (Poco::Exception&)
+	{
+	}
+
+	if (!alive) markDead();
+	return alive;
+}
+
+bool SessionHolder::revive()
+{
+	if (_shutdown) return false;
+	if (!_dead) return true;
+	if (_reviving.exchange(true)) return false;
+
+	bool alive = false;
+	try
+	{
+		_pImpl->open();
+		alive = true;
+	}
+	catch (Poco::Exception&)
+	{
+	}
+	if (alive) _dead = false;
+	_reviving = false;
+	return alive;
+}
+
 } } ///  namespace Reach::Data
\ No newline at end of file
@@ -13,16 +13,91 @@
 
 
 #include "Reach/Data/SessionImpl.h"
+#include "Reach/Data/StatementImpl.h"
+#include "Reach/Data/StatementTemplate.h"
+#include "Reach/Data/DataException.h"
+#include "Reach/Data/MessageDigest.h"
+#include "Reach/Data/SignatureVerifier.h"
+#include "Reach/Data/FileCipher.h"
 #include "Poco/Exception.h"
+#include <openssl/crypto.h>
 
 
 namespace Reach {
 namespace Data {
 
 
+namespace
+{
+	std::string toHex(const std::string& bytes)
+	{
+		static const char digits[] = "0123456789ABCDEF";
+		std::string result;
+		result.reserve(bytes.size()*2);
+		for (std::string::const_iterator it = bytes.begin(); it != bytes.end(); ++it)
+		{
+			unsigned char c = static_cast<unsigned char>(*it);
+			result += digits[c >> 4];
+			result += digits[c & 0x0F];
+		}
+		return result;
+	}
+
+
+	int hexDigit(char c)
+	{
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		throw Poco::DataFormatException("invalid file key");
+	}
+
+
+	std::string fromHex(const std::string& hex)
+	{
+		if (hex.size() % 2 != 0) throw Poco::DataFormatException("invalid file key");
+		std::string result;
+		result.reserve(hex.size()/2);
+		for (std::size_t i = 0; i < hex.size(); i += 2)
+		{
+			result += static_cast<char>((hexDigit(hex[i]) << 4) | hexDigit(hex[i + 1]));
+		}
+		return result;
+	}
+
+
+	class KeyWiper
+		/// Cleanses the copies of a file key on scope exit,
+		/// including when the cipher could not be set up.
+	{
+	public:
+		KeyWiper(std::string& key, std::string& hex):
+			_key(key),
+			_hex(hex)
+		{
+		}
+
+		~KeyWiper()
+		{
+			if (!_key.empty()) OPENSSL_cleanse(&_key[0], _key.size());
+			if (!_hex.empty()) OPENSSL_cleanse(&_hex[0], _hex.size());
+		}
+
+	private:
+		std::string& _key;
+		std::string& _hex;
+	};
+}
+
+
 SessionImpl::SessionImpl(const std::string& connectionString, std::size_t timeout):
 	_connectionString(connectionString),
-	_loginTimeout(timeout)
+	_loginTimeout(timeout),
+	_authLifetime(AUTH_LIFETIME_DEFAULT),
+	_loggedIn(false),
+	_transaction(false),
+	_transactionOwner(),
+	_pTemplates(new StatementTemplateCache)
 {
 }
 
@@ -32,6 +107,174 @@ SessionImpl::~SessionImpl()
 }
 
 
+bool SessionImpl::isAlive()
+{
+	return isConnected();
+}
+
+
+bool SessionImpl::ensureLoggedIn(const std::string& passwd)
+{
+	if (isLoggedIn()) return true;
+
+	return login(passwd);
+}
+
+
+bool SessionImpl::isLoggedIn()
+{
+	Poco::FastMutex::ScopedLock lock(_stateMutex);
+	if (!_loggedIn) return false;
+	if (_authLifetime == AUTH_LIFETIME_INFINITE) return true;
+
+	Poco::Timestamp::TimeDiff lifetime = static_cast<Poco::Timestamp::TimeDiff>(_authLifetime)*Poco::Timestamp::resolution();
+	if (!_loginTime.isElapsed(lifetime)) return true;
+
+	_loggedIn = false;
+	return false;
+}
+
+
+void SessionImpl::invalidateLogin()
+{
+	setLoggedIn(false);
+}
+
+
+void SessionImpl::setAuthLifetime(std::size_t seconds)
+{
+	Poco::FastMutex::ScopedLock lock(_stateMutex);
+	_authLifetime = seconds;
+}
+
+
+void SessionImpl::setLoggedIn(bool loggedIn)
+{
+	Poco::FastMutex::ScopedLock lock(_stateMutex);
+	_loggedIn = loggedIn;
+	if (loggedIn) _loginTime.update();
+}
+
+
+void SessionImpl::begin()
+{
+	if (isTransactionOwner())
+		throw Poco::InvalidAccessException("Transaction already in progress");
+
+	_deviceLock.writeLock();
+	Poco::FastMutex::ScopedLock lock(_stateMutex);
+	_transaction = true;
+	_transactionOwner = Poco::Thread::currentTid();
+}
+
+
+void SessionImpl::commit()
+{
+	endTransaction();
+}
+
+
+void SessionImpl::rollback()
+{
+	endTransaction();
+	invalidateLogin();
+}
+
+
+bool SessionImpl::canTransact()
+{
+	return true;
+}
+
+
+bool SessionImpl::isTransaction()
+{
+	Poco::FastMutex::ScopedLock lock(_stateMutex);
+	return _transaction;
+}
+
+
+bool SessionImpl::isTransactionOwner() const
+{
+	Poco::FastMutex::ScopedLock lock(_stateMutex);
+	return _transaction && _transactionOwner == Poco::Thread::currentTid();
+}
+
+
+void SessionImpl::endTransaction()
+{
+	{
+		Poco::FastMutex::ScopedLock lock(_stateMutex);
+		if (!_transaction || _transactionOwner != Poco::Thread::currentTid())
+			throw Poco::InvalidAccessException("No transaction in progress");
+
+		_transaction = false;
+	}
+	_deviceLock.unlock();
+}
+
+
+SessionImpl* SessionImpl::lockDevice()
+{
+	if (isTransactionOwner()) return 0;
+
+	_deviceLock.readLock();
+	return this;
+}
+
+
+void SessionImpl::unlockDevice()
+{
+	_deviceLock.unlock();
+}
+
+
+//
+// SessionImpl::DeviceGuard
+//
+
+
+SessionImpl::DeviceGuard::DeviceGuard(SessionImpl& session):
+	_pLocked(session.lockDevice())
+{
+}
+
+
+SessionImpl::DeviceGuard::~DeviceGuard()
+{
+	if (_pLocked) _pLocked->unlockDevice();
+}
+
+
+Poco::SharedPtr<StatementImpl> SessionImpl::createStatementImpl()
+{
+	return new StatementImpl(*this);
+}
+
+
+Poco::SharedPtr<StatementTemplate> SessionImpl::statementTemplate(const std::string& text)
+{
+	return _pTemplates->find(text);
+}
+
+
+void SessionImpl::setExecutor(StatementExecutor::Ptr pExecutor)
+{
+	Poco::FastMutex::ScopedLock lock(_stateMutex);
+	_pExecutor = pExecutor;
+}
+
+
+StatementExecutor::Ptr SessionImpl::getExecutor() const
+{
+	{
+		Poco::FastMutex::ScopedLock lock(_stateMutex);
+		if (_pExecutor) return _pExecutor;
+	}
+	return StatementExecutor::defaultExecutor();
+}
+
+
 void SessionImpl::reconnect()
 {
 	close();
@@ -39,6 +282,199 @@ void SessionImpl::reconnect()
 }
 
 
+SessionImpl::BatchResults SessionImpl::signBatchP1(const std::vector<std::string>& messages)
+{
+	BatchResults results(messages.size());
+	for (std::size_t i = 0; i < messages.size(); ++i)
+	{
+		try
+		{
+			CancellationToken::checkCurrent();
+			results[i].value = signByP1(messages[i]);
+		}
+		catch (Poco::Exception& exc)
+		{
+			results[i].setError(exc);
+		}
+	}
+	return results;
+}
+
+
+SessionImpl::BatchResults SessionImpl::signBatchP7(const std::vector<std::string>& textuals, int mode)
+{
+	BatchResults results(textuals.size());
+	for (std::size_t i = 0; i < textuals.size(); ++i)
+	{
+		try
+		{
+			CancellationToken::checkCurrent();
+			results[i].value = signByP7(textuals[i], mode);
+		}
+		catch (Poco::Exception& exc)
+		{
+			results[i].setError(exc);
+		}
+	}
+	return results;
+}
+
+
+std::string SessionImpl::signDigest(const std::string& digest)
+{
+	throw NotSupportedException("signDigest", connectorName());
+}
+
+
+std::string SessionImpl::signFile(const std::string& path)
+{
+	// hashing a large file is wasted if the digest can not be signed
+	bool supported = false;
+	try
+	{
+		supported = getFeature("digest");
+	}
+	catch (NotSupportedException&)
+	{
+	}
+	if (!supported) throw NotSupportedException("signFile", connectorName());
+
+	std::string certificate = getCertBase64String(SIGN_CERTIFICATE);
+	MessageDigest digest(SignatureVerifier::algorithmFor(certificate), certificate);
+	digest.updateFile(path);
+	return signDigest(digest.digest());
+}
+
+
+bool SessionImpl::verifyFile(const std::string& base64, const std::string& path, const std::string& signature)
+{
+	SignatureVerifier::Ptr pVerifier = new SignatureVerifier(SignatureVerifier::algorithmFor(base64));
+	return pVerifier->verifyFile(base64, path, signature);
+}
+
+
+void SessionImpl::encryptFile(const std::string& inPath, const std::string& outPath)
+{
+	// the key is passed to encryptData() as text, as providers
+	// take the plain text as a C string
+	std::string key = FileCipher::generateKey();
+	std::string hex = toHex(key);
+	KeyWiper wiper(key, hex);
+	std::string wrapped = encryptData(hex, getCertBase64String(EXCHANGE_CERTIFICATE));
+	FileCipher cipher(key);
+	cipher.encryptFile(inPath, outPath, wrapped);
+}
+
+
+void SessionImpl::decryptFile(const std::string& inPath, const std::string& outPath)
+{
+	std::string key;
+	std::string hex = decryptData(FileCipher::keyInfo(inPath));
+	KeyWiper wiper(key, hex);
+	key = fromHex(hex);
+	FileCipher cipher(key);
+	cipher.decryptFile(inPath, outPath);
+}
+
+
+SessionImpl::BoolResult SessionImpl::loginAsync(const std::string& passwd, const BoolCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<bool>([=]() { return pThis->login(passwd); }, callback);
+}
+
+
+SessionImpl::BoolResult SessionImpl::changePWAsync(const std::string& oldCode, const std::string& newCode, const BoolCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<bool>([=]() { return pThis->changePW(oldCode, newCode); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::getUserListAsync(const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->getUserList(); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::getCertBase64StringAsync(short ctype, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->getCertBase64String(ctype); }, callback);
+}
+
+
+SessionImpl::IntResult SessionImpl::getPinRetryCountAsync(const IntCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<int>([=]() { return pThis->getPinRetryCount(); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::getCertInfoAsync(const std::string& base64, int type, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->getCertInfo(base64, type); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::getSerialNumberAsync(const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->getSerialNumber(); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::getKeyIDAsync(const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->getKeyID(); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::encryptDataAsync(const std::string& paintText, const std::string& base64, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->encryptData(paintText, base64); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::decryptDataAsync(const std::string& encryptBuffer, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->decryptData(encryptBuffer); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::signByP1Async(const std::string& message, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->signByP1(message); }, callback);
+}
+
+
+SessionImpl::BoolResult SessionImpl::verifySignByP1Async(const std::string& base64, const std::string& msg, const std::string& signature, const BoolCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<bool>([=]() { return pThis->verifySignByP1(base64, msg, signature); }, callback);
+}
+
+
+SessionImpl::StringResult SessionImpl::signByP7Async(const std::string& textual, int mode, const StringCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<std::string>([=]() { return pThis->signByP7(textual, mode); }, callback);
+}
+
+
+SessionImpl::BoolResult SessionImpl::verifySignByP7Async(const std::string& textual, const std::string& signature, const BoolCallback& callback)
+{
+	Poco::AutoPtr<SessionImpl> pThis(this, true);
+	return submit<bool>([=]() { return pThis->verifySignByP7(textual, signature); }, callback);
+}
+
+
 void SessionImpl::setConnectionString(const std::string& connectionString)
 {
 	if (isConnected())
@@ -0,0 +1,447 @@
+//
+// SessionPool.cpp
+//
+// Library: Data
+// Package: SessionPooling
+// Module:  SessionPool
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/SessionPool.h"
+#include "Reach/Data/SessionFactory.h"
+#include "Reach/Data/DataException.h"
+#include "Poco/Timestamp.h"
+#include "Poco/ScopedUnlock.h"
+#include <algorithm>
+
+
+namespace Reach {
+namespace Data {
+
+
+SessionPool::SessionPool(const std::string& connector, const std::string& connectionString, int minSessions, int maxSessions, int idleTime):
+	_connector(connector),
+	_connectionString(connectionString),
+	_minSessions(minSessions),
+	_maxSessions(maxSessions),
+	_idleTime(idleTime),
+	_nSessions(0),
+	_janitorTimer(1000*idleTime, 1000*idleTime/4),
+	_shutdown(false),
+	_configured(false)
+{
+	try
+	{
+		while (_nSessions < _minSessions)
+		{
+			Session newSession(SessionFactory::instance().create(_connector, _connectionString));
+			_idleSessions.push_back(new PooledSessionHolder(*this, newSession.impl()));
+			++_nSessions;
+		}
+	}
+	catch (Poco::Exception&)
+	{
+		// the device may not be attached yet, get() opens the sessions on demand
+	}
+
+	Poco::TimerCallback<SessionPool> callback(*this, &SessionPool::onJanitorTimer);
+	_janitorTimer.start(callback);
+}
+
+
+SessionPool::~SessionPool()
+{
+	try
+	{
+		shutdown();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
+}
+
+
+Session SessionPool::get(const std::string& name, bool value)
+{
+	Session s = get();
+	SessionImpl* pImpl = static_cast<PooledSessionImpl*>(s.impl())->impl();
+	{
+		Poco::Mutex::ScopedLock lock(_mutex);
+		_addFeatureMap.insert(AddFeatureMap::value_type(pImpl,
+			std::make_pair(name, s.getFeature(name))));
+	}
+	s.setFeature(name, value);
+
+	return s;
+}
+
+
+Session SessionPool::get()
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	if (_shutdown) throw Poco::InvalidAccessException("Session pool has been shut down.");
+
+	purgeDeadSessions();
+
+	if (_idleSessions.empty() && _nSessions >= _maxSessions)
+		throw SessionPoolExhaustedException(_connector);
+
+	return getImpl();
+}
+
+
+Session SessionPool::get(long milliseconds)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	Poco::Timestamp start;
+	while (true)
+	{
+		if (_shutdown) throw Poco::InvalidAccessException("Session pool has been shut down.");
+
+		purgeDeadSessions();
+
+		if (!_idleSessions.empty() || _nSessions < _maxSessions)
+			return getImpl();
+
+		long remaining = milliseconds - static_cast<long>(start.elapsed()/1000);
+		if (remaining <= 0 || !_sessionReturned.tryWait(_mutex, remaining))
+			throw SessionPoolExhaustedException(_connector);
+	}
+}
+
+
+Session SessionPool::getImpl()
+{
+	if (!_configured) configure();
+
+	if (_idleSessions.empty())
+	{
+		// the slot is taken before opening the device,
+		// so the mutex can be released meanwhile
+		++_nSessions;
+		PooledSessionHolderPtr pHolder;
+		try
+		{
+			Poco::ScopedUnlock<Poco::Mutex> unlock(_mutex);
+			Session newSession(SessionFactory::instance().create(_connector, _connectionString));
+			prepare(newSession);
+			pHolder = new PooledSessionHolder(*this, newSession.impl());
+		}
+		catch (...)
+		{
+			--_nSessions;
+			_sessionReturned.signal();
+			throw;
+		}
+
+		if (_shutdown)
+		{
+			try	{ pHolder->session()->close(); }
+			catch (...) { }
+			--_nSessions;
+			throw Poco::InvalidAccessException("Session pool has been shut down.");
+		}
+		_idleSessions.push_front(pHolder);
+	}
+
+	PooledSessionHolderPtr pHolder(_idleSessions.front());
+	PooledSessionImplPtr pPSI(new PooledSessionImpl(pHolder));
+
+	_activeSessions.push_front(pHolder);
+	_idleSessions.pop_front();
+	return Session(pPSI);
+}
+
+
+void SessionPool::configure()
+{
+	_configured = true;
+	if (_idleSessions.empty()) return;
+
+	// the sessions leave the pool while they are prepared without the mutex
+	SessionList opened;
+	opened.swap(_idleSessions);
+	SessionList failed;
+	{
+		Poco::ScopedUnlock<Poco::Mutex> unlock(_mutex);
+		SessionList::iterator it = opened.begin();
+		while (it != opened.end())
+		{
+			try
+			{
+				Session session(Poco::AutoPtr<SessionImpl>((*it)->session(), true));
+				prepare(session);
+				++it;
+			}
+			catch (...)
+			{
+				failed.splice(failed.end(), opened, it++);
+			}
+		}
+	}
+
+	if (!failed.empty())
+	{
+		closeAll(failed);
+		_sessionReturned.signal();
+	}
+	if (_shutdown)
+	{
+		closeAll(opened);
+		throw Poco::InvalidAccessException("Session pool has been shut down.");
+	}
+	_idleSessions.splice(_idleSessions.end(), opened);
+}
+
+
+void SessionPool::prepare(Session& session)
+{
+	applySettings(session.impl());
+	customizeSession(session);
+}
+
+
+void SessionPool::purgeDeadSessions()
+{
+	if (_shutdown) return;
+
+	SessionList::iterator it = _idleSessions.begin();
+	for (; it != _idleSessions.end(); )
+	{
+		if (!(*it)->session()->isConnected())
+		{
+			it = _idleSessions.erase(it);
+			--_nSessions;
+		}
+		else ++it;
+	}
+}
+
+
+int SessionPool::capacity() const
+{
+	return _maxSessions;
+}
+
+
+int SessionPool::used() const
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	return (int) _activeSessions.size();
+}
+
+
+int SessionPool::idle() const
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	return (int) _idleSessions.size();
+}
+
+
+int SessionPool::dead()
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	return deadImpl(_activeSessions);
+}
+
+
+int SessionPool::deadImpl(SessionList& rSessions)
+{
+	int count = 0;
+
+	SessionList::iterator it = rSessions.begin();
+	SessionList::iterator itEnd = rSessions.end();
+	for (; it != itEnd; ++it)
+	{
+		if (!(*it)->session()->isConnected())
+			++count;
+	}
+
+	return count;
+}
+
+
+int SessionPool::allocated() const
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	return _nSessions;
+}
+
+
+int SessionPool::available() const
+{
+	if (_shutdown) return 0;
+	return _maxSessions - used();
+}
+
+
+void SessionPool::setFeature(const std::string& name, bool state)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	if (_shutdown) throw Poco::InvalidAccessException("Session pool has been shut down.");
+
+	if (_configured)
+		throw Poco::InvalidAccessException("Features can not be set after the first session was handed out.");
+
+	_featureMap.insert(FeatureMap::ValueType(name, state));
+}
+
+
+bool SessionPool::getFeature(const std::string& name)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	if (_shutdown) throw Poco::InvalidAccessException("Session pool has been shut down.");
+
+	FeatureMap::ConstIterator it = _featureMap.find(name);
+	if (_featureMap.end() == it)
+		throw Poco::NotFoundException("Feature not found:" + name);
+
+	return it->second;
+}
+
+
+void SessionPool::setProperty(const std::string& name, const Poco::Any& value)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	if (_shutdown) throw Poco::InvalidAccessException("Session pool has been shut down.");
+
+	if (_configured)
+		throw Poco::InvalidAccessException("Properties can not be set after the first session was handed out.");
+
+	_propertyMap.insert(PropertyMap::ValueType(name, value));
+}
+
+
+Poco::Any SessionPool::getProperty(const std::string& name)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	PropertyMap::ConstIterator it = _propertyMap.find(name);
+	if (_propertyMap.end() == it)
+		throw Poco::NotFoundException("Property not found:" + name);
+
+	return it->second;
+}
+
+
+void SessionPool::applySettings(SessionImpl* pImpl)
+{
+	FeatureMap::Iterator fmIt = _featureMap.begin();
+	FeatureMap::Iterator fmEnd = _featureMap.end();
+	for (; fmIt != fmEnd; ++fmIt) pImpl->setFeature(fmIt->first, fmIt->second);
+
+	PropertyMap::Iterator pmIt = _propertyMap.begin();
+	PropertyMap::Iterator pmEnd = _propertyMap.end();
+	for (; pmIt != pmEnd; ++pmIt) pImpl->setProperty(pmIt->first, pmIt->second);
+}
+
+
+void SessionPool::customizeSession(Session&)
+{
+}
+
+
+void SessionPool::putBack(PooledSessionHolderPtr pHolder)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	if (_shutdown) return;
+
+	SessionList::iterator it = std::find(_activeSessions.begin(), _activeSessions.end(), pHolder);
+	if (it != _activeSessions.end())
+	{
+		try
+		{
+			if (pHolder->session()->isConnected())
+			{
+				// reverse settings applied at acquisition time, if any
+				AddPropertyMap::iterator pIt = _addPropertyMap.find(pHolder->session());
+				if (pIt != _addPropertyMap.end())
+				{
+					pHolder->session()->setProperty(pIt->second.first, pIt->second.second);
+					_addPropertyMap.erase(pIt);
+				}
+
+				AddFeatureMap::iterator fIt = _addFeatureMap.find(pHolder->session());
+				if (fIt != _addFeatureMap.end())
+				{
+					pHolder->session()->setFeature(fIt->second.first, fIt->second.second);
+					_addFeatureMap.erase(fIt);
+				}
+
+				_idleSessions.push_front(pHolder);
+			}
+			else --_nSessions;
+		}
+		catch (...)
+		{
+			--_nSessions;
+		}
+
+		_activeSessions.erase(it);
+		_sessionReturned.signal();
+	}
+	else
+	{
+		poco_bugcheck_msg("Unknown session passed to SessionPool::putBack()");
+	}
+}
+
+
+void SessionPool::onJanitorTimer(Poco::Timer&)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	if (_shutdown) return;
+
+	SessionList::iterator it = _idleSessions.begin();
+	while (_nSessions > _minSessions && it != _idleSessions.end())
+	{
+		if ((*it)->idle() > _idleTime || !(*it)->session()->isConnected())
+		{
+			try	{ (*it)->session()->close(); }
+			catch (...) { }
+			it = _idleSessions.erase(it);
+			--_nSessions;
+		}
+		else ++it;
+	}
+}
+
+
+void SessionPool::shutdown()
+{
+	{
+		Poco::Mutex::ScopedLock lock(_mutex);
+		if (_shutdown) return;
+		_shutdown = true;
+		_sessionReturned.broadcast();
+	}
+
+	// the janitor callback takes the mutex, so the timer
+	// must be stopped without holding it
+	_janitorTimer.stop();
+
+	Poco::Mutex::ScopedLock lock(_mutex);
+	closeAll(_idleSessions);
+	closeAll(_activeSessions);
+}
+
+
+void SessionPool::closeAll(SessionList& sessionList)
+{
+	SessionList::iterator it = sessionList.begin();
+	for (; it != sessionList.end();)
+	{
+		try	{ (*it)->session()->close(); }
+		catch (...) { }
+		it = sessionList.erase(it);
+		if (_nSessions > 0) --_nSessions;
+	}
+}
+
+
+} } // namespace Reach::Data
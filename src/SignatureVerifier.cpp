@@ -0,0 +1,364 @@
+//
+// SignatureVerifier.cpp
+//
+// Library: Data
+// Package: Crypto
+// Module:  SignatureVerifier
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/SignatureVerifier.h"
+#include "Reach/Data/MessageDigest.h"
+#include "Reach/Data/DeviceWorker.h"
+#include "Reach/Data/DataException.h"
+#include "Poco/Base64Decoder.h"
+#include "Poco/Exception.h"
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#include <openssl/ec.h>
+#include <openssl/bn.h>
+#include <openssl/err.h>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+
+
+#if defined(_MSC_VER)
+	#pragma comment(lib, "libcrypto.lib")
+#endif
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	std::string decodeBase64(const std::string& base64)
+	{
+		std::istringstream istr(base64);
+		Poco::Base64Decoder decoder(istr);
+		return std::string(std::istreambuf_iterator<char>(decoder), std::istreambuf_iterator<char>());
+	}
+
+
+	std::string sm2ToDER(const std::string& signature)
+		/// Converts a signature given as r || s to the DER
+		/// encoding OpenSSL expects. Other signatures are
+		/// returned unchanged.
+	{
+		if (signature.size() != 64) return signature;
+
+		const unsigned char* pRaw = reinterpret_cast<const unsigned char*>(signature.data());
+		ECDSA_SIG* pSig = ECDSA_SIG_new();
+		if (!pSig) return signature;
+		BIGNUM* r = BN_bin2bn(pRaw, 32, 0);
+		BIGNUM* s = BN_bin2bn(pRaw + 32, 32, 0);
+		if (!r || !s || !ECDSA_SIG_set0(pSig, r, s))
+		{
+			BN_free(r);
+			BN_free(s);
+			ECDSA_SIG_free(pSig);
+			return signature;
+		}
+
+		std::string result;
+		unsigned char* pDER = 0;
+		int length = i2d_ECDSA_SIG(pSig, &pDER);
+		if (length > 0) result.assign(reinterpret_cast<char*>(pDER), static_cast<std::size_t>(length));
+		OPENSSL_free(pDER);
+		ECDSA_SIG_free(pSig);
+		return length > 0 ? result : signature;
+	}
+}
+
+
+//
+// SignatureVerifier::Request
+//
+
+
+SignatureVerifier::Request::Request()
+{
+}
+
+
+SignatureVerifier::Request::Request(const std::string& certificate, const std::string& message, const std::string& signature):
+	certificate(certificate),
+	message(message),
+	signature(signature)
+{
+}
+
+
+//
+// SignatureVerifier::Result
+//
+
+
+SignatureVerifier::Result::Result():
+	valid(false)
+{
+}
+
+
+//
+// SignatureVerifier
+//
+
+
+const std::string SignatureVerifier::DEFAULT_USER_ID("1234567812345678");
+
+
+SignatureVerifier::SignatureVerifier(Algorithm algorithm, StatementExecutor::Ptr pExecutor):
+	_algorithm(algorithm),
+	_pExecutor(pExecutor),
+	_userID(DEFAULT_USER_ID)
+{
+	if (!_pExecutor) _pExecutor = StatementExecutor::defaultExecutor();
+}
+
+
+SignatureVerifier::~SignatureVerifier()
+{
+	try
+	{
+		clearKeys();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
+}
+
+
+void SignatureVerifier::setUserID(const std::string& id)
+{
+	_userID = id;
+}
+
+
+bool SignatureVerifier::verify(const std::string& certificate, const std::string& message, const std::string& signature)
+{
+	// decode first: the decoder throws on a malformed
+	// signature, which must not leak the key reference
+	bool sm2 = _algorithm == ALG_SM3_SM2;
+	std::string raw = decodeBase64(signature);
+	if (sm2) raw = sm2ToDER(raw);
+	EVP_PKEY* pKey = key(certificate);
+
+	const EVP_MD* pDigest = sm2 ? EVP_sm3() : (_algorithm == ALG_SHA1_RSA ? EVP_sha1() : EVP_sha256());
+	EVP_MD_CTX* pContext = EVP_MD_CTX_new();
+	EVP_PKEY_CTX* pKeyContext = 0;
+	bool valid = false;
+	if (pContext)
+	{
+		bool ready = true;
+		if (sm2)
+		{
+			pKeyContext = EVP_PKEY_CTX_new(pKey, 0);
+			ready = pKeyContext && EVP_PKEY_CTX_set1_id(pKeyContext, _userID.data(), static_cast<int>(_userID.size())) > 0;
+			if (ready) EVP_MD_CTX_set_pkey_ctx(pContext, pKeyContext);
+		}
+		valid = ready
+			&& EVP_DigestVerifyInit(pContext, 0, pDigest, 0, pKey) == 1
+			&& EVP_DigestVerify(pContext,
+				reinterpret_cast<const unsigned char*>(raw.data()), raw.size(),
+				reinterpret_cast<const unsigned char*>(message.data()), message.size()) == 1;
+		EVP_MD_CTX_free(pContext);
+	}
+	EVP_PKEY_CTX_free(pKeyContext);
+	EVP_PKEY_free(pKey);
+	ERR_clear_error();
+	return valid;
+}
+
+
+bool SignatureVerifier::verifyDigest(const std::string& certificate, const std::string& digest, const std::string& signature)
+{
+	bool sm2 = _algorithm == ALG_SM3_SM2;
+	std::string raw = decodeBase64(signature);
+	if (sm2) raw = sm2ToDER(raw);
+	EVP_PKEY* pKey = key(certificate);
+
+	// the digest is signed as is for SM2, and wrapped in a DigestInfo for RSA
+	EVP_PKEY_CTX* pContext = EVP_PKEY_CTX_new(pKey, 0);
+	bool valid = pContext
+		&& EVP_PKEY_verify_init(pContext) == 1
+		&& (sm2 || (EVP_PKEY_CTX_set_rsa_padding(pContext, RSA_PKCS1_PADDING) > 0
+			&& EVP_PKEY_CTX_set_signature_md(pContext, _algorithm == ALG_SHA1_RSA ? EVP_sha1() : EVP_sha256()) > 0))
+		&& EVP_PKEY_verify(pContext,
+			reinterpret_cast<const unsigned char*>(raw.data()), raw.size(),
+			reinterpret_cast<const unsigned char*>(digest.data()), digest.size()) == 1;
+	EVP_PKEY_CTX_free(pContext);
+	EVP_PKEY_free(pKey);
+	ERR_clear_error();
+	return valid;
+}
+
+
+bool SignatureVerifier::verifyFile(const std::string& certificate, const std::string& path, const std::string& signature)
+{
+	MessageDigest digest(_algorithm, certificate, _userID);
+	digest.updateFile(path);
+	return verifyDigest(certificate, digest.digest(), signature);
+}
+
+
+SignatureVerifier::Results SignatureVerifier::verifyBatch(const Requests& requests)
+{
+	Results results(requests.size());
+	std::size_t threads = static_cast<std::size_t>(_pExecutor->threads());
+	if (requests.size() < MIN_PARALLEL_BATCH || threads < 2 || _pExecutor->isExecutorThread())
+	{
+		verifyRange(requests, results, 0, requests.size());
+		return results;
+	}
+
+	std::size_t jobs = std::min<std::size_t>(threads*JOBS_PER_THREAD, requests.size());
+	std::size_t chunk = (requests.size() + jobs - 1)/jobs;
+	std::vector<Poco::ActiveResult<void> > pending;
+	pending.reserve(jobs);
+	for (std::size_t begin = 0; begin < requests.size(); begin += chunk)
+	{
+		std::size_t end = std::min(begin + chunk, requests.size());
+		pending.push_back(_pExecutor->submit<void>([this, &requests, &results, begin, end]()
+		{
+			verifyRange(requests, results, begin, end);
+		}));
+	}
+
+	// wait for all jobs before rethrowing, they refer to results
+	for (std::size_t i = 0; i < pending.size(); ++i) pending[i].wait();
+	for (std::size_t i = 0; i < pending.size(); ++i) DeviceWorker::await(pending[i]);
+	return results;
+}
+
+
+void SignatureVerifier::verifyRange(const Requests& requests, Results& results, std::size_t begin, std::size_t end)
+{
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		try
+		{
+			results[i].valid = verify(requests[i].certificate, requests[i].message, requests[i].signature);
+		}
+		catch (Poco::Exception& exc)
+		{
+			results[i].error = exc.displayText();
+		}
+	}
+}
+
+
+EVP_PKEY* SignatureVerifier::key(const std::string& certificate)
+{
+	{
+		Poco::FastMutex::ScopedLock lock(_mutex);
+		KeyMap::iterator it = _keys.find(certificate);
+		if (it != _keys.end())
+		{
+			EVP_PKEY_up_ref(it->second);
+			return it->second;
+		}
+	}
+
+	std::string der = decodeBase64(certificate);
+	const unsigned char* pDER = reinterpret_cast<const unsigned char*>(der.data());
+	X509* pCert = d2i_X509(0, &pDER, static_cast<long>(der.size()));
+	if (!pCert)
+	{
+		ERR_clear_error();
+		throw Poco::DataFormatException("invalid certificate");
+	}
+	EVP_PKEY* pKey = X509_get_pubkey(pCert);
+	X509_free(pCert);
+	if (!pKey)
+	{
+		ERR_clear_error();
+		throw Poco::DataFormatException("invalid certificate public key");
+	}
+
+	bool fits = false;
+	if (_algorithm == ALG_SM3_SM2)
+	{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		fits = EVP_PKEY_is_a(pKey, "SM2");
+#else
+		const EC_KEY* pEC = EVP_PKEY_get0_EC_KEY(pKey);
+		fits = pEC && EC_GROUP_get_curve_name(EC_KEY_get0_group(pEC)) == NID_sm2
+			&& EVP_PKEY_set_alias_type(pKey, EVP_PKEY_SM2) == 1;
+#endif
+	}
+	else fits = EVP_PKEY_base_id(pKey) == EVP_PKEY_RSA;
+	if (!fits)
+	{
+		EVP_PKEY_free(pKey);
+		throw NotSupportedException("certificate key does not fit the signature algorithm");
+	}
+
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	std::pair<KeyMap::iterator, bool> inserted = _keys.insert(KeyMap::value_type(certificate, pKey));
+	if (!inserted.second)
+	{
+		// another thread was quicker
+		EVP_PKEY_free(pKey);
+		pKey = inserted.first->second;
+	}
+	else if (_keys.size() > MAX_CACHED_KEYS)
+	{
+		_keys.erase(inserted.first);
+		clearKeys();
+		_keys.insert(KeyMap::value_type(certificate, pKey));
+	}
+	EVP_PKEY_up_ref(pKey);
+	return pKey;
+}
+
+
+SignatureVerifier::Algorithm SignatureVerifier::algorithmFor(const std::string& certificate)
+{
+	std::string der = decodeBase64(certificate);
+	const unsigned char* pDER = reinterpret_cast<const unsigned char*>(der.data());
+	X509* pCert = d2i_X509(0, &pDER, static_cast<long>(der.size()));
+	if (!pCert)
+	{
+		ERR_clear_error();
+		throw Poco::DataFormatException("invalid certificate");
+	}
+
+	EVP_PKEY* pKey = X509_get0_pubkey(pCert);
+	int type = pKey ? EVP_PKEY_base_id(pKey) : NID_undef;
+	bool sm2 = false;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	sm2 = pKey && EVP_PKEY_is_a(pKey, "SM2");
+#else
+	const EC_KEY* pEC = type == EVP_PKEY_EC ? EVP_PKEY_get0_EC_KEY(pKey) : 0;
+	sm2 = pEC && EC_GROUP_get_curve_name(EC_KEY_get0_group(pEC)) == NID_sm2;
+#endif
+	X509_free(pCert);
+	ERR_clear_error();
+
+	if (sm2) return ALG_SM3_SM2;
+	if (type == EVP_PKEY_RSA) return ALG_SHA256_RSA;
+	throw NotSupportedException("certificate key type");
+}
+
+
+void SignatureVerifier::clearKeys()
+{
+	for (KeyMap::iterator it = _keys.begin(); it != _keys.end(); ++it)
+	{
+		EVP_PKEY_free(it->second);
+	}
+	_keys.clear();
+}
+
+
+} } // namespace Reach::Data
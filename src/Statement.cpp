@@ -15,26 +15,143 @@
 #include "Reach/Data/Statement.h"
 #include "Reach/Data/DataException.h"
 #include "Reach/Data/Session.h"
+#include "Reach/Data/StatementExecutor.h"
 #include "Poco/Any.h"
 #include "Poco/Tuple.h"
-#include "Poco/ActiveMethod.h"
+#include "Poco/ErrorHandler.h"
 #include <algorithm>
+#include <vector>
 
 
 namespace Reach {
 namespace Data {
 
 
+class Statement::Completion: public Poco::RefCountedObject
+	/// Shared by a Statement and its asynchronous execution,
+	/// holds the continuations chained before the execution completes.
+{
+public:
+	Completion(const Result& result, StatementExecutor::Ptr pExecutor):
+		_result(result),
+		_pExecutor(pExecutor),
+		_done(false)
+	{
+	}
+
+	void add(const Continuation& continuation)
+	{
+		{
+			Poco::FastMutex::ScopedLock lock(_mutex);
+			if (!_done)
+			{
+				_continuations.push_back(continuation);
+				return;
+			}
+		}
+		CompletionPtr pThis(this, true);
+		_pExecutor->submit<void>([pThis, continuation]()
+		{
+			pThis->invoke(continuation);
+		});
+	}
+
+	void complete()
+	{
+		std::vector<Continuation> continuations;
+		{
+			Poco::FastMutex::ScopedLock lock(_mutex);
+			_done = true;
+			continuations.swap(_continuations);
+		}
+		for (std::vector<Continuation>::const_iterator it = continuations.begin(); it != continuations.end(); ++it)
+			invoke(*it);
+	}
+
+private:
+	~Completion()
+	{
+	}
+
+	void invoke(const Continuation& continuation)
+	{
+		try
+		{
+			continuation(_result);
+		}
+		catch (Poco::Exception& exc)
+		{
+			Poco::ErrorHandler::handle(exc);
+		}
+		catch (std::exception& exc)
+		{
+			Poco::ErrorHandler::handle(exc);
+		}
+		catch (...)
+		{
+			Poco::ErrorHandler::handle();
+		}
+	}
+
+	Result                    _result;
+	StatementExecutor::Ptr    _pExecutor;
+	std::vector<Continuation> _continuations;
+	bool                      _done;
+	Poco::FastMutex           _mutex;
+};
+
+
+class Statement::ExecutionJob: public DeviceResultJob<std::size_t>
+	/// Executes a statement on its executor and runs
+	/// the continuations chained to the execution.
+{
+public:
+	ExecutionJob(const Function& function, StatementExecutor::Ptr pExecutor):
+		DeviceResultJob<std::size_t>(function),
+		_pCompletion(new Completion(result(), pExecutor))
+	{
+	}
+
+	CompletionPtr completion() const
+	{
+		return _pCompletion;
+	}
+
+	void run()
+	{
+		DeviceResultJob<std::size_t>::run();
+		_pCompletion->complete();
+	}
+
+	void cancel(const std::string& reason)
+	{
+		DeviceResultJob<std::size_t>::cancel(reason);
+		_pCompletion->complete();
+	}
+
+	void reject(const Poco::Exception& exc)
+	{
+		DeviceResultJob<std::size_t>::reject(exc);
+		_pCompletion->complete();
+	}
+
+private:
+	CompletionPtr _pCompletion;
+};
+
+
 Statement::Statement(StatementImpl::Ptr pImpl):
 	_pImpl(pImpl),
-	_async(false)
+	_async(false),
+	_hasDeadline(false)
 {
 	poco_check_ptr (pImpl);
 }
 
 
 Statement::Statement(Session& session):
-	_async(false)
+	_async(false),
+	_hasDeadline(false)
 {
 	reset(session);
 }
@@ -44,8 +161,13 @@ Statement::Statement(const Statement& stmt):
 	_pImpl(stmt._pImpl),
 	_async(stmt._async),
 	_pResult(stmt._pResult),
-	_pAsyncExec(stmt._pAsyncExec),
-	_arguments(stmt._arguments)
+	_pCompletion(stmt._pCompletion),
+	_pCancellation(stmt._pCancellation),
+	_pExecution(stmt._pExecution),
+	_deadline(stmt._deadline),
+	_hasDeadline(stmt._hasDeadline),
+	_arguments(stmt._arguments),
+	_batch(stmt._batch)
 {
 }
 
@@ -69,9 +191,14 @@ void Statement::swap(Statement& other)
 	
 	swap(_pImpl, other._pImpl);
 	swap(_async, other._async);
-	swap(_pAsyncExec, other._pAsyncExec);
+	swap(_pCompletion, other._pCompletion);
 	swap(_pResult, other._pResult);
+	swap(_pCancellation, other._pCancellation);
+	swap(_pExecution, other._pExecution);
+	swap(_deadline, other._deadline);
+	swap(_hasDeadline, other._hasDeadline);
 	_arguments.swap(other._arguments);
+	_batch.swap(other._batch);
 }
 
 
@@ -89,15 +216,15 @@ std::size_t Statement::execute(bool reset)
 	bool isDone = done();
 	if (initialized() || paused() || isDone)
 	{
-		if (_arguments.size()) 
-		{
-			_pImpl->formatSQL(_arguments);
-			_arguments.clear();
-		}
+		bindArguments();
 
 		if (!isAsync())
 		{
 			if (isDone) _pImpl->reset();
+			CancellationToken::Ptr pToken = createToken();
+			if (!pToken) return _pImpl->execute(reset);
+
+			CancellationToken::Scope scope(pToken);
 			return _pImpl->execute(reset);
 		}
 		else
@@ -114,27 +241,106 @@ const Statement::Result& Statement::executeAsync(bool reset)
 {
 	Poco::Mutex::ScopedLock lock(_mutex);
 	if (initialized() || paused() || done())
+	{
+		bindArguments();
 		return doAsyncExec(reset);
+	}
 	else
 		throw Poco::InvalidAccessException("Statement still executing.");
 }
 
 
+Statement& Statement::addBatch()
+{
+	if (!_pImpl->session().getFeature("bulk"))
+		throw NotSupportedException("bulk", _pImpl->session().connectorName());
+
+	_batch.push_back(StatementImpl::Arguments());
+	_batch.back().swap(_arguments);
+	return *this;
+}
+
+
+void Statement::bindArguments()
+{
+	if (_batch.size())
+	{
+		if (_arguments.size()) addBatch();
+		_pImpl->bind(_batch);
+	}
+	else if (_arguments.size())
+	{
+		_pImpl->bind(_arguments);
+	}
+}
+
+
 const Statement::Result& Statement::doAsyncExec(bool reset)
 {
 	if (done()) _pImpl->reset();
-	if (!_pAsyncExec)
-		_pAsyncExec = new AsyncExecMethod(_pImpl, &StatementImpl::execute);
-	_pResult = new Result((*_pAsyncExec)(reset));
+
+	StatementExecutor::Ptr pExecutor = _pImpl->session().getExecutor();
+	StatementImpl::Ptr pImpl = _pImpl;
+	ExecutionJob* pJob = new ExecutionJob([pImpl, reset]()
+		{
+			return pImpl->execute(reset);
+		}, pExecutor);
+	_pExecution = new CancellationToken(createToken());
+	pJob->setCancellation(_pExecution);
+	_pCompletion = pJob->completion();
+	_pResult = new Result(pJob->result());
+	pExecutor->enqueue(pJob);
 	return *_pResult;
 }
 
 
+Statement& Statement::then(const Continuation& continuation)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	if (!_pCompletion)
+		throw Poco::InvalidAccessException("Statement not executed asynchronously.");
+	_pCompletion->add(continuation);
+	return *this;
+}
+
+
+Statement& Statement::setDeadline(const Poco::Timestamp& deadline)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	_deadline = deadline;
+	_hasDeadline = true;
+	return *this;
+}
+
+
+Statement& Statement::setCancellation(CancellationToken::Ptr pToken)
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	_pCancellation = pToken;
+	return *this;
+}
+
+
+void Statement::cancel()
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	if (_pExecution) _pExecution->cancel("Statement cancelled");
+}
+
+
+CancellationToken::Ptr Statement::createToken() const
+{
+	if (!_hasDeadline && !_pCancellation) return 0;
+
+	CancellationToken::Ptr pToken = new CancellationToken(_pCancellation);
+	if (_hasDeadline) pToken->setDeadline(_deadline);
+	return pToken;
+}
+
+
 void Statement::setAsync(bool async)
 {
 	_async = async;
-	if (_async && !_pAsyncExec)
-		_pAsyncExec = new AsyncExecMethod(_pImpl, &StatementImpl::execute);
 }
 
 
@@ -148,7 +354,7 @@ std::size_t Statement::wait(long milliseconds)
 		_pResult->wait();
 
 	if (_pResult->exception())
-		throw *_pResult->exception();
+		_pResult->exception()->rethrow();
 	else if (!success)
 		throw Poco::TimeoutException("Statement timed out.");
 
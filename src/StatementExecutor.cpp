@@ -0,0 +1,250 @@
+//
+// StatementExecutor.cpp
+//
+// Library: Data
+// Package: Execution
+// Module:  StatementExecutor
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/StatementExecutor.h"
+#include "Poco/Environment.h"
+#include "Poco/NumberFormatter.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	Poco::FastMutex            defaultMutex;
+	StatementExecutor::Ptr     pDefaultExecutor;
+}
+
+
+//
+// StatementExecutor::Worker
+//
+
+
+StatementExecutor::Worker::Worker(StatementExecutor& owner, std::size_t index):
+	_owner(owner),
+	_index(index),
+	_thread(owner.name() + "#" + Poco::NumberFormatter::format(index))
+{
+}
+
+
+StatementExecutor::Worker::~Worker()
+{
+}
+
+
+void StatementExecutor::Worker::push(DeviceJob* pJob)
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	_jobs.push_back(pJob);
+}
+
+
+DeviceJob* StatementExecutor::Worker::pop()
+{
+	// the newest job first, it is most likely
+	// a continuation of the job just finished
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	if (_jobs.empty()) return 0;
+	DeviceJob* pJob = _jobs.back();
+	_jobs.pop_back();
+	return pJob;
+}
+
+
+DeviceJob* StatementExecutor::Worker::steal()
+{
+	Poco::FastMutex::ScopedLock lock(_mutex);
+	if (_jobs.empty()) return 0;
+	DeviceJob* pJob = _jobs.front();
+	_jobs.pop_front();
+	return pJob;
+}
+
+
+void StatementExecutor::Worker::start()
+{
+	_thread.start(*this);
+}
+
+
+void StatementExecutor::Worker::join()
+{
+	_thread.join();
+}
+
+
+bool StatementExecutor::Worker::isCurrent() const
+{
+	return Poco::Thread::current() == &_thread;
+}
+
+
+void StatementExecutor::Worker::run()
+{
+	while (DeviceJob* pJob = _owner.next(_index))
+	{
+		pJob->execute();
+		delete pJob;
+	}
+}
+
+
+//
+// StatementExecutor
+//
+
+
+StatementExecutor::StatementExecutor(int threads, const std::string& name):
+	_name(name),
+	_next(0),
+	_pending(0),
+	_idle(0),
+	_stopped(false)
+{
+	if (threads <= 0) threads = static_cast<int>(Poco::Environment::processorCount());
+	if (threads <= 0) threads = 1;
+
+	for (int i = 0; i < threads; ++i)
+		_workers.push_back(new Worker(*this, i));
+	for (WorkerVec::iterator it = _workers.begin(); it != _workers.end(); ++it)
+		(*it)->start();
+}
+
+
+StatementExecutor::~StatementExecutor()
+{
+	try
+	{
+		poco_assert (!isExecutorThread());
+		stop();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
+	for (WorkerVec::iterator it = _workers.begin(); it != _workers.end(); ++it)
+		delete *it;
+}
+
+
+void StatementExecutor::enqueue(DeviceJob* pJob)
+{
+	poco_check_ptr (pJob);
+
+	// announce the job before checking the stopped flag, so that
+	// stop() either waits for it or the job is cancelled here
+	++_pending;
+	if (_stopped.load())
+	{
+		--_pending;
+		pJob->cancel("Statement executor stopped: " + _name);
+		delete pJob;
+		return;
+	}
+
+	Worker* pWorker = currentWorker();
+	if (!pWorker) pWorker = _workers[_next++ % _workers.size()];
+	pWorker->push(pJob);
+
+	if (_idle.load() > 0)
+	{
+		Poco::FastMutex::ScopedLock lock(_mutex);
+		_ready.signal();
+	}
+}
+
+
+void StatementExecutor::stop()
+{
+	if (_stopped.exchange(true)) return;
+	{
+		Poco::FastMutex::ScopedLock lock(_mutex);
+		_ready.broadcast();
+	}
+	if (isExecutorThread()) return;
+
+	for (WorkerVec::iterator it = _workers.begin(); it != _workers.end(); ++it)
+		(*it)->join();
+
+	// producers that passed the stopped check before stop()
+	// may still be queueing their jobs
+	while (_pending.load() > 0)
+	{
+		DeviceJob* pJob = 0;
+		for (WorkerVec::iterator it = _workers.begin(); it != _workers.end() && !pJob; ++it)
+			pJob = (*it)->steal();
+		if (pJob)
+		{
+			--_pending;
+			pJob->cancel("Statement executor stopped: " + _name);
+			delete pJob;
+		}
+		else Poco::Thread::yield();
+	}
+}
+
+
+StatementExecutor::Ptr StatementExecutor::defaultExecutor()
+{
+	Poco::FastMutex::ScopedLock lock(defaultMutex);
+	if (!pDefaultExecutor) pDefaultExecutor = new StatementExecutor;
+	return pDefaultExecutor;
+}
+
+
+DeviceJob* StatementExecutor::next(std::size_t self)
+{
+	std::size_t count = _workers.size();
+	while (!_stopped.load())
+	{
+		DeviceJob* pJob = _workers[self]->pop();
+		for (std::size_t i = 1; i < count && !pJob; ++i)
+			pJob = _workers[(self + i) % count]->steal();
+		if (pJob)
+		{
+			--_pending;
+			return pJob;
+		}
+
+		// a producer has announced a job that is not queued yet
+		if (_pending.load() > 0)
+		{
+			Poco::Thread::yield();
+			continue;
+		}
+
+		Poco::FastMutex::ScopedLock lock(_mutex);
+		++_idle;
+		while (_pending.load() == 0 && !_stopped.load())
+			_ready.wait(_mutex);
+		--_idle;
+	}
+	return 0;
+}
+
+
+StatementExecutor::Worker* StatementExecutor::currentWorker() const
+{
+	for (WorkerVec::const_iterator it = _workers.begin(); it != _workers.end(); ++it)
+	{
+		if ((*it)->isCurrent()) return *it;
+	}
+	return 0;
+}
+
+
+} } // namespace Reach::Data
@@ -29,7 +29,8 @@ namespace Data {
 StatementImpl::StatementImpl(SessionImpl& rSession):
 	_state(ST_INITIALIZED),
 	_rSession(rSession),
-	_ostr()
+	_ostr(),
+	_dirty(true)
 {
 	if (!_rSession.isConnected())
 		throw NotConnectedException(_rSession.connectionString());
@@ -43,12 +44,39 @@ StatementImpl::~StatementImpl()
 
 std::size_t StatementImpl::execute(const bool& reset)
 {
-	return 0;
+	if (reset)
+	{
+		_results.clear();
+		_batchResults.clear();
+	}
+
+	std::size_t count = 0;
+	try
+	{
+		prepareFunc();
+		if (!_binder.empty() || !_extractor.empty())
+			count = executeBound();
+		else if (_batch.empty())
+			count = _pTemplate->bind(_arguments, _plan).execute(_rSession, _results);
+		else
+			count = executeBatch();
+	}
+	catch (...)
+	{
+		_state = ST_DONE;
+		throw;
+	}
+	_state = ST_DONE;
+	return count;
 }
 
 void StatementImpl::prepareFunc()
 {
+	if (!_dirty && _pTemplate) return;
 
+	_pTemplate = _rSession.statementTemplate(_ostr.str());
+	_dirty = false;
+	_state = ST_COMPILED;
 }
 
 void StatementImpl::reset()
@@ -56,12 +84,70 @@ void StatementImpl::reset()
 	_state = ST_RESET;
 }
 
-void StatementImpl::formatSQL(std::vector<Poco::Any>& arguments)
+std::size_t StatementImpl::executeBatch()
 {
-	std::string sql;
-	Poco::format(sql, _ostr.str(), arguments);
-	_ostr.str("");
-	_ostr << sql;
+	// one exclusive use of the device for the whole batch,
+	// unless the caller already has a transaction in progress
+	bool exclusive = _rSession.canTransact() && !_rSession.isTransactionOwner();
+	if (exclusive) _rSession.begin();
+
+	std::size_t count = 0;
+	try
+	{
+		OperationPlan::Batch batch;
+		for (Batch::const_iterator it = _batch.begin(); it != _batch.end(); ++it)
+		{
+			_batchResults.push_back(Results());
+			count += _pTemplate->bind(*it, _plan).execute(_rSession, _batchResults.back(), batch);
+		}
+	}
+	catch (...)
+	{
+		if (exclusive) _rSession.commit();
+		throw;
+	}
+	if (exclusive) _rSession.commit();
+	return count;
+}
+
+
+std::size_t StatementImpl::executeBound()
+{
+	if (!_batch.empty() || (!_arguments.empty() && !_binder.empty()))
+		throw Poco::InvalidAccessException("Values bound by reference cannot be mixed with values or batches");
+
+	std::size_t first = _results.size();
+	std::size_t count = 0;
+	if (_binder.empty())
+		count = _pTemplate->bind(_arguments, _plan).execute(_rSession, _results);
+	else
+		count = _pTemplate->bind(_binder, _plan).execute(_rSession, _results);
+
+	if (!_extractor.empty())
+	{
+		// only the rows of this execution, if results are appended
+		if (first == 0)
+			_extractor.extract(_results);
+		else
+			_extractor.extract(Results(_results.begin() + first, _results.end()));
+	}
+	return count;
+}
+
+
+void StatementImpl::bind(Arguments& arguments)
+{
+	_arguments.swap(arguments);
+	arguments.clear();
+	_batch.clear();
+}
+
+
+void StatementImpl::bind(Batch& batch)
+{
+	_batch.swap(batch);
+	batch.clear();
+	_arguments.clear();
 }
 
 
@@ -0,0 +1,377 @@
+//
+// StatementTemplate.cpp
+//
+// Library: Data
+// Package: DataCore
+// Module:  StatementTemplate
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/StatementTemplate.h"
+#include "Poco/Format.h"
+#include "Poco/NumberFormatter.h"
+#include "Poco/Ascii.h"
+#include <cstring>
+#include <typeinfo>
+
+
+namespace Reach {
+namespace Data {
+
+
+namespace
+{
+	bool isOneOf(char c, const char* chars)
+	{
+		return c != 0 && std::strchr(chars, c) != 0;
+	}
+}
+
+
+//
+// StatementTemplate
+//
+
+
+StatementTemplate::Segment::Segment():
+	index(-1),
+	type(0),
+	quoted(false)
+{
+}
+
+
+StatementTemplate::Command::Command():
+	command(OperationPlan::CMD_LOGIN)
+{
+}
+
+
+StatementTemplate::StatementTemplate(const std::string& text):
+	_text(text),
+	_slots(0),
+	_nextIndex(0),
+	_direct(true)
+{
+	parse();
+
+	// without placeholders, the plan never changes
+	if (_slots == 0) _plan = OperationPlan(_text);
+}
+
+
+StatementTemplate::~StatementTemplate()
+{
+}
+
+
+void StatementTemplate::parse()
+{
+	Tokens tokens;
+	Token token;
+	bool inToken = false;
+
+	std::string::const_iterator it = _text.begin();
+	std::string::const_iterator end = _text.end();
+	while (it != end)
+	{
+		char c = *it++;
+		if (c == '\'')
+		{
+			// an empty quoted argument still is an argument
+			token.push_back(Segment());
+			token.back().quoted = true;
+			for (;;)
+			{
+				if (it == end)
+				{
+					_direct = false;
+					return;
+				}
+				c = *it++;
+				if (c == '\'')
+				{
+					if (it == end || *it != '\'') break;
+					++it;
+				}
+				else if (c == '%' && (it == end || *it != '%'))
+				{
+					Segment slot;
+					slot.quoted = true;
+					if (!parseSpec(it, end, slot)) return;
+					token.push_back(slot);
+					continue;
+				}
+				else if (c == '%')
+				{
+					++it;
+				}
+				if (token.back().index >= 0 || !token.back().quoted)
+				{
+					token.push_back(Segment());
+					token.back().quoted = true;
+				}
+				token.back().literal += c;
+			}
+			inToken = true;
+			continue;
+		}
+		else if (Poco::Ascii::isSpace(c) || c == ';')
+		{
+			if (inToken)
+			{
+				endToken(token, tokens);
+				inToken = false;
+			}
+			if (c == ';' || c == '\n' || c == '\r') endCommand(tokens);
+			continue;
+		}
+		else if (c == '%' && (it == end || *it != '%'))
+		{
+			Segment slot;
+			if (!parseSpec(it, end, slot)) return;
+			token.push_back(slot);
+			inToken = true;
+			continue;
+		}
+		else if (c == '%')
+		{
+			++it;
+		}
+
+		if (token.empty() || token.back().index >= 0 || token.back().quoted)
+			token.push_back(Segment());
+		token.back().literal += c;
+		inToken = true;
+	}
+	if (inToken) endToken(token, tokens);
+	endCommand(tokens);
+}
+
+
+bool StatementTemplate::parseSpec(std::string::const_iterator& it, std::string::const_iterator end, Segment& slot)
+{
+	// %[<index>][<flags>][<width>][.<precision>][<modifier>]<type>
+	++_slots;
+	int index = _nextIndex;
+	if (it != end && *it == '[')
+	{
+		++it;
+		index = 0;
+		while (it != end && Poco::Ascii::isDigit(*it)) index = 10*index + (*it++ - '0');
+		if (it == end || *it != ']')
+		{
+			_direct = false;
+			return false;
+		}
+		++it;
+	}
+
+	std::string spec("%");
+	while (it != end && isOneOf(*it, "-+0# ")) spec += *it++;
+	while (it != end && Poco::Ascii::isDigit(*it)) spec += *it++;
+	if (it != end && *it == '.')
+	{
+		spec += *it++;
+		while (it != end && Poco::Ascii::isDigit(*it)) spec += *it++;
+	}
+	if (it != end && isOneOf(*it, "lLh?")) spec += *it++;
+	if (it == end || !isOneOf(*it, "bcdiouxXeEfgGsv"))
+	{
+		// leave anything unusual to Poco::format()
+		_direct = false;
+		return false;
+	}
+	slot.type = *it++;
+	spec += slot.type;
+	slot.spec = spec;
+	slot.index = index;
+	_nextIndex = index + 1;
+	return true;
+}
+
+
+void StatementTemplate::endToken(Token& token, Tokens& tokens)
+{
+	tokens.push_back(token);
+	token.clear();
+}
+
+
+void StatementTemplate::endCommand(Tokens& tokens)
+{
+	if (tokens.empty()) return;
+
+	// the keyword selects the operation, it must be literal
+	Command command;
+	std::string keyword;
+	for (Token::const_iterator it = tokens[0].begin(); it != tokens[0].end(); ++it)
+	{
+		if (it->index >= 0) _direct = false;
+		keyword += it->literal;
+	}
+	if (!OperationPlan::lookup(keyword, tokens.size() - 1, command.command)) _direct = false;
+
+	command.args.assign(tokens.begin() + 1, tokens.end());
+	_commands.push_back(command);
+	tokens.clear();
+}
+
+
+const OperationPlan& StatementTemplate::bind(const Arguments& arguments, OperationPlan& plan) const
+{
+	return bindPlan(arguments, plan);
+}
+
+
+const OperationPlan& StatementTemplate::bind(const Binder& binder, OperationPlan& plan) const
+{
+	return bindPlan(binder, plan);
+}
+
+
+template <class Source>
+const OperationPlan& StatementTemplate::bindPlan(const Source& source, OperationPlan& plan) const
+{
+	if (_slots == 0) return _plan;
+
+	if (_direct)
+	{
+		// the operations are overwritten in place, so that their
+		// arguments keep their capacity from the previous execution
+		OperationPlan::Operations& operations = plan._operations;
+		operations.resize(_commands.size());
+		std::size_t i = 0;
+		for (; i < _commands.size(); ++i)
+		{
+			const Command& command = _commands[i];
+			OperationPlan::Operation& op = operations[i];
+			op.command = command.command;
+			op.args.resize(command.args.size());
+			std::size_t j = 0;
+			while (j < command.args.size() && bindToken(command.args[j], source, op.args[j])) ++j;
+			if (j < command.args.size()) break;
+			OperationPlan::check(op);
+		}
+		if (i == _commands.size()) return plan;
+	}
+
+	// a value changes the structure of the command,
+	// so the text has to be formatted and parsed
+	std::string text;
+	format(source, text);
+	plan = OperationPlan(text);
+	return plan;
+}
+
+
+template <class Source>
+bool StatementTemplate::bindToken(const Token& token, const Source& source, std::string& value) const
+{
+	value.clear();
+	bool quoted = false;
+	for (Token::const_iterator it = token.begin(); it != token.end(); ++it)
+	{
+		quoted = quoted || it->quoted;
+		if (it->index < 0)
+		{
+			value += it->literal;
+			continue;
+		}
+
+		if (static_cast<std::size_t>(it->index) >= source.size()) return false;
+		std::size_t start = value.size();
+		appendSlot(*it, source, value);
+		if (it->quoted)
+		{
+			if (value.find('\'', start) != std::string::npos) return false;
+		}
+		else if (value.find_first_of(" \t\n\r\v\f;'", start) != std::string::npos)
+		{
+			return false;
+		}
+	}
+
+	// an empty unquoted value would not be an argument at all
+	return quoted || !value.empty();
+}
+
+
+void StatementTemplate::format(const Arguments& arguments, std::string& text) const
+{
+	Poco::format(text, _text, arguments);
+}
+
+
+void StatementTemplate::format(const Binder& binder, std::string& text) const
+{
+	Arguments arguments;
+	arguments.reserve(binder.size());
+	for (std::size_t i = 0; i < binder.size(); ++i)
+		arguments.push_back(binder.any(i));
+	Poco::format(text, _text, arguments);
+}
+
+
+void StatementTemplate::appendSlot(const Segment& slot, const Arguments& arguments, std::string& value)
+{
+	const Poco::Any& argument = arguments[slot.index];
+	if (slot.spec.size() == 2)
+	{
+		if (slot.type == 's' && argument.type() == typeid(std::string))
+		{
+			value += Poco::RefAnyCast<std::string>(argument);
+			return;
+		}
+		if (slot.type == 'd' && argument.type() == typeid(int))
+		{
+			Poco::NumberFormatter::append(value, Poco::AnyCast<int>(argument));
+			return;
+		}
+	}
+	value += Poco::format(slot.spec, argument);
+}
+
+
+void StatementTemplate::appendSlot(const Segment& slot, const Binder& binder, std::string& value)
+{
+	if (slot.spec.size() == 2 && binder.append(slot.index, slot.type, value)) return;
+
+	value += Poco::format(slot.spec, binder.any(slot.index));
+}
+
+
+//
+// StatementTemplateCache
+//
+
+
+StatementTemplateCache::StatementTemplateCache(long size):
+	Poco::LRUCache<std::string, StatementTemplate>(size)
+{
+}
+
+
+StatementTemplateCache::~StatementTemplateCache()
+{
+}
+
+
+StatementTemplate::Ptr StatementTemplateCache::find(const std::string& text)
+{
+	StatementTemplate::Ptr pTemplate = get(text);
+	if (!pTemplate)
+	{
+		pTemplate = new StatementTemplate(text);
+		add(text, pTemplate);
+	}
+	return pTemplate;
+}
+
+
+} } // namespace Reach::Data
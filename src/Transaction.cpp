@@ -0,0 +1,88 @@
+//
+// Transaction.cpp
+//
+// Library: Data
+// Package: DataCore
+// Module:  Transaction
+//
+// Copyright (c) 2006, Applied Informatics Software Engineering GmbH.
+// and Contributors.
+//
+// SPDX-License-Identifier:	BSL-1.0
+//
+
+
+#include "Reach/Data/Transaction.h"
+#include "Reach/Data/DataException.h"
+
+
+namespace Reach {
+namespace Data {
+
+
+Transaction::Transaction(Session& session):
+	_session(session),
+	_active(false)
+{
+	_session.begin();
+	_active = true;
+}
+
+
+Transaction::Transaction(Session& session, const std::string& passwd):
+	_session(session),
+	_active(false)
+{
+	_session.begin();
+	_active = true;
+
+	bool loggedIn = false;
+	try
+	{
+		loggedIn = _session.ensureLoggedIn(passwd);
+	}
+	catch (...)
+	{
+		rollback();
+		throw;
+	}
+	if (!loggedIn)
+	{
+		rollback();
+		throw LoginFailedException(_session.uri());
+	}
+}
+
+
+Transaction::~Transaction()
+{
+	try
+	{
+		if (_active) rollback();
+	}
+	catch (...)
+	{
+		poco_unexpected();
+	}
+}
+
+
+void Transaction::commit()
+{
+	if (!_active) throw Poco::InvalidAccessException("Transaction not in progress");
+
+	_active = false;
+	_session.commit();
+}
+
+
+void Transaction::rollback()
+{
+	if (!_active) throw Poco::InvalidAccessException("Transaction not in progress");
+
+	_active = false;
+	_session.rollback();
+}
+
+
+} } // namespace Reach::Data
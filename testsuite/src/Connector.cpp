@@ -38,6 +38,31 @@ Poco::AutoPtr<Reach::Data::SessionImpl> Connector::createSession(const std::stri
 }
 
 
+std::vector<std::string> Connector::devices()
+{
+	std::vector<std::string> names;
+	names.push_back("key1");
+	names.push_back("key2");
+	return names;
+}
+
+
+Poco::AutoPtr<Reach::Data::SessionImpl> Connector::createDeviceSession(const std::string& connectionString,
+	std::size_t timeout,
+	const std::string& device)
+{
+	Poco::AutoPtr<Reach::Data::SessionImpl> pImpl(new SessionImpl(connectionString, timeout));
+	if (connectionString == "distinct") pImpl->setProperty("certificate", device);
+	return pImpl;
+}
+
+
+bool Connector::supportsBalancing() const
+{
+	return true;
+}
+
+
 void Connector::addToFactory()
 {
 	Reach::Data::SessionFactory::instance().add(new Connector());
@@ -42,6 +42,17 @@ public:
 		std::size_t timeout = SessionImpl::LOGIN_TIMEOUT_DEFAULT);
 		/// Creates a test SessionImpl object and initializes it with the given connectionString.
 
+	std::vector<std::string> devices();
+		/// Returns two dummy device names.
+
+	Poco::AutoPtr<Reach::Data::SessionImpl> createDeviceSession(const std::string& connectionString,
+		std::size_t timeout,
+		const std::string& device);
+		/// Creates a test SessionImpl object for the given device.
+
+	bool supportsBalancing() const;
+		/// Returns true.
+
 	static void addToFactory();
 		/// Registers the Connector under the Keyword Connector::KEY at the Poco::Data::SessionFactory.
 
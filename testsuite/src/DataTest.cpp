@@ -14,17 +14,41 @@
 #include "Reach/Data/Session.h"
 #include "Reach/Data/SessionFactory.h"
 #include "Reach/Data/DataException.h"
+#include "Reach/Data/QueuedSessionImpl.h"
+#include "Reach/Data/DeviceWorker.h"
+#include "Reach/Data/BalancedSessionImpl.h"
+#include "Reach/Data/DeviceMonitor.h"
+#include "Reach/Data/SessionContainer.h"
+#include "Reach/Data/Transaction.h"
+#include "Reach/Data/Statement.h"
+#include "Reach/Data/OperationPlan.h"
+#include "Reach/Data/StatementExecutor.h"
+#include "Reach/Data/CancellationToken.h"
+#include "Reach/Data/Awaitable.h"
+#include "Reach/Data/CompletionQueue.h"
+#include "Reach/Data/SignatureVerifier.h"
+#include "Reach/Data/MessageDigest.h"
+#include "Reach/Data/FileCipher.h"
 #include "Connector.h"
 #include "Poco/BinaryReader.h"
 #include "Poco/BinaryWriter.h"
 #include "Poco/DateTime.h"
 #include "Poco/Types.h"
+#include "Poco/NumberFormatter.h"
 #include "Poco/Dynamic/Var.h"
 #include "Poco/Exception.h"
+#include "Poco/Thread.h"
+#include "Poco/Event.h"
+#include "Poco/Mutex.h"
+#include "Poco/TemporaryFile.h"
+#include "Poco/FileStream.h"
 #include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <set>
+#include <vector>
+#include <atomic>
+#include <iterator>
 
 
 using Poco::BinaryReader;
@@ -44,6 +68,80 @@ using Reach::Data::Session;
 using Reach::Data::SessionFactory;
 using Reach::Data::NotSupportedException;
 using Reach::Data::NotConnectedException;
+using Reach::Data::QueuedSessionImpl;
+using Reach::Data::DeviceWorker;
+using Reach::Data::DeviceJob;
+using Reach::Data::DeviceHold;
+using Reach::Data::BalancedSessionImpl;
+using Reach::Data::DeviceMonitor;
+using Reach::Data::SessionContainer;
+using Reach::Data::SessionUnavailableException;
+using Reach::Data::SessionImpl;
+using Reach::Data::Transaction;
+using Reach::Data::Statement;
+using Reach::Data::OperationPlan;
+using Reach::Data::StatementTemplate;
+using Reach::Data::StatementExecutor;
+using Reach::Data::Keywords::now;
+using Reach::Data::Keywords::async;
+using Reach::Data::Keywords::batch;
+using Reach::Data::Keywords::use;
+using Reach::Data::Keywords::into;
+using Reach::Data::LoginFailedException;
+using Reach::Data::OperationCancelledException;
+using Reach::Data::DeadlineExceededException;
+using Reach::Data::CancellationToken;
+using Reach::Data::CompletionQueue;
+using Reach::Data::SignatureVerifier;
+using Reach::Data::MessageDigest;
+using Reach::Data::FileCipher;
+
+
+#if defined(RDATA_HAVE_COROUTINES)
+
+
+using Reach::Data::Task;
+using Reach::Data::AwaitableSession;
+
+
+namespace
+{
+	Task<std::string> signTwice(AwaitableSession session, std::string text)
+	{
+		std::string first = co_await session.signByP1(text);
+		co_return co_await session.signByP7(first, 1);
+	}
+}
+
+
+#endif // RDATA_HAVE_COROUTINES
+
+
+namespace
+{
+	// self-signed test certificates and signatures of "message"
+	const std::string sm2Cert =
+		"MIIBcjCCARegAwIBAgIUIUtF9BRhxhjF7cJ7pJRtGa6Nk6wwCgYIKoEcz1UBg3UwDjEMMAoGA1UEAwwDc20yMB4XDTI2MTAxODAx"
+		"MzcyOFoXDTM2MTAxNTAxMzcyOFowDjEMMAoGA1UEAwwDc20yMFkwEwYHKoZIzj0CAQYIKoEcz1UBgi0DQgAEDyhVEfrvCoyacAtL"
+		"WdbN0EVdPASfWCgzJo74u03Kt6vozvcZRUYLrD6XoXWtQqx5Ip688u5eJoHStvYBSBlPpKNTMFEwHQYDVR0OBBYEFLuFRWcFZ4GT"
+		"SEg6IMYR2/NFaOHLMB8GA1UdIwQYMBaAFLuFRWcFZ4GTSEg6IMYR2/NFaOHLMA8GA1UdEwEB/wQFMAMBAf8wCgYIKoEcz1UBg3UD"
+		"SQAwRgIhAJzkOMM1c1xjPG3LOhAJKqFXpbRlUajZeQCVB3lxPi68AiEAw060XgXc2jXqb4ajtBiHX6WRmwQ+evLFB/NhjXug54k=";
+	const std::string sm2Signature =
+		"MEQCIGUgBXV5iMLLHAzhOU9XZaG0xuXPPWkMSaRB3GA090+iAiAZ724nSvPwIh+GyNXUMKmKmQeJVBMd5rFMmsGUCQXY5Q==";
+	const std::string sm2RawSignature =
+		"ZSAFdXmIwsscDOE5T1dlobTG5c89aQxJpEHcYDT3T6IZ724nSvPwIh+GyNXUMKmKmQeJVBMd5rFMmsGUCQXY5Q==";
+	const std::string rsaCert =
+		"MIIB+DCCAWGgAwIBAgIUIPew382eTujSis2TOIUlkhdE8RwwDQYJKoZIhvcNAQELBQAwDjEMMAoGA1UEAwwDcnNhMB4XDTI2MTAx"
+		"ODAxMzcyOFoXDTM2MTAxNTAxMzcyOFowDjEMMAoGA1UEAwwDcnNhMIGfMA0GCSqGSIb3DQEBAQUAA4GNADCBiQKBgQDBnJbWrWs8"
+		"yHENxuHzwlA8Bp0TqKsml1FK4/3o97NnGvWfrxp6MYVee2Z0Jes/tdTZgWKxRg1wSf4rPTyrPW8OYBzO6J4G8jl7EbZlmUV8V+Ns"
+		"LmQnWvJB8EnRo+kfP/Kf9cCP4ZdR8gqlqxorgYSzUgzCQHIDrlukI3K8ez7FFwIDAQABo1MwUTAdBgNVHQ4EFgQUxQoRxwJGfOYb"
+		"oNvaLOGOTQXwvuUwHwYDVR0jBBgwFoAUxQoRxwJGfOYboNvaLOGOTQXwvuUwDwYDVR0TAQH/BAUwAwEB/zANBgkqhkiG9w0BAQsF"
+		"AAOBgQBVGv2PXVVafMdjIbzj9DqkB9A00kOvouY8UBrxFLlFrodyp3x6ZaXEvv0AAVr0qy/TvgIoI+FFC0IHmR2chpUnjzspxSYv"
+		"luw9GA8+zMzxilBvwpzgf/Lex6x+dsMbHhrh+6LhaZCi1PCXXX+kvog5QRGKQRZDH7pSsBIeAgxGkg==";
+	const std::string rsaSignature =
+		"egEp50DfBrhxRFomE+6yvvZrLMgrQT7JR48Zr1P3nnNXP3l61ZN8DdVan+c6AFzdZ1UoKDmfS5tDGKkK0e09bBmsR0cWe07xWZCR"
+		"9aeyAtDX5NiznkSSSfJifkmgokB3jMril4IwofckVYrB9oMLx3FCaNDyLqXNrwwJNz47yDU=";
+}
 
 
 DataTest::DataTest(const std::string& name): CppUnit::TestCase(name)
@@ -107,6 +205,1301 @@ void DataTest::testProperties()
 }
 
 
+void DataTest::testDeviceWorker()
+{
+	DeviceWorker::Ptr pWorker = new DeviceWorker("worker");
+	assert (!pWorker->isWorkerThread());
+
+	std::vector<Poco::ActiveResult<int> > results;
+	for (int i = 0; i < 100; ++i)
+		results.push_back(pWorker->submit<int>([i]() { return i; }));
+	for (int i = 0; i < 100; ++i)
+		assert (DeviceWorker::await(results[i]) == i);
+
+	assert (DeviceWorker::await(pWorker->submit<bool>([&]() { return pWorker->isWorkerThread(); })));
+
+	Poco::ActiveResult<void> failed = pWorker->submit<void>([]() { throw NotFoundException("job"); });
+	try
+	{
+		DeviceWorker::await(failed);
+		fail ("must fail");
+	}
+	catch (NotFoundException&) { }
+
+	pWorker->stop();
+	Poco::ActiveResult<int> cancelled = pWorker->submit<int>([]() { return 0; });
+	try
+	{
+		DeviceWorker::await(cancelled);
+		fail ("must fail");
+	}
+	catch (IllegalStateException&) { }
+
+	// a job dropping the last reference ends the worker on its own thread
+	DeviceWorker* pLast = new DeviceWorker("last");
+	Poco::Event go;
+	pLast->submit<int>([&go]() { go.wait(); return 1; },
+		[pLast](const Poco::ActiveResult<int>&) { pLast->release(); });
+	Poco::ActiveResult<int> dropped = pLast->submit<int>([]() { return 2; });
+	go.set();
+	try
+	{
+		DeviceWorker::await(dropped);
+		fail ("must fail");
+	}
+	catch (IllegalStateException&) { }
+}
+
+
+void DataTest::testQueuedSession()
+{
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	assert (SessionFactory::instance().getExecutionMode("test") == SessionFactory::EXEC_QUEUED);
+
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	Session sess2(SessionFactory::instance().create("test", "cs"));
+	DeviceWorker::Ptr pWorker = SessionFactory::instance().queuedWorker("test");
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	assert (!SessionFactory::instance().queuedWorker("test"));
+
+	QueuedSessionImpl* pQueued = dynamic_cast<QueuedSessionImpl*>(sess.impl());
+	QueuedSessionImpl* pQueued2 = dynamic_cast<QueuedSessionImpl*>(sess2.impl());
+	assert (pQueued && pQueued2);
+	assert (&pQueued->worker() == &pQueued2->worker());
+	assert (&pQueued->worker() == pWorker.get());
+	assert ("test:///cs" == sess.uri());
+
+	assert (sess.isConnected());
+	assert (sess.getPinRetryCount() == 1);
+	assert (!sess.login("1234"));
+
+	QueuedSessionImpl::IntResult retries = pQueued->getPinRetryCountAsync();
+	QueuedSessionImpl::BoolResult login = pQueued2->loginAsync("1234");
+	assert (DeviceWorker::await(retries) == 1);
+	assert (!DeviceWorker::await(login));
+
+	sess.close();
+	assert (!sess.isConnected());
+	sess.open();
+	assert (sess.isConnected());
+
+	Session direct(SessionFactory::instance().create("test", "cs"));
+	assert (!dynamic_cast<QueuedSessionImpl*>(direct.impl()));
+}
+
+
+void DataTest::testBalancedSession()
+{
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_BALANCED);
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+
+	BalancedSessionImpl* pBalanced = dynamic_cast<BalancedSessionImpl*>(sess.impl());
+	assert (pBalanced);
+	assert (pBalanced->members() == 2);
+	assert ("test:///cs" == sess.uri());
+
+	QueuedSessionImpl* pKey1 = dynamic_cast<QueuedSessionImpl*>(pBalanced->member(0));
+	QueuedSessionImpl* pKey2 = dynamic_cast<QueuedSessionImpl*>(pBalanced->member(1));
+	assert (pKey1 && pKey2);
+	assert (&pKey1->worker() != &pKey2->worker());
+
+	// a queued session on the default device shares the worker of its balanced member
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session queued(SessionFactory::instance().create("test", "other"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	QueuedSessionImpl* pQueued = dynamic_cast<QueuedSessionImpl*>(queued.impl());
+	assert (pQueued);
+	assert (&pQueued->worker() == &pKey1->worker());
+
+	assert (sess.isConnected());
+	assert (!sess.login("1234"));
+	assert (sess.getPinRetryCount() == 1);
+	for (int i = 0; i < 10; ++i) sess.signByP1("message");
+	assert (pBalanced->outstanding(0) == 0);
+	assert (pBalanced->outstanding(1) == 0);
+
+	// only the first member has the key of the certificate handed out
+	DeviceHold::Ptr pHold = pKey1->worker().hold();
+	std::vector<BalancedSessionImpl::StringResult> decrypted;
+	for (int i = 0; i < 4; ++i) decrypted.push_back(pBalanced->decryptDataAsync("headdata"));
+	assert (pBalanced->outstanding(0) == 4);
+	assert (pBalanced->outstanding(1) == 0);
+	pHold->end();
+	for (std::size_t i = 0; i < decrypted.size(); ++i)
+		assert (DeviceWorker::await(decrypted[i]) == "data");
+	assert (sess.decryptData("headdata") == "data");
+
+	sess.close();
+	assert (!pKey1->isConnected() && !pKey2->isConnected());
+	assert (!sess.isConnected());
+
+	// keys holding different certificates are not balanced
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_BALANCED);
+	try
+	{
+		Session distinct(SessionFactory::instance().create("test", "distinct"));
+		fail ("must fail");
+	}
+	catch (InvalidArgumentException&) { }
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+}
+
+
+void DataTest::testDeviceMonitor()
+{
+	std::atomic<bool> present(false);
+	DeviceMonitor monitor("test", [&]() { return present.load(); }, 1, 50);
+	present = true;
+	assert (monitor.waitForDevice(1000));
+	assert (!monitor.isPresent());
+	present = false;
+
+	DeviceWorker::Ptr pWorker = new DeviceWorker("test");
+	monitor.start(pWorker);
+	assert (!monitor.isPresent());
+	assert (!monitor.waitForDevice(20));
+
+	SessionContainer container;
+	container.watch(monitor);
+	Session sess = container.add("test", "cs");
+	assert (sess.isConnected());
+
+	present = true;
+	assert (monitor.waitForDevice(1000));
+	assert (container.get("test:///cs").isConnected());
+
+	present = false;
+	int i = 0;
+	for (; i < 100; ++i)
+	{
+		try
+		{
+			container.get("test:///cs");
+			Poco::Thread::sleep(10);
+		}
+		catch (SessionUnavailableException&)
+		{
+			break;
+		}
+	}
+	assert (i < 100);
+	assert (!sess.isConnected());
+
+	present = true;
+	monitor.wakeUp();
+	for (i = 0; i < 100 && !sess.isConnected(); ++i) Poco::Thread::sleep(10);
+	assert (sess.isConnected());
+	assert (container.get("test:///cs").isConnected());
+
+	// the monitor can not probe while a job occupies its worker
+	present = false;
+	Poco::ActiveResult<bool> waited = pWorker->submit<bool>([&]() { return monitor.waitForDevice(1000); });
+	Poco::Thread::sleep(20);
+	present = true;
+	assert (DeviceWorker::await(waited));
+
+	container.unwatch(monitor);
+	monitor.stop();
+	assert (monitor.waitForDevice(0));
+
+	// a device that is present but busy is retried, backing off
+	int attempts = 0;
+	assert (monitor.retry([&]() { return ++attempts == 3; }, 1000));
+	assert (attempts == 3);
+	attempts = 0;
+	assert (!monitor.retry([&]() { ++attempts; return false; }, 100));
+	assert (attempts > 1 && attempts <= 8);
+}
+
+
+void DataTest::testWarmUp()
+{
+	SessionContainer container;
+	std::vector<std::string> uris;
+	uris.push_back("test:///a");
+	uris.push_back("test:///b");
+	uris.push_back("test:///c");
+
+	Poco::ActiveResult<int> ready = container.warmUp(uris);
+	assert (DeviceWorker::await(ready) == 3);
+	assert (container.count() == 3);
+	assert (container.has("test:///a") && container.has("test:///b") && container.has("test:///c"));
+	assert (container.get("test:///b").isConnected());
+
+	uris.push_back("unknown:///d");
+	Poco::ActiveResult<int> failed = container.warmUp(uris);
+	try
+	{
+		DeviceWorker::await(failed);
+		fail ("must fail");
+	}
+	catch (SessionUnavailableException&) { }
+	assert (container.count() == 3);
+}
+
+
+void DataTest::testLiveness()
+{
+	SessionContainer container;
+	Session sess = container.add("test", "cs");
+	assert (sess.isAlive());
+
+	container.checkLiveness();
+	assert (container.has("test:///cs"));
+
+	// transparent reopen
+	sess.close();
+	assert (!sess.isAlive());
+	container.checkLiveness(true);
+	assert (container.has("test:///cs"));
+	assert (sess.isAlive());
+
+	// eviction
+	sess.close();
+	container.checkLiveness();
+	assert (!container.has("test:///cs"));
+	try
+	{
+		container.get("test:///cs");
+		fail ("must fail");
+	}
+	catch (NotFoundException&) { }
+
+	sess = container.add("test", "cs");
+	container.startLivenessCheck(10, true);
+	sess.close();
+	int i = 0;
+	for (; i < 100 && !sess.isAlive(); ++i) Poco::Thread::sleep(10);
+	assert (i < 100);
+	container.stopLivenessCheck();
+}
+
+
+void DataTest::testSessionContainer()
+{
+	SessionContainer container;
+	Session sess = container.add("test", "cs");
+	assert (container.count() == 1);
+	assert (container.has("test:///cs"));
+	assert (container.has("TEST:///CS"));
+	assert (container.isActive("test", "cs"));
+	assert (container.get("Test:///Cs").impl() == sess.impl());
+	assert (container.get("test:/cs").impl() == sess.impl());
+	assert (container.has("TEST://host/cs"));
+
+	Session sess2 = container.add("TeSt", "cS");
+	assert (sess2.impl() == sess.impl());
+	assert (container.count() == 1);
+
+	std::atomic<int> found(0);
+	std::vector<DeviceWorker::Ptr> workers;
+	std::vector<Poco::ActiveResult<void> > results;
+	for (int i = 0; i < 4; ++i)
+	{
+		workers.push_back(new DeviceWorker("lookup"));
+		results.push_back(workers.back()->submit<void>([&]()
+		{
+			for (int j = 0; j < 1000; ++j)
+			{
+				if (container.has("test:///cs")) ++found;
+			}
+		}));
+	}
+	// replaced indexes must stay valid for the lookups still using them
+	for (int i = 0; i < 100; ++i)
+	{
+		container.add("test", "other");
+		container.remove("test:/other");
+	}
+	for (std::size_t i = 0; i < results.size(); ++i) DeviceWorker::await(results[i]);
+	assert (found == 4000);
+
+	container.remove("TEST:///cs");
+	assert (container.count() == 0);
+	assert (!container.has("test:///cs"));
+
+	container.add("test", "a");
+	container.add("test", "b");
+	assert (container.count() == 2);
+	container.clear();
+	assert (container.count() == 0);
+}
+
+
+void DataTest::testLoginState()
+{
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	assert (!sess.isLoggedIn());
+	assert (sess.getAuthLifetime() == SessionImpl::AUTH_LIFETIME_DEFAULT);
+
+	assert (!sess.ensureLoggedIn("1234"));
+	assert (!sess.isLoggedIn());
+	assert (sess.ensureLoggedIn("0000"));
+	assert (sess.isLoggedIn());
+	assert (sess.ensureLoggedIn("0000"));
+	assert (Poco::AnyCast<int>(sess.getProperty("logins")) == 2);
+
+	// a failed login drops the authentication
+	assert (!sess.login("1234"));
+	assert (!sess.isLoggedIn());
+
+	assert (sess.ensureLoggedIn("0000"));
+	sess.invalidateLogin();
+	assert (!sess.isLoggedIn());
+	assert (sess.ensureLoggedIn("0000"));
+	assert (Poco::AnyCast<int>(sess.getProperty("logins")) == 5);
+
+	sess.close();
+	assert (!sess.isLoggedIn());
+	sess.open();
+	assert (!sess.isLoggedIn());
+
+	sess.setAuthLifetime(1);
+	assert (sess.getAuthLifetime() == 1);
+	assert (sess.ensureLoggedIn("0000"));
+	assert (sess.isLoggedIn());
+	Poco::Thread::sleep(1100);
+	assert (!sess.isLoggedIn());
+
+	// queued sessions report the state of the device session
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session queued(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	queued.setAuthLifetime(SessionImpl::AUTH_LIFETIME_INFINITE);
+	assert (queued.ensureLoggedIn("0000"));
+	assert (queued.isLoggedIn());
+	assert (dynamic_cast<QueuedSessionImpl*>(queued.impl())->impl()->isLoggedIn());
+	queued.close();
+	assert (!queued.isLoggedIn());
+	queued.open();
+
+	// removing the device drops the authentication
+	SessionContainer container;
+	Session contained = container.add("test", "cs");
+	assert (contained.ensureLoggedIn("0000"));
+	contained.setFeature("connected", false);
+	container.checkLiveness();
+	assert (!contained.isLoggedIn());
+}
+
+
+void DataTest::testTransaction()
+{
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	assert (sess.canTransact());
+	assert (!sess.isTransaction());
+	{
+		Transaction trans(sess, "0000");
+		assert (trans.isActive());
+		assert (sess.isTransaction());
+		assert (sess.isLoggedIn());
+		try
+		{
+			sess.begin();
+			fail ("must fail");
+		}
+		catch (InvalidAccessException&) { }
+		trans.commit();
+		assert (!trans.isActive());
+	}
+	assert (!sess.isTransaction());
+	assert (sess.isLoggedIn());
+
+	{
+		Transaction trans(sess);
+	}
+	assert (!sess.isTransaction());
+	assert (!sess.isLoggedIn());
+
+	try
+	{
+		Transaction trans(sess, "1234");
+		fail ("must fail");
+	}
+	catch (LoginFailedException&) { }
+	assert (!sess.isTransaction());
+
+	try
+	{
+		sess.commit();
+		fail ("must fail");
+	}
+	catch (InvalidAccessException&) { }
+
+	// in direct mode, the calls of other threads wait for the commit as well
+	{
+		StatementExecutor::Ptr pExecutor = new StatementExecutor(1, "OtherThread");
+		Transaction trans(sess, "0000");
+		int retries = sess.getPinRetryCount();
+		SessionImpl::IntResult otherAsync = DeviceWorker::await(
+			pExecutor->submit<SessionImpl::IntResult>([&]() { return sess.getPinRetryCountAsync(); }));
+		Poco::ActiveResult<int> other = pExecutor->submit<int>([&]() { return sess.getPinRetryCount(); });
+		SessionImpl::IntResult ownAsync = sess.getPinRetryCountAsync();
+		assert (ownAsync.available());
+		assert (DeviceWorker::await(ownAsync) == retries);
+		Poco::Thread::sleep(20);
+		assert (!other.available());
+		assert (!otherAsync.available());
+		trans.commit();
+		assert (DeviceWorker::await(other) == retries);
+		assert (DeviceWorker::await(otherAsync) == retries);
+		pExecutor->stop();
+	}
+
+	// the owner runs inline, everybody else waits for the commit
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session queued(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	QueuedSessionImpl* pQueued = dynamic_cast<QueuedSessionImpl*>(queued.impl());
+	assert (pQueued);
+
+	StatementExecutor::Ptr pExecutor = new StatementExecutor(1, "OtherThread");
+	Transaction trans(queued, "0000");
+	Poco::ActiveResult<int> other = pExecutor->submit<int>([&]() { return queued.getPinRetryCount(); });
+	assert (queued.getPinRetryCount() == 1);
+	assert (queued.getSerialNumber() == pQueued->impl()->getSerialNumber());
+	Poco::Thread::sleep(20);
+	assert (!other.available());
+	assert (pQueued->worker().pending() == 1);
+	trans.commit();
+	assert (DeviceWorker::await(other) == 1);
+	assert (queued.isLoggedIn());
+	pExecutor->stop();
+
+	// asynchronous calls of the owner must not wait for its own hold
+	Transaction own(queued);
+	QueuedSessionImpl::IntResult count = pQueued->getPinRetryCountAsync();
+	assert (count.available());
+	assert (DeviceWorker::await(count) == 1);
+	QueuedSessionImpl::VoidResult opened = pQueued->openAsync();
+	assert (opened.available());
+	DeviceWorker::await(opened);
+	own.commit();
+}
+
+
+void DataTest::testStatementExecution()
+{
+	Session sess(SessionFactory::instance().create("test", "cs"));
+
+	Statement stmt = (sess << "login 0000; sign 'hello world'\nverify cert msg 'p1:msg'; serial");
+	assert (stmt.initialized());
+	assert (stmt.execute() == 4);
+	assert (stmt.done());
+	assert (stmt.results().size() == 4);
+	assert (stmt.results()[0] == "1");
+	assert (stmt.results()[1] == "p1:hello world");
+	assert (stmt.results()[2] == "1");
+	assert (stmt.results()[3] == "serial");
+	assert (sess.isLoggedIn());
+
+	// results are appended unless reset
+	assert (stmt.execute(false) == 4);
+	assert (stmt.results().size() == 8);
+	assert (stmt.execute() == 4);
+	assert (stmt.results().size() == 4);
+
+	Statement enc(sess);
+	enc << "encrypt %s cert; signp7 %s 1", OperationPlan::quote("it's"), "text", now;
+	assert (enc.results().size() == 2);
+	assert (enc.results()[0] == "enc:it's");
+	assert (enc.results()[1] == "p7:text");
+
+	Statement asyncStmt = (sess << "sign a; sign b; retries", async);
+	asyncStmt.execute();
+	assert (asyncStmt.wait() == 3);
+	assert (asyncStmt.results()[2] == "1");
+
+	Statement bad = (sess << "sign");
+	try
+	{
+		bad.execute();
+		fail ("must fail");
+	}
+	catch (Poco::SyntaxException&) { }
+
+	OperationPlan plan("cert 1;;\r\nkeyid");
+	assert (plan.size() == 2);
+	assert (plan.operations()[0].command == OperationPlan::CMD_CERT);
+	assert (OperationPlan::quote("a'b") == "'a''b'");
+	try
+	{
+		OperationPlan unknown("dance");
+		fail ("must fail");
+	}
+	catch (Poco::SyntaxException&) { }
+}
+
+
+void DataTest::testStatementTemplate()
+{
+	Session sess(SessionFactory::instance().create("test", "cs"));
+
+	// the same text shares one template per session
+	StatementTemplate::Ptr pTemplate = sess.impl()->statementTemplate("sign %s; signp7 '%s' %d");
+	assert (pTemplate.get() == sess.impl()->statementTemplate("sign %s; signp7 '%s' %d").get());
+	assert (pTemplate->slots() == 3);
+
+	Statement stmt(sess);
+	stmt << "sign %s; signp7 '%s' %d", "abc", "a b", 1;
+	assert (stmt.execute() == 2);
+	assert (stmt.results()[0] == "p1:abc");
+	assert (stmt.results()[1] == "p7:a b");
+
+	// without new values, the previous ones are used again
+	assert (stmt.execute() == 2);
+	assert (stmt.results()[0] == "p1:abc");
+
+	stmt, "xyz", "it''s", 0;
+	assert (stmt.execute() == 2);
+	assert (stmt.results()[0] == "p1:xyz");
+	assert (stmt.results()[1] == "p7:it's");
+
+	// values changing the structure of the command
+	// give the same result as the formatted text
+	stmt, "x; serial", "y", 0;
+	assert (stmt.execute() == 3);
+	assert (stmt.results()[1] == "serial");
+
+	stmt, OperationPlan::quote("a b"), "it's", 0;
+	try
+	{
+		stmt.execute();
+		fail ("must fail");
+	}
+	catch (Poco::SyntaxException&) { }
+
+	Statement indexed(sess);
+	indexed << "verify cert %[1]s %[0]s", "p1:msg", "msg", now;
+	assert (indexed.results()[0] == "1");
+
+	OperationPlan plan;
+	StatementTemplate literal("serial; keyid");
+	assert (literal.slots() == 0);
+	assert (&literal.bind(StatementTemplate::Arguments(), plan) != &plan);
+	assert (literal.bind(StatementTemplate::Arguments(), plan).size() == 2);
+}
+
+
+void DataTest::testStatementExecutor()
+{
+	StatementExecutor::Ptr pExecutor = new StatementExecutor(2, "TestExecutor");
+	assert (pExecutor->threads() == 2);
+	assert (!pExecutor->isExecutorThread());
+
+	SessionFactory::instance().setExecutor("test", pExecutor);
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutor("test", StatementExecutor::Ptr());
+	assert (sess.impl()->getExecutor().get() == pExecutor.get());
+	Session other(SessionFactory::instance().create("test", "cs"));
+	assert (other.impl()->getExecutor().get() == StatementExecutor::defaultExecutor().get());
+
+	Statement first = (sess << "sign a; serial", async);
+	try
+	{
+		first.then([](const Statement::Result&) { });
+		fail ("must fail");
+	}
+	catch (InvalidAccessException&) { }
+
+	// the second statement is chained to the first one
+	// without any thread blocking in wait()
+	Statement second = (sess << "sign b");
+	Poco::Event done;
+	std::atomic<bool> onExecutor(false);
+	std::atomic<std::size_t> count(0);
+	first.execute();
+	first.then([&](const Statement::Result& result)
+	{
+		onExecutor = pExecutor->isExecutorThread();
+		count = result.data();
+		second.executeAsync();
+		second.then([&](const Statement::Result&)
+		{
+			done.set();
+		});
+	});
+	done.wait();
+	assert (onExecutor);
+	assert (count == 2);
+	assert (second.wait() == 1);
+	assert (second.results()[0] == "p1:b");
+
+	// chained after completion, the continuation runs right away
+	assert (first.wait() == 2);
+	Poco::Event late;
+	first.then([&](const Statement::Result&) { late.set(); });
+	late.wait();
+
+	Statement bad = (sess << "dance");
+	bad.executeAsync();
+	Poco::Event failed;
+	std::atomic<bool> error(false);
+	bad.then([&](const Statement::Result& result)
+	{
+		error = result.exception() != 0;
+		failed.set();
+	});
+	failed.wait();
+	assert (error);
+
+	pExecutor->stop();
+}
+
+
+void DataTest::testBatchExecution()
+{
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	assert (!sess.getFeature("bulk"));
+	Statement refused(sess);
+	refused << "signp7 %s 1", "a";
+	try
+	{
+		refused.addBatch();
+		fail ("must fail");
+	}
+	catch (NotSupportedException&) { }
+
+	sess.setFeature("bulk", true);
+	int logins = Poco::AnyCast<int>(sess.getProperty("logins"));
+
+	Statement stmt(sess);
+	stmt << "login %s; signp7 %s 1";
+	stmt, "0000", "inv1", batch, "0000", "inv2", batch, "0000", "inv3";
+	assert (stmt.execute() == 6);
+	assert (stmt.results().empty());
+	assert (stmt.batchResults().size() == 3);
+	assert (stmt.batchResults()[0][0] == "1");
+	assert (stmt.batchResults()[1][1] == "p7:inv2");
+	assert (stmt.batchResults()[2][1] == "p7:inv3");
+	assert (Poco::AnyCast<int>(sess.getProperty("logins")) == logins + 1);
+	assert (!sess.isTransaction());
+
+	// the batch is bound until other values are supplied
+	assert (stmt.execute() == 6);
+	assert (stmt.batchResults().size() == 3);
+	stmt, "0000", "single";
+	assert (stmt.execute() == 2);
+	assert (stmt.batchResults().empty());
+	assert (stmt.results()[1] == "p7:single");
+
+	// a failing argument set ends the batch, the device is released
+	Statement failing(sess);
+	failing << "signp7 %s %s";
+	failing, "a", "1", batch, "b", "x";
+	try
+	{
+		failing.execute();
+		fail ("must fail");
+	}
+	catch (Poco::SyntaxException&) { }
+	assert (failing.batchResults().size() == 2);
+	assert (failing.batchResults()[0][0] == "p7:a");
+	assert (!sess.isTransaction());
+
+	// within a transaction, the batch joins it
+	Transaction trans(sess);
+	Statement joined(sess);
+	joined << "signp7 %s 1", "x", batch, "y", batch;
+	assert (joined.execute() == 2);
+	assert (sess.isTransaction());
+	trans.commit();
+
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session queued(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	queued.setFeature("bulk", true);
+	Statement remote(queued);
+	remote << "signp7 %s 1", "q1", batch, "q2", batch, "q3";
+	assert (remote.execute() == 3);
+	assert (remote.batchResults()[2][0] == "p7:q3");
+	assert (!queued.isTransaction());
+}
+
+
+void DataTest::testTypedBinding()
+{
+	Session sess(SessionFactory::instance().create("test", "cs"));
+
+	// bound variables are read on every execution
+	std::string pin("0000");
+	std::string text("inv1");
+	int mode = 1;
+	bool loggedIn = false;
+	std::string signature;
+	Statement stmt(sess);
+	stmt << "login %s; signp7 '%s' %d", use(pin), use(text), use(mode), into(loggedIn), into(signature);
+	assert (stmt.execute() == 2);
+	assert (loggedIn);
+	assert (signature == "p7:inv1");
+
+	text = "inv2";
+	loggedIn = false;
+	assert (stmt.execute() == 2);
+	assert (loggedIn);
+	assert (signature == "p7:inv2");
+
+	text = "a b";
+	stmt.execute();
+	assert (signature == "p7:a b");
+	assert (stmt.results()[1] == "p7:a b");
+
+	// a vector receives all remaining rows
+	std::vector<std::string> rows;
+	text = "inv3";
+	Statement all(sess);
+	all << "signp7 %s 1; serial", use(text), into(rows), now;
+	assert (rows.size() == 2);
+	assert (rows[1] == "serial");
+
+	Statement missing(sess);
+	missing << "serial", into(signature), into(text);
+	try
+	{
+		missing.execute();
+		fail ("must fail");
+	}
+	catch (RangeException&) { }
+
+	Statement mixed(sess);
+	mixed << "signp7 %s %s", use(text), "1";
+	try
+	{
+		mixed.execute();
+		fail ("must fail");
+	}
+	catch (InvalidAccessException&) { }
+}
+
+
+void DataTest::testCancellation()
+{
+	StatementExecutor::Ptr pExecutor = new StatementExecutor(1, "CancelExecutor");
+	SessionFactory::instance().setExecutor("test", pExecutor);
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutor("test", StatementExecutor::Ptr());
+
+	// a passed deadline fails the execution before the first operation
+	Statement late(sess);
+	late << "sign a";
+	late.setDeadline(Poco::Timestamp());
+	try
+	{
+		late.execute();
+		fail ("must fail");
+	}
+	catch (DeadlineExceededException&) { }
+	assert (late.results().empty());
+
+	// a cancelled statement waiting for the executor never runs
+	Poco::Event release;
+	pExecutor->submit<void>([&]() { release.wait(); });
+	Statement queued = (sess << "sign b");
+	queued.executeAsync();
+	queued.cancel();
+	release.set();
+	try
+	{
+		queued.wait();
+		fail ("must fail");
+	}
+	catch (OperationCancelledException&) { }
+	assert (queued.results().empty());
+
+	// a token shared by the statements of a client
+	CancellationToken::Ptr pToken = new CancellationToken;
+	Statement shared(sess);
+	shared << "serial";
+	shared.setCancellation(pToken);
+	assert (shared.execute() == 1);
+	pToken->cancel("client disconnected");
+	try
+	{
+		shared.execute();
+		fail ("must fail");
+	}
+	catch (OperationCancelledException&) { }
+
+	// device work submitted under a cancelled token is dropped
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session device(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	assert (device.impl()->getSerialNumber() == "serial");
+	CancellationToken::Scope scope(pToken);
+	try
+	{
+		device.impl()->getSerialNumber();
+		fail ("must fail");
+	}
+	catch (OperationCancelledException&) { }
+}
+
+
+void DataTest::testAsyncSession()
+{
+	// direct sessions run the operations on their executor
+	Session direct(SessionFactory::instance().create("test", "cs"));
+	Session::StringResult signature = direct.signByP1Async("msg");
+	assert (DeviceWorker::await(signature) == "p1:msg");
+	assert (DeviceWorker::await(direct.verifySignByP1Async("cert", "msg", "p1:msg")));
+
+	// queued sessions complete on the device worker
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session queued(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	QueuedSessionImpl* pQueued = dynamic_cast<QueuedSessionImpl*>(queued.impl());
+	assert (pQueued);
+
+	Poco::Event done;
+	std::string result;
+	std::atomic<bool> onWorker(false);
+	queued.signByP7Async("text", 1, [&](const Session::StringResult& r)
+	{
+		onWorker = pQueued->worker().isWorkerThread();
+		result = r.data();
+		done.set();
+	});
+	done.wait();
+	assert (onWorker);
+	assert (result == "p7:text");
+
+	// balanced sessions count operations as outstanding until they complete
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_BALANCED);
+	Session balanced(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	BalancedSessionImpl* pBalanced = dynamic_cast<BalancedSessionImpl*>(balanced.impl());
+	assert (pBalanced);
+
+	std::atomic<int> completed(0);
+	Poco::Event all;
+	for (int i = 0; i < 10; ++i)
+	{
+		balanced.signByP1Async("message", [&](const Session::StringResult& r)
+		{
+			if (r.data() == "p1:message" && ++completed == 10) all.set();
+		});
+	}
+	all.wait();
+	assert (pBalanced->outstanding(0) == 0);
+	assert (pBalanced->outstanding(1) == 0);
+}
+
+
+void DataTest::testAwaitable()
+{
+#if defined(RDATA_HAVE_COROUTINES)
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+
+	StatementExecutor::Ptr pExecutor = new StatementExecutor(1, "AwaitableTest");
+	Poco::ActiveResult<std::string> result = Reach::Data::spawn(signTwice(AwaitableSession(sess, pExecutor), "text"));
+	result.wait();
+	assert (!result.failed());
+	assert (result.data() == "p7:p1:text");
+
+	// a cancelled task does not start its device operations
+	CancellationToken::Ptr pToken = new CancellationToken;
+	pToken->cancel("client gone");
+	Task<std::string> task = signTwice(AwaitableSession(sess), "text");
+	task.setCancellation(pToken);
+	result = Reach::Data::spawn(std::move(task));
+	result.wait();
+	assert (result.failed());
+	try
+	{
+		result.exception()->rethrow();
+		fail("must throw");
+	}
+	catch (OperationCancelledException&)
+	{
+	}
+	pExecutor->stop();
+#endif
+}
+
+
+void DataTest::testCompletionQueue()
+{
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+
+	CompletionQueue::Ptr pQueue = new CompletionQueue;
+#if defined(POCO_OS_FAMILY_UNIX)
+	assert (pQueue->descriptor() >= 0);
+#endif
+
+	const Poco::UInt64 count = 20;
+	for (Poco::UInt64 i = 0; i < count; ++i)
+	{
+		sess.signByP1Async(Poco::NumberFormatter::format(i), pQueue->callback<std::string>(i));
+	}
+	sess.loginAsync("wrong", pQueue->callback<bool>(count));
+
+	std::set<Poco::UInt64> tags;
+	CompletionQueue::Completions completions;
+	while (tags.size() < count + 1)
+	{
+		assert (pQueue->wait(5000));
+		while (pQueue->drain(completions, 8))
+		{
+			assert (completions.size() <= 8);
+			for (CompletionQueue::Completions::const_iterator it = completions.begin(); it != completions.end(); ++it)
+			{
+				tags.insert(it->tag());
+				if (it->tag() == count)
+				{
+					assert (!it->value<bool>());
+					continue;
+				}
+				assert (!it->failed());
+				assert (it->value<std::string>() == "p1:" + Poco::NumberFormatter::format(it->tag()));
+				try
+				{
+					it->value<bool>();
+					fail("must throw");
+				}
+				catch (Poco::BadCastException&)
+				{
+				}
+			}
+		}
+	}
+	assert (pQueue->size() == 0);
+	assert (!pQueue->wait(10));
+}
+
+
+void DataTest::testDeviceScheduling()
+{
+	DeviceWorker::Ptr pWorker = new DeviceWorker("scheduled");
+	pWorker->setStarvationLimit(4);
+	pWorker->setLatencyTarget(DeviceJob::PRIO_INTERACTIVE, Poco::Timespan(60, 0));
+
+	Poco::FastMutex mutex;
+	std::vector<std::string> order;
+	std::vector<Poco::ActiveResult<void> > results;
+	auto job = [&](const std::string& name)
+	{
+		return pWorker->submit<void>([&mutex, &order, name]()
+		{
+			Poco::FastMutex::ScopedLock lock(mutex);
+			order.push_back(name);
+		});
+	};
+
+	// park the worker while the queue fills up
+	DeviceHold::Ptr pHold = pWorker->hold();
+	{
+		DeviceJob::PriorityScope scope(DeviceJob::PRIO_BULK);
+		for (int i = 0; i < 10; ++i) results.push_back(job("bulk"));
+	}
+	{
+		DeviceJob::PriorityScope scope(DeviceJob::PRIO_INTERACTIVE);
+		for (int i = 0; i < 8; ++i) results.push_back(job("interactive"));
+
+		CancellationToken::Ptr pToken = new CancellationToken;
+		pToken->setTimeout(Poco::Timespan(10, 0));
+		CancellationToken::Scope tokenScope(pToken);
+		results.push_back(job("urgent"));
+	}
+	assert (pWorker->pending(DeviceJob::PRIO_BULK) == 10);
+	assert (pWorker->pending(DeviceJob::PRIO_INTERACTIVE) == 9);
+	assert (pWorker->pending(DeviceJob::PRIO_NORMAL) == 0);
+
+	pHold->end();
+	for (std::vector<Poco::ActiveResult<void> >::iterator it = results.begin(); it != results.end(); ++it)
+		DeviceWorker::await(*it);
+
+	// the job with the earliest deadline goes first, and interactive jobs
+	// overtake bulk jobs, but a bulk job runs after every four of them
+	const char* expected[] = { "urgent", "interactive", "interactive", "interactive", "bulk",
+		"interactive", "interactive", "interactive", "interactive", "bulk", "interactive" };
+	const std::size_t count = sizeof(expected)/sizeof(expected[0]);
+	assert (order.size() == 19);
+	for (std::size_t i = 0; i < count; ++i) assert (order[i] == expected[i]);
+	for (std::size_t i = count; i < order.size(); ++i) assert (order[i] == "bulk");
+	assert (pWorker->pending(DeviceJob::PRIO_BULK) == 0);
+	assert (pWorker->pending(DeviceJob::PRIO_INTERACTIVE) == 0);
+
+	// jobs submitted by a running job inherit its priority
+	DeviceJob::Priority priority = DeviceJob::PRIO_NORMAL;
+	{
+		DeviceJob::PriorityScope scope(DeviceJob::PRIO_BULK);
+		DeviceWorker::await(pWorker->submit<void>([&]() { priority = DeviceJob::currentPriority(); }));
+	}
+	assert (priority == DeviceJob::PRIO_BULK);
+	assert (DeviceJob::currentPriority() == DeviceJob::PRIO_NORMAL);
+}
+
+
+void DataTest::testBatchSigning()
+{
+	std::vector<std::string> messages;
+	messages.push_back("first");
+	messages.push_back("second");
+	messages.push_back("third");
+
+	Session direct(SessionFactory::instance().create("test", "cs"));
+	Session::BatchResults results = direct.signBatchP1(messages);
+	assert (results.size() == 3);
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		assert (!results[i].failed);
+		assert (results[i].value == "p1:" + messages[i]);
+	}
+
+	results = direct.signBatchP7(messages, 1);
+	assert (results.size() == 3);
+	assert (results[1].value == "p7:second");
+
+	// queued sessions run the whole batch as one job
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session queued(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	results = queued.signBatchP1(messages);
+	assert (results.size() == 3);
+	assert (results[2].value == "p1:third");
+
+	// a cancelled batch records the failure for each item
+	CancellationToken::Ptr pToken = new CancellationToken;
+	pToken->cancel("stopped");
+	{
+		CancellationToken::Scope scope(pToken);
+		results = direct.signBatchP1(messages);
+	}
+	assert (results.size() == 3);
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		assert (results[i].failed);
+		assert (results[i].value.empty());
+		assert (!results[i].message.empty());
+	}
+}
+
+
+void DataTest::testSignatureVerifier()
+{
+	SignatureVerifier::Ptr pSM2 = new SignatureVerifier(SignatureVerifier::ALG_SM3_SM2);
+	assert (pSM2->verify(sm2Cert, "message", sm2Signature));
+	assert (pSM2->verify(sm2Cert, "message", sm2RawSignature));
+	assert (!pSM2->verify(sm2Cert, "tampered", sm2Signature));
+	try
+	{
+		pSM2->verify(rsaCert, "message", rsaSignature);
+		fail ("RSA certificate must not verify SM2 signatures");
+	}
+	catch (NotSupportedException&) { }
+
+	SignatureVerifier::Ptr pRSA = new SignatureVerifier(SignatureVerifier::ALG_SHA256_RSA);
+	assert (pRSA->verify(rsaCert, "message", rsaSignature));
+	assert (!pRSA->verify(rsaCert, "tampered", rsaSignature));
+	try
+	{
+		pRSA->verify(rsaCert, "message", "!not base64!");
+		fail ("malformed signature must fail");
+	}
+	catch (Poco::DataFormatException&) { }
+
+	// batches are spread over the executor and keep their order
+	StatementExecutor::Ptr pExecutor = new StatementExecutor(4, "VerifierTest");
+	pSM2 = new SignatureVerifier(SignatureVerifier::ALG_SM3_SM2, pExecutor);
+	SignatureVerifier::Requests requests;
+	for (int i = 0; i < 200; ++i)
+	{
+		requests.push_back(SignatureVerifier::Request(
+			i % 10 == 7 ? std::string("bm8gY2VydA==") : sm2Cert,
+			i % 3 == 0 ? "tampered" : "message",
+			sm2Signature));
+	}
+	SignatureVerifier::Results results = pSM2->verifyBatch(requests);
+	assert (results.size() == requests.size());
+	for (int i = 0; i < 200; ++i)
+	{
+		if (i % 10 == 7)
+		{
+			assert (!results[i].valid);
+			assert (!results[i].error.empty());
+		}
+		else
+		{
+			assert (results[i].error.empty());
+			assert (results[i].valid == (i % 3 != 0));
+		}
+	}
+	pExecutor->stop();
+}
+
+
+void DataTest::testMessageDigest()
+{
+	// SHA-1 test vector of FIPS 180
+	MessageDigest sha1(SignatureVerifier::ALG_SHA1_RSA);
+	sha1.update("a");
+	sha1.update("bc");
+	std::string digest = sha1.digest();
+	assert (digest.size() == 20);
+	assert (digest == std::string("\xa9\x99\x3e\x36\x47\x06\x81\x6a\xba\x3e\x25\x71\x78\x50\xc2\x6c\x9c\xd0\xd8\x9d", 20));
+
+	// digest() starts the next message
+	sha1.update("abc");
+	assert (sha1.digest() == digest);
+
+	// SM2 digests include Z of the signer's certificate
+	try
+	{
+		MessageDigest sm3(SignatureVerifier::ALG_SM3_SM2);
+		fail ("must fail");
+	}
+	catch (InvalidArgumentException&) { }
+
+	MessageDigest sm3(SignatureVerifier::ALG_SM3_SM2, sm2Cert);
+	sm3.update("message");
+	assert (sm3.digest() == std::string(
+		"\x23\xc9\x96\x1d\xb2\x26\x34\x9a\x60\x02\x09\xcc\x8c\xc2\x2c\xfc"
+		"\x49\x34\x12\xdd\x93\xce\x7e\xa4\xcc\xed\x12\xe2\x40\xba\x5d\x22", 32));
+
+	try
+	{
+		MessageDigest rsa(SignatureVerifier::ALG_SM3_SM2, rsaCert);
+		fail ("must fail");
+	}
+	catch (NotSupportedException&) { }
+
+	// only the digest goes to the session
+	Session direct(SessionFactory::instance().create("test", "cs"));
+	assert (direct.getFeature("digest"));
+	try
+	{
+		direct.setFeature("digest", false);
+		fail ("must fail");
+	}
+	catch (NotImplementedException&) { }
+	assert (direct.signDigest(digest) == "digest:" + digest);
+
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session queued(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	assert (queued.signDigest(digest) == "digest:" + digest);
+}
+
+
+void DataTest::testFileSigning()
+{
+	Poco::TemporaryFile file;
+	{
+		Poco::FileOutputStream ostr(file.path());
+		ostr << "message";
+	}
+	Poco::TemporaryFile large;
+	{
+		// larger than a read chunk
+		Poco::FileOutputStream ostr(large.path());
+		std::string block(1000, 'x');
+		for (int i = 0; i < 3000; ++i) ostr << block;
+	}
+
+	MessageDigest digest(SignatureVerifier::ALG_SM3_SM2, sm2Cert);
+	digest.updateFile(large.path());
+	std::string fileDigest = digest.digest();
+	for (int i = 0; i < 3000; ++i) digest.update(std::string(1000, 'x'));
+	assert (digest.digest() == fileDigest);
+
+	// the test connector signs the digest computed on the host
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	sess.setProperty("certificate", sm2Cert);
+	assert (sess.signFile(large.path()) == "digest:" + fileDigest);
+
+	assert (sess.verifyFile(sm2Cert, file.path(), sm2Signature));
+	assert (!sess.verifyFile(sm2Cert, large.path(), sm2Signature));
+	assert (sess.verifyFile(rsaCert, file.path(), rsaSignature));
+
+	try
+	{
+		sess.signFile(file.path() + ".missing");
+		fail ("must fail");
+	}
+	catch (Poco::FileException&) { }
+
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_QUEUED);
+	Session queued(SessionFactory::instance().create("test", "cs"));
+	SessionFactory::instance().setExecutionMode("test", SessionFactory::EXEC_DIRECT);
+	queued.setProperty("certificate", sm2Cert);
+	assert (queued.signFile(large.path()) == "digest:" + fileDigest);
+}
+
+
+void DataTest::testFileEncryption()
+{
+	std::string content;
+	for (int i = 0; content.size() < 300000; ++i) content += Poco::NumberFormatter::format(i) + ' ';
+
+	Poco::TemporaryFile plain;
+	Poco::TemporaryFile encrypted;
+	Poco::TemporaryFile decrypted;
+	{
+		Poco::FileOutputStream ostr(plain.path());
+		ostr << content;
+	}
+
+	// small chunks, so the file has many frames
+	StatementExecutor::Ptr pExecutor = new StatementExecutor(4, "CipherTest");
+	std::string key = FileCipher::generateKey();
+	FileCipher cipher(key, pExecutor);
+	cipher.setChunkSize(4096);
+	cipher.encryptFile(plain.path(), encrypted.path(), "key info");
+	assert (FileCipher::keyInfo(encrypted.path()) == "key info");
+	assert (FileCipher::plainSize(encrypted.path()) == content.size());
+
+	cipher.decryptFile(encrypted.path(), decrypted.path());
+	{
+		Poco::FileInputStream istr(decrypted.path());
+		assert (std::string(std::istreambuf_iterator<char>(istr), std::istreambuf_iterator<char>()) == content);
+	}
+
+	// any range decrypts on its own
+	assert (cipher.decryptRange(encrypted.path(), 0, 10) == content.substr(0, 10));
+	assert (cipher.decryptRange(encrypted.path(), 4090, 10000) == content.substr(4090, 10000));
+	assert (cipher.decryptRange(encrypted.path(), content.size() - 5, 100) == content.substr(content.size() - 5));
+	assert (cipher.decryptRange(encrypted.path(), content.size(), 100).empty());
+
+	// a frame that has been changed is rejected
+	{
+		Poco::FileStream fstr(encrypted.path());
+		fstr.seekg(100);
+		char c = static_cast<char>(fstr.get());
+		fstr.seekp(100);
+		fstr.put(static_cast<char>(~c));
+	}
+	try
+	{
+		cipher.decryptFile(encrypted.path(), decrypted.path());
+		fail ("must fail");
+	}
+	catch (Poco::DataFormatException&) { }
+
+	try
+	{
+		cipher.decryptFile(plain.path(), decrypted.path());
+		fail ("must fail");
+	}
+	catch (Poco::DataFormatException&) { }
+	pExecutor->stop();
+
+	// sessions protect the file key with the device
+	Session sess(SessionFactory::instance().create("test", "cs"));
+	sess.encryptFile(plain.path(), encrypted.path());
+	assert (FileCipher::keyInfo(encrypted.path()).substr(0, 4) == "enc:");
+	sess.decryptFile(encrypted.path(), decrypted.path());
+	{
+		Poco::FileInputStream istr(decrypted.path());
+		assert (std::string(std::istreambuf_iterator<char>(istr), std::istreambuf_iterator<char>()) == content);
+	}
+}
+
+
 void DataTest::setUp()
 {
 }
@@ -125,6 +1518,30 @@ CppUnit::Test* DataTest::suite()
 	CppUnit_addTest(pSuite, DataTest, testStatementFormatting);
 	CppUnit_addTest(pSuite, DataTest, testFeatures);
 	CppUnit_addTest(pSuite, DataTest, testProperties);
+	CppUnit_addTest(pSuite, DataTest, testDeviceWorker);
+	CppUnit_addTest(pSuite, DataTest, testQueuedSession);
+	CppUnit_addTest(pSuite, DataTest, testBalancedSession);
+	CppUnit_addTest(pSuite, DataTest, testDeviceMonitor);
+	CppUnit_addTest(pSuite, DataTest, testSessionContainer);
+	CppUnit_addTest(pSuite, DataTest, testLoginState);
+	CppUnit_addTest(pSuite, DataTest, testTransaction);
+	CppUnit_addTest(pSuite, DataTest, testStatementExecution);
+	CppUnit_addTest(pSuite, DataTest, testStatementTemplate);
+	CppUnit_addTest(pSuite, DataTest, testStatementExecutor);
+	CppUnit_addTest(pSuite, DataTest, testBatchExecution);
+	CppUnit_addTest(pSuite, DataTest, testTypedBinding);
+	CppUnit_addTest(pSuite, DataTest, testCancellation);
+	CppUnit_addTest(pSuite, DataTest, testAsyncSession);
+	CppUnit_addTest(pSuite, DataTest, testAwaitable);
+	CppUnit_addTest(pSuite, DataTest, testCompletionQueue);
+	CppUnit_addTest(pSuite, DataTest, testDeviceScheduling);
+	CppUnit_addTest(pSuite, DataTest, testBatchSigning);
+	CppUnit_addTest(pSuite, DataTest, testSignatureVerifier);
+	CppUnit_addTest(pSuite, DataTest, testMessageDigest);
+	CppUnit_addTest(pSuite, DataTest, testFileSigning);
+	CppUnit_addTest(pSuite, DataTest, testFileEncryption);
+	CppUnit_addTest(pSuite, DataTest, testWarmUp);
+	CppUnit_addTest(pSuite, DataTest, testLiveness);
 
 	return pSuite;
 }
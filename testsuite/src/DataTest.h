@@ -30,6 +30,30 @@ public:
 	void testStatementFormatting();
 	void testFeatures();
 	void testProperties();
+	void testDeviceWorker();
+	void testQueuedSession();
+	void testBalancedSession();
+	void testDeviceMonitor();
+	void testSessionContainer();
+	void testLoginState();
+	void testTransaction();
+	void testStatementExecution();
+	void testStatementTemplate();
+	void testStatementExecutor();
+	void testBatchExecution();
+	void testTypedBinding();
+	void testCancellation();
+	void testAsyncSession();
+	void testAwaitable();
+	void testCompletionQueue();
+	void testDeviceScheduling();
+	void testBatchSigning();
+	void testSignatureVerifier();
+	void testMessageDigest();
+	void testFileSigning();
+	void testFileEncryption();
+	void testWarmUp();
+	void testLiveness();
 	
 	void setUp();
 	void tearDown();
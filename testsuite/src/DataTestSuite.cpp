@@ -9,8 +9,8 @@
 
 
 #include "DataTestSuite.h"
-// #include "DataTest.h"
-// #include "SessionPoolTest.h"
+#include "DataTest.h"
+#include "SessionPoolTest.h"
 #include "WebSocketTest.h"
 
 
@@ -18,8 +18,8 @@ CppUnit::Test* DataTestSuite::suite()
 {
 	CppUnit::TestSuite* pSuite = new CppUnit::TestSuite("DataTestSuite");
 
-	//pSuite->addTest(DataTest::suite());
-	//pSuite->addTest(SessionPoolTest::suite());
+	pSuite->addTest(DataTest::suite());
+	pSuite->addTest(SessionPoolTest::suite());
 	pSuite->addTest(WebSocketTest::suite());
 
 	return pSuite;
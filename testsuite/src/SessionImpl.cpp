@@ -21,7 +21,8 @@ namespace Test {
 SessionImpl::SessionImpl(const std::string& init, std::size_t timeout):
 	Reach::Data::AbstractSessionImpl<SessionImpl>(init, timeout),
 	_f(false),
-	_connected(true)
+	_connected(true),
+	_logins(0)
 {
 	addFeature("f1", &SessionImpl::setF, &SessionImpl::getF);
 	addFeature("f2", 0, &SessionImpl::getF);
@@ -30,6 +31,9 @@ SessionImpl::SessionImpl(const std::string& init, std::size_t timeout):
 	addProperty("p1", &SessionImpl::setP, &SessionImpl::getP);
 	addProperty("p2", 0, &SessionImpl::getP);
 	addProperty("p3", &SessionImpl::setP, &SessionImpl::getP);
+	addProperty("logins", 0, &SessionImpl::getLogins);
+	addProperty("certificate", &SessionImpl::setCertificate, &SessionImpl::getCertificate);
+	setDigestSupport(true);
 }
 
 
@@ -41,12 +45,14 @@ SessionImpl::~SessionImpl()
 void SessionImpl::open(const std::string& connectionString)
 {
 	_connected = true;
+	setLoggedIn(false);
 }
 
 
 void SessionImpl::close()
 {
 	_connected = false;
+	setLoggedIn(false);
 }
 
 
@@ -73,33 +79,6 @@ std::size_t SessionImpl::getConnectionTimeout()
 //}
 
 
-void SessionImpl::begin()
-{
-}
-
-
-void SessionImpl::commit()
-{
-}
-
-
-void SessionImpl::rollback()
-{
-}
-
-
-bool SessionImpl::canTransact()
-{
-	return false;
-}
-
-
-bool SessionImpl::isTransaction()
-{
-	return false;
-}
-
-
 void SessionImpl::setTransactionIsolation(Poco::UInt32)
 {
 }
@@ -164,6 +143,24 @@ Poco::Any SessionImpl::getP(const std::string& name)
 	return _p;
 }
 
+
+Poco::Any SessionImpl::getLogins(const std::string& name)
+{
+	return _logins;
+}
+
+
+void SessionImpl::setCertificate(const std::string& name, const Poco::Any& value)
+{
+	_certificate = Poco::RefAnyCast<std::string>(value);
+}
+
+
+Poco::Any SessionImpl::getCertificate(const std::string& name)
+{
+	return _certificate;
+}
+
 const std::string& SessionImpl::contianerName() const 
 {
 	return "";
@@ -171,7 +168,10 @@ const std::string& SessionImpl::contianerName() const
 
 bool SessionImpl::login(const std::string& passwd) 
 {
-	return false;
+	++_logins;
+	bool rc = (passwd == "0000");
+	setLoggedIn(rc);
+	return rc;
 }
 
 bool SessionImpl::changePW(const std::string& oldCode, const std::string& newCode) 
@@ -186,7 +186,7 @@ std::string SessionImpl::getUserList()
 
 std::string SessionImpl::getCertBase64String(short ctype) 
 {
-	return "";
+	return _certificate;
 }
 
 int SessionImpl::getPinRetryCount() 
@@ -199,20 +199,25 @@ std::string SessionImpl::getCertInfo(const std::string& base64, int type)
 	return "";
 }
 
-std::string SessionImpl::getSerialNumber() { return ""; }
+std::string SessionImpl::getSerialNumber() { return "serial"; }
 
 std::string SessionImpl::getKeyID() { return ""; }
 
-std::string SessionImpl::encryptData(const std::string& paintText, const std::string& base64) { return ""; }
+// the crypto operations are reversible stand-ins, so that
+// callers can check what has been executed
+
+std::string SessionImpl::encryptData(const std::string& paintText, const std::string& base64) { return "enc:" + paintText; }
+
+std::string SessionImpl::decryptData(const std::string& encryptBuffer) { return encryptBuffer.size() < 4 ? "" : encryptBuffer.substr(4); }
 
-std::string SessionImpl::decryptData(const std::string& encryptBuffer) { return ""; }
+std::string SessionImpl::signByP1(const std::string& message) { return "p1:" + message; }
 
-std::string SessionImpl::signByP1(const std::string& message) { return ""; }
+bool SessionImpl::verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature) { return signature == "p1:" + msg; }
 
-bool SessionImpl::verifySignByP1(const std::string& base64, const std::string& msg, const std::string& signature) { return false; }
+std::string SessionImpl::signByP7(const std::string& textual, int mode) { return "p7:" + textual; }
 
-std::string SessionImpl::signByP7(const std::string& textual, int mode) { return ""; }
+bool SessionImpl::verifySignByP7(const std::string& textual, const std::string& signature) { return signature == "p7:" + textual; }
 
-bool SessionImpl::verifySignByP7(const std::string& textual, const std::string& signature) { return false; }
+std::string SessionImpl::signDigest(const std::string& digest) { return "digest:" + digest; }
 
 } } } // namespace Poco::Data::Test
@@ -54,21 +54,6 @@ public:
 	std::size_t getConnectionTimeout();
 		/// Returns the session connection timeout value.
 
-	void begin();
-		/// Starts a transaction.
-
-	void commit();
-		/// Commits and ends a transaction.
-
-	void rollback();
-		/// Aborts a transaction.
-
-	bool canTransact();
-		/// Returns true if session has transaction capabilities.
-
-	bool isTransaction();
-		/// Returns true iff a transaction is a transaction is in progress, false otherwise.
-
 	void setTransactionIsolation(Poco::UInt32);
 		/// Sets the transaction isolation level.
 
@@ -122,16 +107,25 @@ public:
 
 	virtual bool verifySignByP7(const std::string& textual, const std::string& signature) ;
 
+	virtual std::string signDigest(const std::string& digest) ;
+
 	void setF(const std::string& name, bool value);
 	bool getF(const std::string& name);
 	void setP(const std::string& name, const Poco::Any& value);
 	Poco::Any getP(const std::string& name);
+	Poco::Any getLogins(const std::string& name);
+		/// Returns the number of PIN verifications.
+	void setCertificate(const std::string& name, const Poco::Any& value);
+	Poco::Any getCertificate(const std::string& name);
+		/// The certificate returned by getCertBase64String().
 
 private:
 	bool         _f;
 	Poco::Any    _p;
 	bool         _connected;
+	int          _logins;
 	std::string  _connectionString;
+	std::string  _certificate;
 };
 
 
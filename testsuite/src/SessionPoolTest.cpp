@@ -11,36 +11,36 @@
 #include "SessionPoolTest.h"
 #include "CppUnit/TestCaller.h"
 #include "CppUnit/TestSuite.h"
-#include "Poco/Data/SessionPool.h"
-#include "Poco/Data/SessionPoolContainer.h"
+#include "Reach/Data/SessionPool.h"
+#include "Reach/Data/SessionPoolContainer.h"
+#include "Reach/Data/DataException.h"
 #include "Poco/Thread.h"
 #include "Poco/AutoPtr.h"
 #include "Poco/Exception.h"
 #include "Connector.h"
 
 
-using namespace Poco::Data::Keywords;
 using Poco::Thread;
 using Poco::AutoPtr;
 using Poco::NotFoundException;
 using Poco::InvalidAccessException;
-using Poco::Data::Session;
-using Poco::Data::SessionPool;
-using Poco::Data::SessionPoolContainer;
-using Poco::Data::SessionPoolExhaustedException;
-using Poco::Data::SessionPoolExistsException;
-using Poco::Data::SessionUnavailableException;
+using Reach::Data::Session;
+using Reach::Data::SessionPool;
+using Reach::Data::SessionPoolContainer;
+using Reach::Data::SessionPoolExhaustedException;
+using Reach::Data::SessionPoolExistsException;
+using Reach::Data::SessionUnavailableException;
 
 
 SessionPoolTest::SessionPoolTest(const std::string& name): CppUnit::TestCase(name)
 {
-	Poco::Data::Test::Connector::addToFactory();
+	Reach::Data::Test::Connector::addToFactory();
 }
 
 
 SessionPoolTest::~SessionPoolTest()
 {
-	Poco::Data::Test::Connector::removeFromFactory();
+	Reach::Data::Test::Connector::removeFromFactory();
 }
 
 
@@ -59,8 +59,9 @@ void SessionPoolTest::testSessionPool()
 	catch ( Poco::NotFoundException& ) { }
 
 	assert (pool.capacity() == 4);
-	assert (pool.allocated() == 0);
-	assert (pool.idle() == 0);
+	// minSessions are opened by the constructor
+	assert (pool.allocated() == 1);
+	assert (pool.idle() == 1);
 	assert (pool.available() == 4);
 	assert (pool.dead() == 0);
 	assert (pool.allocated() == pool.used() + pool.idle());
@@ -139,6 +140,13 @@ void SessionPoolTest::testSessionPool()
 		fail("pool exhausted - must throw");
 	}
 	catch (SessionPoolExhaustedException&) { }
+
+	try
+	{
+		Session s6(pool.get(100));
+		fail("pool exhausted after waiting - must throw");
+	}
+	catch (SessionPoolExhaustedException&) { }
 	
 	s5.close();
 	assert (pool.capacity() == 4);
@@ -150,7 +158,7 @@ void SessionPoolTest::testSessionPool()
 
 	try
 	{
-		s5 << "DROP TABLE IF EXISTS Test", now;
+		s5.getUserList();
 		fail("session unusable - must throw");
 	}
 	catch (SessionUnavailableException&) { }
@@ -222,7 +230,7 @@ void SessionPoolTest::testSessionPoolContainer()
 	assert (spc.has("test:///cs"));
 	assert (1 == spc.count());
 
-	Poco::Data::Session sess = spc.get("test:///cs");
+	Reach::Data::Session sess = spc.get("test:///cs");
 	assert ("test" == sess.impl()->connectorName());
 	assert ("Cs" == sess.impl()->connectionString());
 	assert ("test:///Cs" == sess.uri());
@@ -14,7 +14,7 @@
 #define SessionPoolTest_INCLUDED
 
 
-#include "Data.h"
+#include "Reach/Data/Data.h"
 #include "CppUnit/TestCase.h"
 
 